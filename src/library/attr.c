@@ -0,0 +1,246 @@
+#include "attr.h"
+#include "gl.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+enum AttrType {
+    ATTR_FLOAT,
+    ATTR_UBYTE,
+    ATTR_BYTE,
+    ATTR_USHORT,
+    ATTR_SHORT,
+    ATTR_UINT,
+    ATTR_INT,
+    ATTR_TYPE_COUNT,
+};
+
+static const size_t attr_type_sizes[ATTR_TYPE_COUNT] = {4, 1, 1, 2, 2, 4, 4};
+
+// normalised values are scaled into [0, 1] for unsigned types, and [-1, 1] for signed ones, using the (2c + 1) / (2^b - 1)
+// mapping from before GL 4.2, so that the maximum and minimum both land exactly on the ends of the range
+static const float attr_norm_scales[ATTR_TYPE_COUNT] = {1.0f, 1.0f / 255.0f, 2.0f / 255.0f, 1.0f / 65535.0f, 2.0f / 65535.0f, 1.0f / 4294967295.0f, 2.0f / 4294967295.0f};
+static const float attr_norm_biases[ATTR_TYPE_COUNT] = {0.0f, 0.0f, 1.0f / 255.0f, 0.0f, 1.0f / 65535.0f, 0.0f, 1.0f / 4294967295.0f};
+
+static int _bolt_attr_type(uint32_t type) {
+    switch (type) {
+        case GL_FLOAT: return ATTR_FLOAT;
+        case GL_UNSIGNED_BYTE: return ATTR_UBYTE;
+        case GL_BYTE: return ATTR_BYTE;
+        case GL_UNSIGNED_SHORT: return ATTR_USHORT;
+        case GL_SHORT: return ATTR_SHORT;
+        case GL_UNSIGNED_INT: return ATTR_UINT;
+        case GL_INT: return ATTR_INT;
+        default: return -1;
+    }
+}
+
+void _bolt_index_range(const uint16_t* indices, size_t count, uint16_t* min, uint16_t* max) {
+    uint16_t lo = UINT16_MAX;
+    uint16_t hi = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    if (count >= 8) {
+        // SSE2 only has signed 16-bit min and max, so the indices are flipped into signed order and back again
+        const __m128i flip = _mm_set1_epi16((short)0x8000);
+        __m128i vmin = _mm_set1_epi16(0x7FFF);
+        __m128i vmax = _mm_set1_epi16((short)0x8000);
+        for (; i + 8 <= count; i += 8) {
+            const __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(indices + i)), flip);
+            vmin = _mm_min_epi16(vmin, v);
+            vmax = _mm_max_epi16(vmax, v);
+        }
+        uint16_t mins[8];
+        uint16_t maxs[8];
+        _mm_storeu_si128((__m128i*)mins, _mm_xor_si128(vmin, flip));
+        _mm_storeu_si128((__m128i*)maxs, _mm_xor_si128(vmax, flip));
+        for (size_t j = 0; j < 8; j += 1) {
+            if (mins[j] < lo) lo = mins[j];
+            if (maxs[j] > hi) hi = maxs[j];
+        }
+    }
+#endif
+    for (; i < count; i += 1) {
+        if (indices[i] < lo) lo = indices[i];
+        if (indices[i] > hi) hi = indices[i];
+    }
+    *min = lo;
+    *max = hi;
+}
+
+typedef void (*AttrKernel)(const uint8_t* base, size_t stride, const uint16_t* indices, size_t first, size_t count, float scale, float bias, float* out);
+
+// the functions below are only ever called with a constant type and component count, so after inlining, each kernel
+// is left with the one load and conversion it needs
+#if defined(__SSE2__)
+// loads `size` bytes (4, 8, 12 or 16, or anything less than 8) into the bottom of a vector, with the rest zeroed. this
+// goes through general-purpose registers, since building the vector in memory and loading it all at once would stall.
+static inline __attribute__((always_inline)) __m128i _bolt_attr_load(const uint8_t* src, size_t size) {
+    if (size >= 16) return _mm_loadu_si128((const __m128i*)src);
+    // 3 and 6 bytes are put together from whole loads, since gcc does a partial memcpy by storing the pieces to the
+    // stack and reading them back as one, which stalls on store forwarding and made these the slowest kernels
+    if (size == 3) {
+        uint16_t v;
+        memcpy(&v, src, 2);
+        return _mm_cvtsi32_si128((int32_t)((uint32_t)v | ((uint32_t)src[2] << 16)));
+    }
+    if (size == 6) {
+        uint32_t v;
+        uint16_t w;
+        memcpy(&v, src, 4);
+        memcpy(&w, src + 4, 2);
+        return _mm_set_epi64x(0, (int64_t)((uint64_t)v | ((uint64_t)w << 32)));
+    }
+    if (size <= 4) {
+        int32_t v = 0;
+        memcpy(&v, src, size);
+        return _mm_cvtsi32_si128(v);
+    }
+    int64_t low = 0;
+    int64_t high = 0;
+    memcpy(&low, src, size < 8 ? size : 8);
+    if (size > 8) memcpy(&high, src + 8, size - 8);
+    return _mm_set_epi64x(high, low);
+}
+
+// reads `n` components and widens them to floats. the lanes past n are zero.
+static inline __attribute__((always_inline)) __m128 _bolt_attr_widen(const uint8_t* src, enum AttrType type, size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    switch (type) {
+        case ATTR_FLOAT:
+            return _mm_castsi128_ps(_bolt_attr_load(src, n * 4));
+        case ATTR_UBYTE:
+        case ATTR_BYTE: {
+            const __m128i x = _bolt_attr_load(src, n);
+            if (type == ATTR_UBYTE) return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(x, zero), zero));
+            // repeat each byte across its lane, then shift it back down with its sign
+            const __m128i doubled = _mm_unpacklo_epi8(x, x);
+            return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(doubled, doubled), 24));
+        }
+        case ATTR_USHORT:
+        case ATTR_SHORT: {
+            const __m128i x = _bolt_attr_load(src, n * 2);
+            return _mm_cvtepi32_ps(type == ATTR_USHORT ? _mm_unpacklo_epi16(x, zero) : _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+        }
+        case ATTR_UINT: {
+            // there's no unsigned conversion, so convert the two halves separately, which is exact until the add
+            const __m128i x = _bolt_attr_load(src, n * 4);
+            const __m128 high = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(x, 16)), _mm_set1_ps(65536.0f));
+            return _mm_add_ps(high, _mm_cvtepi32_ps(_mm_and_si128(x, _mm_set1_epi32(0xFFFF))));
+        }
+        case ATTR_INT:
+        default:
+            return _mm_cvtepi32_ps(_bolt_attr_load(src, n * 4));
+    }
+}
+
+static inline __attribute__((always_inline)) void _bolt_attr_run(enum AttrType type, size_t n, const uint8_t* base, size_t stride, const uint16_t* indices,
+                                                                  size_t first, size_t count, float scale, float bias, float* out) {
+    const __m128 scale4 = _mm_set1_ps(scale);
+    const __m128 bias4 = _mm_set1_ps(bias);
+    // a whole vector can be stored for every vertex that has at least 4 floats of output after its start, since the
+    // next vertex overwrites the extra lanes. only the last few have to be stored one float at a time.
+    const size_t whole = (count * n >= 4) ? ((count * n - 4) / n) + 1 : 0;
+    size_t i = 0;
+    for (; i < whole; i += 1) {
+        const uint8_t* src = base + (stride * (indices ? indices[i] : first + i));
+        _mm_storeu_ps(out + (i * n), _mm_add_ps(_mm_mul_ps(_bolt_attr_widen(src, type, n), scale4), bias4));
+    }
+    for (; i < count; i += 1) {
+        const uint8_t* src = base + (stride * (indices ? indices[i] : first + i));
+        float v[4];
+        _mm_storeu_ps(v, _mm_add_ps(_mm_mul_ps(_bolt_attr_widen(src, type, n), scale4), bias4));
+        memcpy(out + (i * n), v, n * sizeof(*v));
+    }
+}
+#else
+static inline __attribute__((always_inline)) float _bolt_attr_component(const uint8_t* src, enum AttrType type, size_t j) {
+    switch (type) {
+        case ATTR_FLOAT: { float v; memcpy(&v, src + (j * 4), 4); return v; }
+        case ATTR_UBYTE: return (float)src[j];
+        case ATTR_BYTE: return (float)(int8_t)src[j];
+        case ATTR_USHORT: { uint16_t v; memcpy(&v, src + (j * 2), 2); return (float)v; }
+        case ATTR_SHORT: { int16_t v; memcpy(&v, src + (j * 2), 2); return (float)v; }
+        case ATTR_UINT: { uint32_t v; memcpy(&v, src + (j * 4), 4); return (float)v; }
+        case ATTR_INT:
+        default: { int32_t v; memcpy(&v, src + (j * 4), 4); return (float)v; }
+    }
+}
+
+static inline __attribute__((always_inline)) void _bolt_attr_run(enum AttrType type, size_t n, const uint8_t* base, size_t stride, const uint16_t* indices,
+                                                                  size_t first, size_t count, float scale, float bias, float* out) {
+    for (size_t i = 0; i < count; i += 1) {
+        const uint8_t* src = base + (stride * (indices ? indices[i] : first + i));
+        for (size_t j = 0; j < n; j += 1) out[(i * n) + j] = (_bolt_attr_component(src, type, j) * scale) + bias;
+    }
+}
+#endif
+
+#define ATTR_KERNEL(TYPE, N) \
+static void _bolt_attr_kernel_##TYPE##_##N(const uint8_t* base, size_t stride, const uint16_t* indices, size_t first, size_t count, float scale, float bias, float* out) { \
+    _bolt_attr_run(TYPE, N, base, stride, indices, first, count, scale, bias, out); \
+}
+#define ATTR_KERNELS(TYPE) ATTR_KERNEL(TYPE, 1) ATTR_KERNEL(TYPE, 2) ATTR_KERNEL(TYPE, 3) ATTR_KERNEL(TYPE, 4)
+ATTR_KERNELS(ATTR_FLOAT)
+ATTR_KERNELS(ATTR_UBYTE)
+ATTR_KERNELS(ATTR_BYTE)
+ATTR_KERNELS(ATTR_USHORT)
+ATTR_KERNELS(ATTR_SHORT)
+ATTR_KERNELS(ATTR_UINT)
+ATTR_KERNELS(ATTR_INT)
+#define ATTR_KERNEL_ROW(TYPE) {_bolt_attr_kernel_##TYPE##_1, _bolt_attr_kernel_##TYPE##_2, _bolt_attr_kernel_##TYPE##_3, _bolt_attr_kernel_##TYPE##_4}
+static const AttrKernel attr_kernels[ATTR_TYPE_COUNT][4] = {
+    ATTR_KERNEL_ROW(ATTR_FLOAT),
+    ATTR_KERNEL_ROW(ATTR_UBYTE),
+    ATTR_KERNEL_ROW(ATTR_BYTE),
+    ATTR_KERNEL_ROW(ATTR_USHORT),
+    ATTR_KERNEL_ROW(ATTR_SHORT),
+    ATTR_KERNEL_ROW(ATTR_UINT),
+    ATTR_KERNEL_ROW(ATTR_INT),
+};
+#undef ATTR_KERNEL_ROW
+#undef ATTR_KERNELS
+#undef ATTR_KERNEL
+
+void _bolt_attr_resolve(struct GLAttrBinding* binding) {
+    const int type = _bolt_attr_type(binding->type);
+    binding->kind = type < 0 ? 0 : (uint8_t)(type + 1);
+    if (type < 0) return;
+    // a stride of 0 means the attribute is tightly packed
+    binding->fetch_stride = binding->stride ? binding->stride : ((size_t)binding->size * attr_type_sizes[type]);
+    binding->scale = binding->normalise ? attr_norm_scales[type] : 1.0f;
+    binding->bias = binding->normalise ? attr_norm_biases[type] : 0.0f;
+}
+
+uint8_t _bolt_attr_extent(const struct GLAttrBinding* binding, uint16_t min, uint16_t max, size_t* start, size_t* end) {
+    // offsets come straight from the game, so anything that couldn't be in a buffer is ruled out before it can overflow
+    if (!binding->kind || binding->size < 1 || binding->size > 4 || min > max || binding->offset > UINT32_MAX) return 0;
+    *start = binding->offset + ((size_t)min * binding->fetch_stride);
+    *end = binding->offset + ((size_t)max * binding->fetch_stride) + ((size_t)binding->size * attr_type_sizes[binding->kind - 1]);
+    return 1;
+}
+
+uint8_t _bolt_attr_decode(const struct GLAttrBinding* binding, const void* data, size_t data_size, const uint16_t* indices,
+                          size_t first, size_t count, size_t num_out, float* out) {
+    if (!binding->kind || num_out < 1 || num_out > 4 || !data) return 0;
+    if (!count) return 1;
+    const int type = binding->kind - 1;
+    const size_t stride = binding->fetch_stride;
+    // only the highest vertex needs checking against the end of the buffer
+    size_t hi = first + count - 1;
+    if (indices) {
+        uint16_t min, max;
+        _bolt_index_range(indices, count, &min, &max);
+        hi = max;
+    }
+    const size_t needed = num_out * attr_type_sizes[type];
+    if (binding->offset > data_size || needed > data_size - binding->offset) return 0;
+    if (stride && hi > (data_size - binding->offset - needed) / stride) return 0;
+
+    const uint8_t* base = (const uint8_t*)data + binding->offset;
+    attr_kernels[type][num_out - 1](base, stride, indices, first, count, binding->scale, binding->bias, out);
+    return 1;
+}
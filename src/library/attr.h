@@ -0,0 +1,32 @@
+#ifndef _BOLT_LIBRARY_ATTR_H_
+#define _BOLT_LIBRARY_ATTR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct GLAttrBinding;
+
+// batched vertex attribute decoding. there's one kernel for each combination of GL type and component count, each of
+// which widens a vertex's components to floats with SSE2 where available, and normalisation is a scale and bias
+// applied on the way out. a whole batch is bounds-checked once, using the range of its indices.
+
+// finds the smallest and largest of `count` indices. count must not be 0.
+void _bolt_index_range(const uint16_t* indices, size_t count, uint16_t* min, uint16_t* max);
+
+// works out the parts of a binding that don't depend on which vertices are being decoded: which kernel to use, the
+// stride if it's 0, and the normalisation scale and bias. must be called whenever the binding's fields change.
+void _bolt_attr_resolve(struct GLAttrBinding*);
+
+// works out which bytes of its buffer an attribute is read from for vertices `min` to `max`, as [*start, *end).
+// returns 0 if the binding can't be decoded.
+uint8_t _bolt_attr_extent(const struct GLAttrBinding*, uint16_t min, uint16_t max, size_t* start, size_t* end);
+
+// decodes the first `num_out` components (1 to 4, and no more than the attribute has) of an attribute as floats, for
+// each of `count` vertices, into out[(i * num_out) + j]. vertex i is indices[i], or first + i if indices is NULL.
+// `data` is the start of the buffer the attribute is in, and `data_size` is how much of it can be read. returns 0
+// without writing anything if the type isn't supported or the binding hasn't been resolved, or if any of the vertices
+// would be read from outside the buffer.
+uint8_t _bolt_attr_decode(const struct GLAttrBinding*, const void* data, size_t data_size, const uint16_t* indices,
+                          size_t first, size_t count, size_t num_out, float* out);
+
+#endif
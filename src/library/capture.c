@@ -0,0 +1,512 @@
+#include "capture.h"
+#include "attr.h"
+#include "gl.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static uint64_t _bolt_capture_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+// all of a list's arrays live in one block, so growing it is one allocation
+#define RENDER_LIST_MIN_CAPACITY 1024
+#define RENDER_LIST_RECORD_SIZE (sizeof(uint64_t) + sizeof(unsigned int) + (sizeof(float) * 8) + sizeof(uint32_t))
+static uint8_t _bolt_render_list_reserve(struct BoltRenderList* list, uint32_t count) {
+    if (count <= list->capacity) return 1;
+    uint32_t capacity = list->capacity ? list->capacity : RENDER_LIST_MIN_CAPACITY;
+    while (capacity < count) capacity *= 2;
+    uint8_t* block = malloc((size_t)capacity * RENDER_LIST_RECORD_SIZE);
+    if (!block) return 0;
+    struct BoltRenderList old = *list;
+    // keys go first so that they're aligned
+    list->key = (uint64_t*)block;
+    list->texture = (unsigned int*)(list->key + capacity);
+    list->screen_x = (float*)(list->texture + capacity);
+    list->screen_y = list->screen_x + capacity;
+    list->screen_w = list->screen_y + capacity;
+    list->screen_h = list->screen_w + capacity;
+    list->atlas_x = list->screen_h + capacity;
+    list->atlas_y = list->atlas_x + capacity;
+    list->atlas_w = list->atlas_y + capacity;
+    list->atlas_h = list->atlas_w + capacity;
+    list->colour = (uint32_t*)(list->atlas_h + capacity);
+    list->capacity = capacity;
+    if (old.count) {
+        memcpy(list->key, old.key, old.count * sizeof(*list->key));
+        memcpy(list->texture, old.texture, old.count * sizeof(*list->texture));
+        memcpy(list->screen_x, old.screen_x, old.count * sizeof(float));
+        memcpy(list->screen_y, old.screen_y, old.count * sizeof(float));
+        memcpy(list->screen_w, old.screen_w, old.count * sizeof(float));
+        memcpy(list->screen_h, old.screen_h, old.count * sizeof(float));
+        memcpy(list->atlas_x, old.atlas_x, old.count * sizeof(float));
+        memcpy(list->atlas_y, old.atlas_y, old.count * sizeof(float));
+        memcpy(list->atlas_w, old.atlas_w, old.count * sizeof(float));
+        memcpy(list->atlas_h, old.atlas_h, old.count * sizeof(float));
+        memcpy(list->colour, old.colour, old.count * sizeof(*list->colour));
+    }
+    free(old.key);
+    return 1;
+}
+
+// scratch space for `quads` quads: two floats per index for positions, and eight floats per quad for the
+// per-quad attributes (colour, atlas min and atlas extents), which are only read from each quad's first vertex
+static uint8_t _bolt_render_list_reserve_scratch(struct BoltRenderList* list, size_t quads) {
+    if (quads <= list->scratch_capacity) return 1;
+    size_t capacity = list->scratch_capacity ? list->scratch_capacity : RENDER_LIST_MIN_CAPACITY;
+    while (capacity < quads) capacity *= 2;
+    float* positions = malloc(capacity * 6 * 2 * sizeof(*positions));
+    float* params = malloc(capacity * 8 * sizeof(*params));
+    uint16_t* firsts = malloc(capacity * sizeof(*firsts));
+    if (!positions || !params || !firsts) {
+        free(positions);
+        free(params);
+        free(firsts);
+        return 0;
+    }
+    free(list->positions);
+    free(list->params);
+    free(list->firsts);
+    list->positions = positions;
+    list->params = params;
+    list->firsts = firsts;
+    list->scratch_capacity = capacity;
+    return 1;
+}
+
+void _bolt_render_list_clear(struct BoltRenderList* list) {
+    list->count = 0;
+    list->dropped = 0;
+    list->elapsed_ns = 0;
+}
+
+void _bolt_render_list_free(struct BoltRenderList* list) {
+    free(list->key);
+    free(list->positions);
+    free(list->params);
+    free(list->firsts);
+    memset(list, 0, sizeof(*list));
+}
+
+static uint32_t _bolt_pack_colour(const float* rgba) {
+#if defined(__SSE2__)
+    const __m128 c = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(rgba), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    const __m128i i = _mm_cvtps_epi32(_mm_mul_ps(c, _mm_set1_ps(255.0f)));
+    const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(i, i), _mm_setzero_si128());
+    return (uint32_t)_mm_cvtsi128_si32(packed);
+#else
+    uint32_t colour = 0;
+    for (size_t i = 0; i < 4; i += 1) {
+        const float c = rgba[i] < 0.0f ? 0.0f : (rgba[i] > 1.0f ? 1.0f : rgba[i]);
+        colour |= (uint32_t)((c * 255.0f) + 0.5f) << (i * 8);
+    }
+    return colour;
+#endif
+}
+
+static uint64_t _bolt_hash_word(uint64_t hash, uint32_t word) {
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 29);
+}
+
+static uint64_t _bolt_hash_float(uint64_t hash, float f) {
+    uint32_t word;
+    memcpy(&word, &f, sizeof(word));
+    return _bolt_hash_word(hash, word);
+}
+
+// each buffer a draw reads from is copied as the union of what its attributes need, so interleaved attributes are only
+// copied once
+#define CAPTURE_PIN_ATTRIBUTES 4
+struct CapturePinRange {
+    const struct GLArrayBuffer* buffer;
+    size_t start;
+    size_t end;
+    size_t dst; // offset into the snapshot's vertices
+};
+
+struct GLDrawSnapshot* _bolt_capture_pin(struct GLShareGroup* group, const struct GLDrawSnapshot* draw, uint32_t generation, void* (*alloc)(size_t)) {
+    const struct GLVertexFetcher* a = &draw->attributes;
+    const size_t index_count = (size_t)(draw->count / 6) * 6;
+    if (!index_count || !a->aVertexPosition2D.enabled || !a->aTextureUVAtlasMin.enabled || !a->aTextureUVAtlasExtents.enabled) return NULL;
+    const struct GLAttrBinding* bindings[CAPTURE_PIN_ATTRIBUTES] = {&a->aVertexPosition2D, &a->aTextureUVAtlasMin, &a->aTextureUVAtlasExtents, a->aVertexColour.enabled ? &a->aVertexColour : NULL};
+    struct CapturePinRange ranges[CAPTURE_PIN_ATTRIBUTES];
+    size_t range_of[CAPTURE_PIN_ATTRIBUTES] = {0};
+    size_t range_count = 0;
+    struct GLDrawSnapshot* snapshot = NULL;
+
+    pthread_mutex_lock(&group->buffers_lock);
+    const struct GLArrayBuffer* elements = _bolt_find_current_buffer(&group->buffers, draw->element_buffer, generation);
+    const uint16_t* indices = NULL;
+    uint16_t min = 0;
+    uint16_t max = 0;
+    if (elements && !(draw->indices & 1) && draw->indices <= elements->capacity && index_count <= (elements->capacity - draw->indices) / sizeof(uint16_t)) {
+        indices = (const uint16_t*)((const uint8_t*)elements->data + draw->indices);
+        _bolt_index_range(indices, index_count, &min, &max);
+    }
+    uint8_t ok = indices != NULL;
+    for (size_t i = 0; ok && i < CAPTURE_PIN_ATTRIBUTES; i += 1) {
+        if (!bindings[i]) continue;
+        const struct GLArrayBuffer* buffer = _bolt_find_current_buffer(&group->buffers, bindings[i]->buffer, generation);
+        size_t start, end;
+        if (!buffer || !_bolt_attr_extent(bindings[i], min, max, &start, &end) || end > buffer->capacity) {
+            ok = 0;
+            break;
+        }
+        size_t r = 0;
+        while (r < range_count && ranges[r].buffer != buffer) r += 1;
+        if (r == range_count) {
+            ranges[range_count++] = (struct CapturePinRange){.buffer = buffer, .start = start, .end = end};
+        } else {
+            if (start < ranges[r].start) ranges[r].start = start;
+            if (end > ranges[r].end) ranges[r].end = end;
+        }
+        range_of[i] = r;
+    }
+    if (ok) {
+        const size_t header_size = (sizeof(*snapshot) + 15) & ~(size_t)15;
+        const size_t elements_size = ((index_count * sizeof(uint16_t)) + 15) & ~(size_t)15;
+        size_t vertices_size = 0;
+        for (size_t r = 0; r < range_count; r += 1) {
+            ranges[r].dst = vertices_size;
+            vertices_size += ranges[r].end - ranges[r].start;
+        }
+        snapshot = alloc(header_size + elements_size + vertices_size);
+        if (snapshot) {
+            *snapshot = *draw;
+            uint16_t* pinned = (uint16_t*)((uint8_t*)snapshot + header_size);
+            uint8_t* vertices = (uint8_t*)pinned + elements_size;
+            for (size_t i = 0; i < index_count; i += 1) pinned[i] = indices[i] - min;
+            for (size_t r = 0; r < range_count; r += 1) {
+                memcpy(vertices + ranges[r].dst, (const uint8_t*)ranges[r].buffer->data + ranges[r].start, ranges[r].end - ranges[r].start);
+            }
+            // with the indices rebased, vertex `min` is at the start of each attribute's part of the copy
+            struct GLAttrBinding* out[CAPTURE_PIN_ATTRIBUTES] = {&snapshot->attributes.aVertexPosition2D, &snapshot->attributes.aTextureUVAtlasMin,
+                                                                 &snapshot->attributes.aTextureUVAtlasExtents, &snapshot->attributes.aVertexColour};
+            for (size_t i = 0; i < CAPTURE_PIN_ATTRIBUTES; i += 1) {
+                if (!bindings[i]) continue;
+                const struct CapturePinRange* range = &ranges[range_of[i]];
+                out[i]->offset = range->dst + (bindings[i]->offset + ((size_t)min * bindings[i]->fetch_stride)) - range->start;
+            }
+            snapshot->elements = pinned;
+            snapshot->vertices = vertices;
+            snapshot->vertices_size = vertices_size;
+        }
+    }
+    pthread_mutex_unlock(&group->buffers_lock);
+    return snapshot;
+}
+
+// decodes the draw's quads into the list, returning how many there were, or 0 if any of it couldn't be read
+static uint32_t _bolt_capture_quads(struct BoltRenderList* list, const struct GLDrawSnapshot* draw, uint32_t quads) {
+    const struct GLVertexFetcher* a = &draw->attributes;
+    if (!draw->elements || !draw->vertices) return 0;
+    const size_t index_count = (size_t)quads * 6;
+    if (!_bolt_render_list_reserve_scratch(list, quads) || !_bolt_render_list_reserve(list, list->count + quads)) return 0;
+    const uint16_t* indices = draw->elements;
+    for (size_t q = 0; q < quads; q += 1) list->firsts[q] = indices[q * 6];
+
+    float* colours = list->params;
+    float* mins = colours + ((size_t)quads * 4);
+    float* extents = mins + ((size_t)quads * 2);
+    const uint8_t* vertices = draw->vertices;
+    const size_t size = draw->vertices_size;
+    if (!_bolt_attr_decode(&a->aVertexPosition2D, vertices, size, indices, 0, index_count, 2, list->positions)) return 0;
+    if (!_bolt_attr_decode(&a->aTextureUVAtlasMin, vertices, size, list->firsts, 0, quads, 2, mins)) return 0;
+    if (!_bolt_attr_decode(&a->aTextureUVAtlasExtents, vertices, size, list->firsts, 0, quads, 2, extents)) return 0;
+    // a disabled colour attribute reads as GL's default of opaque white
+    if (!a->aVertexColour.enabled || !_bolt_attr_decode(&a->aVertexColour, vertices, size, list->firsts, 0, quads, 4, colours)) {
+        for (size_t i = 0; i < (size_t)quads * 4; i += 1) colours[i] = 1.0f;
+    }
+
+    const uint32_t base = list->count;
+    for (uint32_t q = 0; q < quads; q += 1) {
+        const float* p = list->positions + ((size_t)q * 12);
+        float x0, y0, x1, y1;
+#if defined(__SSE2__)
+        // two (x, y) pairs per vector, so three vectors cover the quad's six vertices
+        const __m128 a = _mm_loadu_ps(p);
+        const __m128 b = _mm_loadu_ps(p + 4);
+        const __m128 c = _mm_loadu_ps(p + 8);
+        __m128 lo = _mm_min_ps(_mm_min_ps(a, b), c);
+        __m128 hi = _mm_max_ps(_mm_max_ps(a, b), c);
+        lo = _mm_min_ps(lo, _mm_movehl_ps(lo, lo));
+        hi = _mm_max_ps(hi, _mm_movehl_ps(hi, hi));
+        float bounds[4];
+        _mm_storel_pi((__m64*)bounds, lo);
+        _mm_storel_pi((__m64*)(bounds + 2), hi);
+        x0 = bounds[0];
+        y0 = bounds[1];
+        x1 = bounds[2];
+        y1 = bounds[3];
+#else
+        x0 = x1 = p[0];
+        y0 = y1 = p[1];
+        for (size_t v = 1; v < 6; v += 1) {
+            const float x = p[v * 2];
+            const float y = p[(v * 2) + 1];
+            if (x < x0) x0 = x;
+            if (x > x1) x1 = x;
+            if (y < y0) y0 = y;
+            if (y > y1) y1 = y;
+        }
+#endif
+        const uint32_t r = base + q;
+        list->texture[r] = draw->texture;
+        list->screen_x[r] = x0;
+        list->screen_y[r] = y0;
+        list->screen_w[r] = x1 - x0;
+        list->screen_h[r] = y1 - y0;
+        list->atlas_x[r] = mins[q * 2];
+        list->atlas_y[r] = mins[(q * 2) + 1];
+        list->atlas_w[r] = extents[q * 2];
+        list->atlas_h[r] = extents[(q * 2) + 1];
+        list->colour[r] = _bolt_pack_colour(colours + ((size_t)q * 4));
+        uint64_t key = _bolt_hash_word(0, draw->texture);
+        key = _bolt_hash_float(key, list->atlas_x[r]);
+        key = _bolt_hash_float(key, list->atlas_y[r]);
+        key = _bolt_hash_float(key, list->atlas_w[r]);
+        key = _bolt_hash_float(key, list->atlas_h[r]);
+        list->key[r] = _bolt_hash_word(key, list->colour[r]);
+    }
+    list->count += quads;
+    return quads;
+}
+
+uint32_t _bolt_capture_draw(struct BoltRenderList* list, const struct GLDrawSnapshot* draw, uint64_t budget_ns) {
+    const uint32_t quads = draw->count / 6;
+    if (!quads) return 0;
+    if (budget_ns && list->elapsed_ns >= budget_ns) {
+        list->dropped += quads;
+        return 0;
+    }
+    const struct GLVertexFetcher* a = &draw->attributes;
+    if (!a->aVertexPosition2D.enabled || !a->aTextureUVAtlasMin.enabled || !a->aTextureUVAtlasExtents.enabled) return 0;
+    const uint64_t start = _bolt_capture_now();
+    const uint32_t captured = _bolt_capture_quads(list, draw, quads);
+    list->elapsed_ns += _bolt_capture_now() - start;
+    return captured;
+}
+
+// matching is done with a hash table of chains: each slot is one distinct hash, and the previous frame's quads with
+// that hash are chained through `next` in the order they were drawn. a quad from the new frame takes the first one
+// off the front of its chain, so quads that are drawn many times in a frame don't make matching any slower.
+#define RENDER_NO_INDEX UINT32_MAX
+struct BoltRenderSlot {
+    uint64_t hash;
+    uint32_t head; // RENDER_NO_INDEX once every quad in the chain has been matched
+    uint32_t tail; // RENDER_NO_INDEX if the slot is empty
+};
+
+static uint64_t _bolt_render_position_hash(const struct BoltRenderList* list, uint32_t i) {
+    uint64_t hash = _bolt_hash_float(list->key[i], list->screen_x[i]);
+    hash = _bolt_hash_float(hash, list->screen_y[i]);
+    hash = _bolt_hash_float(hash, list->screen_w[i]);
+    return _bolt_hash_float(hash, list->screen_h[i]);
+}
+
+// keys are 64-bit hashes of everything but the screen rectangle, so quads with the same key are taken to be the same
+// apart from where they are
+static uint8_t _bolt_render_same(const struct BoltRenderList* a, uint32_t i, const struct BoltRenderList* b, uint32_t j, uint8_t position) {
+    if (a->key[i] != b->key[j]) return 0;
+    if (!position) return 1;
+    return a->screen_x[i] == b->screen_x[j] && a->screen_y[i] == b->screen_y[j] && a->screen_w[i] == b->screen_w[j] && a->screen_h[i] == b->screen_h[j];
+}
+
+static struct BoltRenderSlot* _bolt_render_slot(struct BoltRenderDelta* delta, uint64_t hash, uint8_t insert) {
+    const size_t mask = delta->slot_count - 1;
+    for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+        struct BoltRenderSlot* slot = &delta->slots[i];
+        if (slot->tail == RENDER_NO_INDEX) {
+            if (!insert) return NULL;
+            slot->hash = hash;
+            return slot;
+        }
+        if (slot->hash == hash) return slot;
+    }
+}
+
+// chains every quad in [start, end) of the previous frame that hasn't been matched yet, by either its key or its
+// position hash
+static void _bolt_render_chain(struct BoltRenderDelta* delta, const struct BoltRenderList* previous, uint32_t start, uint32_t end, uint8_t position) {
+    // the table is only as big as this needs, so that a frame with few changes doesn't have to clear all of it
+    delta->slot_count = 16;
+    while (delta->slot_count < (size_t)(end - start) * 2) delta->slot_count *= 2;
+    for (size_t i = 0; i < delta->slot_count; i += 1) delta->slots[i].head = delta->slots[i].tail = RENDER_NO_INDEX;
+    for (uint32_t i = start; i < end; i += 1) {
+        if (delta->matched[i]) continue;
+        struct BoltRenderSlot* slot = _bolt_render_slot(delta, position ? _bolt_render_position_hash(previous, i) : previous->key[i], 1);
+        delta->next[i] = RENDER_NO_INDEX;
+        if (slot->tail == RENDER_NO_INDEX) slot->head = i;
+        else delta->next[slot->tail] = i;
+        slot->tail = i;
+    }
+}
+
+// takes the first quad off the chain that matches quad j of the new frame, or returns RENDER_NO_INDEX if there isn't one
+static uint32_t _bolt_render_take(struct BoltRenderDelta* delta, const struct BoltRenderList* previous, const struct BoltRenderList* frame, uint32_t j, uint8_t position) {
+    struct BoltRenderSlot* slot = _bolt_render_slot(delta, position ? _bolt_render_position_hash(frame, j) : frame->key[j], 0);
+    if (!slot) return RENDER_NO_INDEX;
+    const uint32_t i = slot->head;
+    // a different quad with the same position hash is so unlikely that it's just treated as unmatched
+    if (i == RENDER_NO_INDEX || !_bolt_render_same(previous, i, frame, j, position)) return RENDER_NO_INDEX;
+    // tail is left alone, since it's what marks the slot as occupied, and an emptied slot has to stay occupied or
+    // later probes for other hashes could stop short of their slots
+    slot->head = delta->next[i];
+    delta->matched[i] = 1;
+    return i;
+}
+
+static uint8_t _bolt_render_delta_reserve(struct BoltRenderDelta* delta, size_t count) {
+    // the slot table is used even when both frames are empty, so the first call always allocates
+    if (count <= delta->capacity && delta->slots) return 1;
+    size_t capacity = delta->capacity ? delta->capacity : RENDER_LIST_MIN_CAPACITY;
+    while (capacity < count) capacity *= 2;
+    const size_t slot_capacity = capacity * 2 < 16 ? 16 : capacity * 2;
+    uint32_t* added = malloc(capacity * sizeof(*added));
+    uint32_t* removed = malloc(capacity * sizeof(*removed));
+    struct BoltRenderMove* moved = malloc(capacity * sizeof(*moved));
+    struct BoltRenderSlot* slots = malloc(slot_capacity * sizeof(*slots));
+    uint32_t* next = malloc(capacity * sizeof(*next));
+    uint8_t* matched = malloc(capacity * sizeof(*matched));
+    if (!added || !removed || !moved || !slots || !next || !matched) {
+        free(added);
+        free(removed);
+        free(moved);
+        free(slots);
+        free(next);
+        free(matched);
+        return 0;
+    }
+    _bolt_render_delta_free(delta);
+    delta->added = added;
+    delta->removed = removed;
+    delta->moved = moved;
+    delta->slots = slots;
+    delta->next = next;
+    delta->matched = matched;
+    delta->capacity = capacity;
+    delta->slot_capacity = slot_capacity;
+    return 1;
+}
+
+uint8_t _bolt_render_list_diff(const struct BoltRenderList* previous, const struct BoltRenderList* frame, struct BoltRenderDelta* delta) {
+    delta->added_count = 0;
+    delta->removed_count = 0;
+    delta->moved_count = 0;
+    delta->unchanged_count = 0;
+    if (!_bolt_render_delta_reserve(delta, previous->count > frame->count ? previous->count : frame->count)) return 0;
+    memset(delta->matched, 0, previous->count);
+
+    // most of the interface is normally drawn the same way in the same order as last frame, so the quads at the start
+    // and end that are the same in both frames are matched up directly, and only what's between them gets hashed
+    uint32_t prefix = 0;
+    while (prefix < previous->count && prefix < frame->count && _bolt_render_same(previous, prefix, frame, prefix, 1)) {
+        delta->matched[prefix++] = 1;
+    }
+    uint32_t suffix = 0;
+    while (suffix < previous->count - prefix && suffix < frame->count - prefix &&
+           _bolt_render_same(previous, previous->count - suffix - 1, frame, frame->count - suffix - 1, 1)) {
+        delta->matched[previous->count - ++suffix] = 1;
+    }
+    delta->unchanged_count = prefix + suffix;
+
+    // then everything else that hasn't changed at all, so that moves are only looked for among what's left. quads
+    // that aren't matched here are put in `added` for now, and the second pass takes the ones that moved back out.
+    _bolt_render_chain(delta, previous, prefix, previous->count - suffix, 1);
+    for (uint32_t j = prefix; j < frame->count - suffix; j += 1) {
+        if (_bolt_render_take(delta, previous, frame, j, 1) != RENDER_NO_INDEX) delta->unchanged_count += 1;
+        else delta->added[delta->added_count++] = j;
+    }
+    if (delta->unchanged_count != previous->count && delta->added_count) {
+        _bolt_render_chain(delta, previous, prefix, previous->count - suffix, 0);
+        uint32_t still_added = 0;
+        for (uint32_t k = 0; k < delta->added_count; k += 1) {
+            const uint32_t j = delta->added[k];
+            const uint32_t i = _bolt_render_take(delta, previous, frame, j, 0);
+            if (i != RENDER_NO_INDEX) delta->moved[delta->moved_count++] = (struct BoltRenderMove){.from = i, .to = j};
+            else delta->added[still_added++] = j;
+        }
+        delta->added_count = still_added;
+    }
+    for (uint32_t i = prefix; i < previous->count - suffix; i += 1) {
+        if (!delta->matched[i]) delta->removed[delta->removed_count++] = i;
+    }
+    return 1;
+}
+
+void _bolt_render_delta_free(struct BoltRenderDelta* delta) {
+    free(delta->added);
+    free(delta->removed);
+    free(delta->moved);
+    free(delta->slots);
+    free(delta->next);
+    free(delta->matched);
+    memset(delta, 0, sizeof(*delta));
+}
+
+uint32_t _bolt_subscriber_add(struct BoltSubscriberList* list, void (*callback)(void), void* userdata) {
+    uint32_t id = 0;
+    pthread_mutex_lock(&list->lock);
+    if (list->count == list->capacity) {
+        const size_t capacity = list->capacity ? list->capacity * 2 : 4;
+        struct BoltSubscriber* subscribers = realloc(list->subscribers, capacity * sizeof(*subscribers));
+        if (subscribers) {
+            list->subscribers = subscribers;
+            list->capacity = capacity;
+        }
+    }
+    if (list->count < list->capacity) {
+        id = list->next_id++;
+        list->subscribers[list->count++] = (struct BoltSubscriber){.id = id, .callback = callback, .userdata = userdata};
+        atomic_store(&list->subscribed, list->count);
+    }
+    pthread_mutex_unlock(&list->lock);
+    return id;
+}
+
+void _bolt_subscriber_remove(struct BoltSubscriberList* list, uint32_t id) {
+    pthread_mutex_lock(&list->lock);
+    for (size_t i = 0; i < list->count; i += 1) {
+        if (list->subscribers[i].id != id) continue;
+        list->subscribers[i] = list->subscribers[--list->count];
+        break;
+    }
+    atomic_store(&list->subscribed, list->count);
+    pthread_mutex_unlock(&list->lock);
+}
+
+uint8_t _bolt_subscriber_any(struct BoltSubscriberList* list) {
+    return atomic_load(&list->subscribed) != 0;
+}
+
+static struct BoltSubscriberList render_subscribers = BOLT_SUBSCRIBER_LIST_INIT;
+
+uint32_t _bolt_render_subscribe(BoltRenderCallback callback, void* userdata) {
+    return _bolt_subscriber_add(&render_subscribers, (void (*)(void))callback, userdata);
+}
+
+void _bolt_render_unsubscribe(uint32_t id) {
+    _bolt_subscriber_remove(&render_subscribers, id);
+}
+
+uint8_t _bolt_render_has_subscribers() {
+    return _bolt_subscriber_any(&render_subscribers);
+}
+
+void _bolt_render_publish(struct GLShareGroup* group, const struct BoltRenderList* frame, const struct BoltRenderList* previous, const struct BoltRenderDelta* delta) {
+    pthread_mutex_lock(&render_subscribers.lock);
+    for (size_t i = 0; i < render_subscribers.count; i += 1) {
+        const struct BoltSubscriber* subscriber = &render_subscribers.subscribers[i];
+        ((BoltRenderCallback)subscriber->callback)(group, frame, previous, delta, subscriber->userdata);
+    }
+    pthread_mutex_unlock(&render_subscribers.lock);
+}
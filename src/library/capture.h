@@ -0,0 +1,124 @@
+#ifndef _BOLT_LIBRARY_CAPTURE_H_
+#define _BOLT_LIBRARY_CAPTURE_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct GLShareGroup;
+struct GLDrawSnapshot;
+
+// the game's 2D interface as it was drawn in one frame, as a list of textured quads in the order they were drawn.
+// each important draw to the default framebuffer is a list of quads, two triangles each, and every quad becomes one
+// record here. records are stored as one array per field, so that anything scanning a frame for one thing (e.g. every
+// quad using a particular texture) only touches the memory it needs.
+// screen rectangles are in the same space as aVertexPosition2D, i.e. before the projection matrix is applied, and
+// atlas rectangles are aTextureUVAtlasMin and aTextureUVAtlasExtents, normalised to the size of the texture.
+struct BoltRenderList {
+    uint32_t count;
+    uint32_t capacity;
+    unsigned int* texture;
+    float* screen_x;
+    float* screen_y;
+    float* screen_w;
+    float* screen_h;
+    float* atlas_x;
+    float* atlas_y;
+    float* atlas_w;
+    float* atlas_h;
+    uint32_t* colour; // RGBA8, with red in the lowest byte
+    uint64_t* key; // hash of texture, atlas rectangle and colour, which doesn't change when the quad moves
+    uint32_t dropped; // quads that weren't captured because the frame ran out of time
+    uint64_t elapsed_ns; // time spent capturing this frame so far
+
+    // scratch space for decoding a draw, kept here so it's only allocated once
+    float* positions;
+    float* params;
+    uint16_t* firsts;
+    size_t scratch_capacity;
+};
+
+// empties the list for a new frame, without freeing anything
+void _bolt_render_list_clear(struct BoltRenderList*);
+void _bolt_render_list_free(struct BoltRenderList*);
+
+// draws are captured on the worker, by which time the game has usually written something else into the buffers they
+// used, so the hook pins down what a draw read while it's still there: this copies the draw's indices and the part of
+// each vertex buffer they cover into a new snapshot, allocated with `alloc` as one block. returns NULL if the draw
+// can't be captured, e.g. because one of its buffers doesn't have a shadow that's current in `generation` (see
+// _bolt_find_current_buffer). takes the group's buffers lock.
+struct GLDrawSnapshot* _bolt_capture_pin(struct GLShareGroup*, const struct GLDrawSnapshot*, uint32_t generation, void* (*alloc)(size_t));
+
+// appends a pinned draw's quads to the list. `budget_ns` is how long a frame is allowed to spend in here: once the
+// list's elapsed_ns goes over it, every draw after that is counted in `dropped` instead of being captured, so that a
+// frame full of UI can't hold up the worker. 0 means no limit. returns the number of quads captured.
+uint32_t _bolt_capture_draw(struct BoltRenderList*, const struct GLDrawSnapshot*, uint64_t budget_ns);
+
+// the difference between two consecutive frames' render lists. quads are matched up by key: one with the same key and
+// screen rectangle as a quad in the previous frame is unchanged, and one with the same key but a different screen
+// rectangle has moved. quads drawn more than once per frame are matched up in the order they were drawn. everything
+// is an index into one of the two lists, so a delta is only valid as long as both lists are.
+struct BoltRenderMove {
+    uint32_t from; // index in the previous frame
+    uint32_t to; // index in the new frame
+};
+struct BoltRenderDelta {
+    uint32_t* added; // indices in the new frame
+    uint32_t* removed; // indices in the previous frame
+    struct BoltRenderMove* moved;
+    uint32_t added_count;
+    uint32_t removed_count;
+    uint32_t moved_count;
+    uint32_t unchanged_count;
+
+    // scratch space for matching, kept here so it's only allocated once
+    size_t capacity;
+    struct BoltRenderSlot* slots;
+    size_t slot_capacity;
+    size_t slot_count; // how much of `slots` the current pass is using
+    uint32_t* next;
+    uint8_t* matched;
+};
+
+// works out the delta from one frame to the next, in time linear in the number of quads in them. returns 0, leaving
+// the delta empty, if it couldn't allocate.
+uint8_t _bolt_render_list_diff(const struct BoltRenderList* previous, const struct BoltRenderList* frame, struct BoltRenderDelta*);
+void _bolt_render_delta_free(struct BoltRenderDelta*);
+
+// a list of callbacks that the worker calls with something once per frame. subscribers are kept in a small array,
+// and the lock is held while they're called, which is what makes it safe to free a subscriber's userdata as soon as
+// it's been removed. callbacks are stored as a generic function pointer, and cast back by whoever calls them.
+struct BoltSubscriber {
+    uint32_t id;
+    void (*callback)(void);
+    void* userdata;
+};
+struct BoltSubscriberList {
+    struct BoltSubscriber* subscribers;
+    size_t count;
+    size_t capacity;
+    uint32_t next_id;
+    _Atomic size_t subscribed; // count, for checking without the lock
+    pthread_mutex_t lock;
+};
+#define BOLT_SUBSCRIBER_LIST_INIT {.next_id = 1, .lock = PTHREAD_MUTEX_INITIALIZER}
+// returns an id for _bolt_subscriber_remove, or 0 on failure
+uint32_t _bolt_subscriber_add(struct BoltSubscriberList*, void (*callback)(void), void* userdata);
+void _bolt_subscriber_remove(struct BoltSubscriberList*, uint32_t id);
+uint8_t _bolt_subscriber_any(struct BoltSubscriberList*);
+
+// consumers that want to know what changed in the interface each frame subscribe to deltas, rather than rescanning
+// every frame's whole list. callbacks are called on the worker of the share group the frame was drawn in, once per
+// frame, with the new frame, the previous one and the delta between them, none of which may be kept after returning.
+// callbacks must not subscribe or unsubscribe anything. deltas are only worked out while there's a subscriber.
+typedef void (*BoltRenderCallback)(struct GLShareGroup*, const struct BoltRenderList* frame, const struct BoltRenderList* previous, const struct BoltRenderDelta*, void* userdata);
+// returns an id for _bolt_render_unsubscribe, or 0 on failure
+uint32_t _bolt_render_subscribe(BoltRenderCallback, void* userdata);
+// once this returns, the callback won't be called again
+void _bolt_render_unsubscribe(uint32_t id);
+uint8_t _bolt_render_has_subscribers();
+// called by the worker at the end of each frame
+void _bolt_render_publish(struct GLShareGroup*, const struct BoltRenderList* frame, const struct BoltRenderList* previous, const struct BoltRenderDelta*);
+
+#endif
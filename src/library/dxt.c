@@ -0,0 +1,294 @@
+#include "dxt.h"
+#include "gl.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BOLT_DXT_AVX2
+#endif
+
+enum DXTKind {
+    DXT_NONE,
+    DXT_1_OPAQUE, // colour only, 3-colour blocks have black in slot 3
+    DXT_1_ALPHA,  // as above but slot 3 is transparent black
+    DXT_3,
+    DXT_5,
+};
+
+static enum DXTKind _bolt_dxt_kind(uint32_t format) {
+    switch (format) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+            return DXT_1_OPAQUE;
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+            return DXT_1_ALPHA;
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+            return DXT_3;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            return DXT_5;
+        default:
+            return DXT_NONE;
+    }
+}
+
+size_t _bolt_dxt_block_size(uint32_t format) {
+    switch (_bolt_dxt_kind(format)) {
+        case DXT_1_OPAQUE:
+        case DXT_1_ALPHA:
+            return 8;
+        case DXT_3:
+        case DXT_5:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+// everything about a block that the kernels need: its 4 colours as little-endian RGBA words, the 2-bit colour
+// index of each pixel, and for DXT3/DXT5 the alpha of each pixel. all the branching happens here, once per block.
+struct DXTBlock {
+    uint32_t colours[4];
+    uint32_t indices;
+    uint8_t alphas[16];
+    uint8_t has_alpha;
+};
+
+static inline uint32_t _bolt_rgb565_to_rgba(uint16_t packed) {
+    uint32_t r = (packed >> 11) & 0b00011111;
+    uint32_t g = (packed >> 5) & 0b00111111;
+    uint32_t b = packed & 0b00011111;
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+    return r | (g << 8) | (b << 16) | 0xFF000000u;
+}
+
+// weighted average of two RGBA words, channel by channel: (a*wa + b*wb) / div
+static inline uint32_t _bolt_rgba_mix(uint32_t a, uint32_t b, uint32_t wa, uint32_t wb, uint32_t div) {
+    uint32_t ret = 0;
+    for (unsigned int shift = 0; shift < 24; shift += 8) {
+        const uint32_t ca = (a >> shift) & 0xFF;
+        const uint32_t cb = (b >> shift) & 0xFF;
+        ret |= ((ca * wa + cb * wb) / div) << shift;
+    }
+    return ret | 0xFF000000u;
+}
+
+// always inlined, so that the AVX2 kernel gets its own copy compiled for AVX2 instead of calling out to an SSE one
+static inline __attribute__((always_inline)) void _bolt_dxt_read_block(enum DXTKind kind, const uint8_t* block, struct DXTBlock* out) {
+    const uint8_t* colour = block;
+    out->has_alpha = 0;
+    if (kind == DXT_3) {
+        for (size_t i = 0; i < 8; i += 1) {
+            out->alphas[i * 2] = (block[i] & 0x0F) * 17;
+            out->alphas[i * 2 + 1] = (block[i] >> 4) * 17;
+        }
+        out->has_alpha = 1;
+        colour = block + 8;
+    } else if (kind == DXT_5) {
+        const uint32_t a0 = block[0];
+        const uint32_t a1 = block[1];
+        uint8_t table[8] = {a0, a1};
+        if (a0 > a1) {
+            for (uint32_t i = 1; i < 7; i += 1) table[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+        } else {
+            for (uint32_t i = 1; i < 5; i += 1) table[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+            table[6] = 0;
+            table[7] = 255;
+        }
+        uint64_t bits = 0;
+        for (size_t i = 0; i < 6; i += 1) bits |= (uint64_t)block[2 + i] << (8 * i);
+        for (size_t i = 0; i < 16; i += 1) out->alphas[i] = table[(bits >> (3 * i)) & 7];
+        out->has_alpha = 1;
+        colour = block + 8;
+    }
+
+    const uint16_t c0 = colour[0] | (colour[1] << 8);
+    const uint16_t c1 = colour[2] | (colour[3] << 8);
+    out->colours[0] = _bolt_rgb565_to_rgba(c0);
+    out->colours[1] = _bolt_rgb565_to_rgba(c1);
+    // DXT3 and DXT5 always use 4-colour mode, DXT1 switches to 3-colour mode when c0 <= c1
+    if (c0 > c1 || kind == DXT_3 || kind == DXT_5) {
+        out->colours[2] = _bolt_rgba_mix(out->colours[0], out->colours[1], 2, 1, 3);
+        out->colours[3] = _bolt_rgba_mix(out->colours[0], out->colours[1], 1, 2, 3);
+    } else {
+        out->colours[2] = _bolt_rgba_mix(out->colours[0], out->colours[1], 1, 1, 2);
+        out->colours[3] = (kind == DXT_1_ALPHA) ? 0 : 0xFF000000u;
+    }
+    out->indices = colour[4] | (colour[5] << 8) | (colour[6] << 16) | ((uint32_t)colour[7] << 24);
+}
+
+static void _bolt_dxt_write_block_scalar(const struct DXTBlock* block, uint8_t* out, size_t out_pitch) {
+    for (size_t row = 0; row < 4; row += 1) {
+        uint32_t pixels[4];
+        for (size_t col = 0; col < 4; col += 1) {
+            const size_t i = row * 4 + col;
+            pixels[col] = block->colours[(block->indices >> (2 * i)) & 3];
+            if (block->has_alpha) pixels[col] = (pixels[col] & 0x00FFFFFFu) | ((uint32_t)block->alphas[i] << 24);
+        }
+        memcpy(out + row * out_pitch, pixels, sizeof(pixels));
+    }
+}
+
+#if defined(__SSE2__)
+// selects a colour for each of the 4 pixels of a row without branching: each lane is masked down to its own
+// 2-bit index, compared against every possible index at that lane's position, and the matches OR'd together.
+static inline __m128i _bolt_dxt_row_sse2(const struct DXTBlock* block, size_t row) {
+    const __m128i lane_masks = _mm_setr_epi32(0x03, 0x0C, 0x30, 0xC0);
+    const __m128i lane_codes = _mm_and_si128(_mm_set1_epi32((block->indices >> (8 * row)) & 0xFF), lane_masks);
+    __m128i pixels = _mm_setzero_si128();
+    for (int code = 0; code < 4; code += 1) {
+        const __m128i match = _mm_cmpeq_epi32(lane_codes, _mm_setr_epi32(code, code << 2, code << 4, code << 6));
+        pixels = _mm_or_si128(pixels, _mm_and_si128(match, _mm_set1_epi32((int)block->colours[code])));
+    }
+    if (block->has_alpha) {
+        const uint8_t* a = &block->alphas[row * 4];
+        const __m128i alpha = _mm_setr_epi32(a[0] << 24, a[1] << 24, a[2] << 24, (int)((uint32_t)a[3] << 24));
+        pixels = _mm_or_si128(_mm_and_si128(pixels, _mm_set1_epi32(0x00FFFFFF)), alpha);
+    }
+    return pixels;
+}
+
+static void _bolt_dxt_decode_row_sse2(enum DXTKind kind, const uint8_t* blocks, size_t block_size, size_t count, uint8_t* out, size_t out_pitch) {
+    for (size_t i = 0; i < count; i += 1) {
+        struct DXTBlock block;
+        _bolt_dxt_read_block(kind, blocks + i * block_size, &block);
+        for (size_t row = 0; row < 4; row += 1) {
+            _mm_storeu_si128((__m128i*)(out + row * out_pitch + i * 16), _bolt_dxt_row_sse2(&block, row));
+        }
+    }
+}
+#endif
+
+#if defined(BOLT_DXT_AVX2)
+// same as the SSE2 version, but handles two horizontally-adjacent blocks at a time, one in each 128-bit half
+__attribute__((target("avx2")))
+static void _bolt_dxt_decode_row_avx2(enum DXTKind kind, const uint8_t* blocks, size_t block_size, size_t count, uint8_t* out, size_t out_pitch) {
+    const __m256i lane_masks = _mm256_setr_epi32(0x03, 0x0C, 0x30, 0xC0, 0x03, 0x0C, 0x30, 0xC0);
+    const __m256i shifts = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    size_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        struct DXTBlock a, b;
+        _bolt_dxt_read_block(kind, blocks + i * block_size, &a);
+        _bolt_dxt_read_block(kind, blocks + (i + 1) * block_size, &b);
+        __m256i colours[4];
+        for (int code = 0; code < 4; code += 1) {
+            colours[code] = _mm256_setr_epi32(a.colours[code], a.colours[code], a.colours[code], a.colours[code],
+                                              b.colours[code], b.colours[code], b.colours[code], b.colours[code]);
+        }
+        for (size_t row = 0; row < 4; row += 1) {
+            const __m256i codes = _mm256_srlv_epi32(_mm256_and_si256(_mm256_setr_epi32(
+                (a.indices >> (8 * row)) & 0xFF, (a.indices >> (8 * row)) & 0xFF, (a.indices >> (8 * row)) & 0xFF, (a.indices >> (8 * row)) & 0xFF,
+                (b.indices >> (8 * row)) & 0xFF, (b.indices >> (8 * row)) & 0xFF, (b.indices >> (8 * row)) & 0xFF, (b.indices >> (8 * row)) & 0xFF
+            ), lane_masks), shifts);
+            __m256i pixels = _mm256_setzero_si256();
+            for (int code = 0; code < 4; code += 1) {
+                pixels = _mm256_or_si256(pixels, _mm256_and_si256(_mm256_cmpeq_epi32(codes, _mm256_set1_epi32(code)), colours[code]));
+            }
+            if (a.has_alpha) {
+                int alpha_a, alpha_b;
+                memcpy(&alpha_a, &a.alphas[row * 4], 4);
+                memcpy(&alpha_b, &b.alphas[row * 4], 4);
+                const __m128i wide_a = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(alpha_a));
+                const __m128i wide_b = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(alpha_b));
+                const __m256i alpha = _mm256_slli_epi32(_mm256_set_m128i(wide_b, wide_a), 24);
+                pixels = _mm256_or_si256(_mm256_and_si256(pixels, _mm256_set1_epi32(0x00FFFFFF)), alpha);
+            }
+            _mm256_storeu_si256((__m256i*)(out + row * out_pitch + i * 16), pixels);
+        }
+    }
+    for (; i < count; i += 1) {
+        struct DXTBlock block;
+        _bolt_dxt_read_block(kind, blocks + i * block_size, &block);
+        _bolt_dxt_write_block_scalar(&block, out + i * 16, out_pitch);
+    }
+}
+#endif
+
+static void _bolt_dxt_decode_row_scalar(enum DXTKind kind, const uint8_t* blocks, size_t block_size, size_t count, uint8_t* out, size_t out_pitch) {
+    for (size_t i = 0; i < count; i += 1) {
+        struct DXTBlock block;
+        _bolt_dxt_read_block(kind, blocks + i * block_size, &block);
+        _bolt_dxt_write_block_scalar(&block, out + i * 16, out_pitch);
+    }
+}
+
+typedef void (*DXTRowKernel)(enum DXTKind, const uint8_t*, size_t, size_t, uint8_t*, size_t);
+
+static DXTRowKernel row_kernel = NULL;
+
+uint8_t _bolt_dxt_use_kernel(enum BoltDXTKernel kernel) {
+    switch (kernel) {
+        case BOLT_DXT_KERNEL_SCALAR:
+            row_kernel = _bolt_dxt_decode_row_scalar;
+            return 1;
+#if defined(__SSE2__)
+        case BOLT_DXT_KERNEL_SSE2:
+            row_kernel = _bolt_dxt_decode_row_sse2;
+            return 1;
+#endif
+#if defined(BOLT_DXT_AVX2)
+        case BOLT_DXT_KERNEL_AVX2:
+            __builtin_cpu_init();
+            if (!__builtin_cpu_supports("avx2")) return 0;
+            row_kernel = _bolt_dxt_decode_row_avx2;
+            return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+static DXTRowKernel _bolt_dxt_row_kernel() {
+    if (!row_kernel && !_bolt_dxt_use_kernel(BOLT_DXT_KERNEL_AVX2) && !_bolt_dxt_use_kernel(BOLT_DXT_KERNEL_SSE2)) {
+        _bolt_dxt_use_kernel(BOLT_DXT_KERNEL_SCALAR);
+    }
+    return row_kernel;
+}
+
+void _bolt_dxt_decode_region(uint32_t format, const uint8_t* data, unsigned int width, unsigned int height,
+                             unsigned int x, unsigned int y, unsigned int w, unsigned int h, uint8_t* out, size_t out_pitch) {
+    const enum DXTKind kind = _bolt_dxt_kind(format);
+    const size_t block_size = _bolt_dxt_block_size(format);
+    if (kind == DXT_NONE || w == 0 || h == 0 || x + w > width || y + h > height) return;
+    const DXTRowKernel kernel = _bolt_dxt_row_kernel();
+    const size_t blocks_wide = (width + 3) / 4;
+    const unsigned int x_end = x + w;
+    const unsigned int y_end = y + h;
+
+    for (unsigned int by = y / 4; by * 4 < y_end; by += 1) {
+        const uint8_t* block_row = data + (by * blocks_wide * block_size);
+        const unsigned int py0 = by * 4 < y ? y : by * 4;
+        const unsigned int py1 = by * 4 + 4 > y_end ? y_end : by * 4 + 4;
+        uint8_t* out_row = out + ((py0 - y) * out_pitch);
+
+        // range of blocks in this row that can be written out whole, straight into the output
+        unsigned int full_start = (x + 3) / 4;
+        unsigned int full_end = x_end / 4;
+        if (py0 != by * 4 || py1 != by * 4 + 4 || full_start >= full_end) {
+            full_start = full_end = x / 4;
+        }
+        if (full_end > full_start) {
+            kernel(kind, block_row + (full_start * block_size), block_size, full_end - full_start, out_row + ((full_start * 4 - x) * 4), out_pitch);
+        }
+
+        // anything left over is a block that's partly outside the region, so decode it aside and copy what's needed
+        for (unsigned int bx = x / 4; bx * 4 < x_end; bx += 1) {
+            if (bx >= full_start && bx < full_end) continue;
+            uint8_t pixels[4 * 4 * 4];
+            _bolt_dxt_decode_row_scalar(kind, block_row + (bx * block_size), block_size, 1, pixels, 16);
+            const unsigned int px0 = bx * 4 < x ? x : bx * 4;
+            const unsigned int px1 = bx * 4 + 4 > x_end ? x_end : bx * 4 + 4;
+            for (unsigned int py = py0; py < py1; py += 1) {
+                memcpy(out + ((py - y) * out_pitch) + ((px0 - x) * 4), pixels + ((py - by * 4) * 16) + ((px0 - bx * 4) * 4), (px1 - px0) * 4);
+            }
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef _BOLT_LIBRARY_DXT_H_
+#define _BOLT_LIBRARY_DXT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// S3TC block decompression (DXT1, DXT3 and DXT5) into tightly-packed 8-bit RGBA.
+// https://www.khronos.org/opengl/wiki/S3_Texture_Compression
+// rows of whole blocks are decoded with AVX2 or SSE2 where available, with a scalar fallback for everything else.
+
+// the row kernels that _bolt_dxt_decode_region can use. it picks the fastest one the build and CPU support the first
+// time it's called, but tests and benchmarks can force any of them with _bolt_dxt_use_kernel, which returns 0 if that
+// one isn't available.
+enum BoltDXTKernel {
+    BOLT_DXT_KERNEL_SCALAR,
+    BOLT_DXT_KERNEL_SSE2,
+    BOLT_DXT_KERNEL_AVX2,
+};
+uint8_t _bolt_dxt_use_kernel(enum BoltDXTKernel);
+
+// returns the number of bytes per 4x4 block in the given GL internal format, or 0 if it isn't an S3TC format
+size_t _bolt_dxt_block_size(uint32_t format);
+
+// decodes the pixels (x, y, w, h) of a compressed image of size (width, height) whose blocks start at `data`.
+// `out` points to where pixel (x, y) should go, and `out_pitch` is the distance in bytes between output rows.
+// the region must lie inside the image. blocks hanging off the right or bottom edge are clipped.
+void _bolt_dxt_decode_region(uint32_t format, const uint8_t* data, unsigned int width, unsigned int height,
+                             unsigned int x, unsigned int y, unsigned int w, unsigned int h, uint8_t* out, size_t out_pitch);
+
+#endif
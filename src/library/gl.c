@@ -1,126 +1,430 @@
 #include "gl.h"
+#include "attr.h"
+#include "dxt.h"
+#include "sprite.h"
 
+#include <sched.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
 void _bolt_glcontext_init(struct GLContext*, void*, void*);
 void _bolt_glcontext_free(struct GLContext*);
 
-struct GLList contexts = {0};
 _Thread_local struct GLContext* current_context = NULL;
 
-#define LIST_GROWTH_STEP 256
-#define PTR_LIST_CAPACITY 256*256
-#define CONTEXTS_CAPACITY 64 // not growable so we just have to hard-code a number and hope it's enough forever
+#define LIST_MIN_CAPACITY 16
+#define CONTEXT_TABLE_MIN_CAPACITY 16
+
+// index slots are linear-probed, and kept at most half full. the slot is the low bits of the id times an odd constant,
+// not the high bits as in fibonacci hashing: multiplying by an odd number permutes the low bits, so ids that GL hands
+// out one after another never collide, which is most of them. ids spaced a power of two apart would share slots.
+#define LIST_HASH(ID, MASK) ((((uint32_t)(ID)) * 2654435769u) & (MASK))
+
+// returns the position of `id` in the dense array, or -1 if it isn't in the list
+static ptrdiff_t _bolt_list_lookup(const struct GLList* list, unsigned int id) {
+    if (id == 0 || !list->index_capacity) return -1;
+    const size_t mask = list->index_capacity - 1;
+    for (size_t i = LIST_HASH(id, mask); list->index[i].id != 0; i = (i + 1) & mask) {
+        if (list->index[i].id == id) return list->index[i].position;
+    }
+    return -1;
+}
+
+static void _bolt_list_index_set(struct GLList* list, unsigned int id, uint32_t position) {
+    const size_t mask = list->index_capacity - 1;
+    size_t i = LIST_HASH(id, mask);
+    while (list->index[i].id != 0 && list->index[i].id != id) i = (i + 1) & mask;
+    list->index[i].id = id;
+    list->index[i].position = position;
+}
+
+// appends a zeroed element with the given id and returns its position. the id must not already be in the list.
+static size_t _bolt_list_insert(struct GLList* list, unsigned int id, size_t element_size) {
+    if (list->count >= list->capacity) {
+        size_t new_capacity = list->capacity ? list->capacity * 2 : LIST_MIN_CAPACITY;
+        list->data = realloc(list->data, new_capacity * element_size);
+        list->ids = realloc(list->ids, new_capacity * sizeof(*list->ids));
+        list->capacity = new_capacity;
+    }
+    if ((list->count + 1) * 2 > list->index_capacity) {
+        // only the index gets rebuilt here, the objects themselves stay where they are
+        free(list->index);
+        list->index_capacity = list->index_capacity ? list->index_capacity * 2 : LIST_MIN_CAPACITY * 2;
+        list->index = calloc(list->index_capacity, sizeof(*list->index));
+        for (size_t i = 0; i < list->count; i += 1) _bolt_list_index_set(list, list->ids[i], i);
+    }
+    const size_t position = list->count++;
+    memset((uint8_t*)list->data + (position * element_size), 0, element_size);
+    list->ids[position] = id;
+    _bolt_list_index_set(list, id, position);
+    return position;
+}
+
+// removes `id` from the list by moving the last element into its place. returns 1 if it was found.
+static uint8_t _bolt_list_remove(struct GLList* list, unsigned int id, size_t element_size) {
+    if (id == 0 || !list->index_capacity) return 0;
+    const size_t mask = list->index_capacity - 1;
+    size_t i = LIST_HASH(id, mask);
+    while (list->index[i].id != id) {
+        if (list->index[i].id == 0) return 0;
+        i = (i + 1) & mask;
+    }
+    const uint32_t position = list->index[i].position;
+
+    // backward-shift deletion, so the table never fills up with tombstones
+    size_t hole = i;
+    for (size_t j = (i + 1) & mask; list->index[j].id != 0; j = (j + 1) & mask) {
+        const size_t home = LIST_HASH(list->index[j].id, mask);
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            list->index[hole] = list->index[j];
+            hole = j;
+        }
+    }
+    list->index[hole].id = 0;
+
+    const size_t last = --list->count;
+    if (position != last) {
+        memcpy((uint8_t*)list->data + (position * element_size), (uint8_t*)list->data + (last * element_size), element_size);
+        list->ids[position] = list->ids[last];
+        _bolt_list_index_set(list, list->ids[position], position);
+    }
+    return 1;
+}
+
+static void _bolt_list_free(struct GLList* list) {
+    free(list->data);
+    free(list->ids);
+    free(list->index);
+    memset(list, 0, sizeof(*list));
+}
 
 #define MAKE_GETTERS(STRUCT, NAME, ID_TYPE) \
 struct STRUCT* _bolt_find_##NAME(struct GLList* list, ID_TYPE id) { \
-    struct STRUCT** pointer_cache = list->pointers; \
-    if (id == 0) return NULL; \
-    uint8_t cacheable = (id < PTR_LIST_CAPACITY); \
-    if (cacheable && pointer_cache[id] != NULL) return pointer_cache[id]; \
-    for (size_t i = 0; i < list->capacity; i += 1) { \
-        struct STRUCT* ptr = &((struct STRUCT*)(list->data))[i]; \
-        if (ptr->id == id) { \
-            if (cacheable) pointer_cache[id] = ptr; \
-            return ptr; \
-        } \
-    } \
-    return NULL; \
+    const ptrdiff_t position = _bolt_list_lookup(list, id); \
+    return position < 0 ? NULL : &((struct STRUCT*)(list->data))[position]; \
 } \
 struct STRUCT* _bolt_get_##NAME(struct GLList* list, ID_TYPE id) { \
-    struct STRUCT** pointer_cache = list->pointers; \
     if (id == 0) return NULL; \
-    uint8_t cacheable = (id < PTR_LIST_CAPACITY); \
-    if (cacheable && pointer_cache[id] != NULL) return pointer_cache[id]; \
-    else if (!cacheable) { \
-        for (size_t i = 0; i < list->capacity; i += 1) { \
-            struct STRUCT* ptr = &((struct STRUCT*)(list->data))[i]; \
-            if (ptr->id == id) { \
-                return ptr; \
-            } \
-        } \
-    } \
-    if (list->first_empty >= list->capacity) { \
-        size_t old_capacity = list->capacity; \
-        list->capacity += LIST_GROWTH_STEP; \
-        struct STRUCT* new_ptr = calloc(list->capacity, sizeof(struct STRUCT)); \
-        memcpy(new_ptr, list->data, old_capacity * sizeof(struct STRUCT)); \
-        intptr_t ptr_offset = (intptr_t)new_ptr - (intptr_t)list->data; \
-        free(list->data); \
-        list->data = new_ptr; \
-        for (size_t i = 0; i < PTR_LIST_CAPACITY; i += 1) { \
-            if (pointer_cache[i]) pointer_cache[i] = (struct STRUCT*)((uintptr_t)(pointer_cache[i]) + ptr_offset);\
-        } \
+    ptrdiff_t position = _bolt_list_lookup(list, id); \
+    if (position < 0) { \
+        position = _bolt_list_insert(list, id, sizeof(struct STRUCT)); \
+        ((struct STRUCT*)(list->data))[position].id = id; \
     } \
-    struct STRUCT* ptr = &((struct STRUCT*)(list->data))[list->first_empty]; \
-    pointer_cache[id] = ptr; \
-    ptr->id = id; \
-    struct STRUCT* inc_ptr = ptr; \
-    while (list->first_empty < list->capacity && inc_ptr->id != 0) { \
-        inc_ptr += 1; \
-        list->first_empty += 1; \
-    } \
-    return ptr; \
+    return &((struct STRUCT*)(list->data))[position]; \
+} \
+uint8_t _bolt_remove_##NAME(struct GLList* list, ID_TYPE id) { \
+    return _bolt_list_remove(list, id, sizeof(struct STRUCT)); \
 }
 MAKE_GETTERS(GLArrayBuffer, buffer, unsigned int)
 MAKE_GETTERS(GLProgram, program, unsigned int)
 MAKE_GETTERS(GLTexture2D, texture, unsigned int)
+MAKE_GETTERS(GLVertexArray, vertex_array, unsigned int)
+MAKE_GETTERS(GLFramebuffer, framebuffer, unsigned int)
+MAKE_GETTERS(GLTextureTarget, texture_target, unsigned int)
 
-struct GLContext* _bolt_context() {
-    return current_context;
+struct GLArrayBuffer* _bolt_find_current_buffer(struct GLList* list, unsigned int id, uint32_t generation) {
+    struct GLArrayBuffer* buffer = _bolt_find_buffer(list, id);
+    if (!buffer || !buffer->data || !(generation & 1) || buffer->generation != generation) return NULL;
+    return buffer;
 }
 
-void _bolt_create_context(void* egl_context, void* shared) {
-    if (!contexts.capacity) {
-        contexts.capacity = CONTEXTS_CAPACITY;
-        contexts.data = malloc(CONTEXTS_CAPACITY * sizeof(struct GLContext));
+struct GLTexture2D* _bolt_find_current_texture(struct GLList* list, unsigned int id, uint32_t generation) {
+    struct GLTexture2D* tex = _bolt_find_texture(list, id);
+    if (!tex || !tex->tiles || !(generation & 1) || tex->generation != generation) return NULL;
+    return tex;
+}
+
+uint8_t _bolt_buffer_mark_dirty(struct GLArrayBuffer* buffer, uint32_t offset, uint32_t length) {
+    const uint8_t was_clean = buffer->dirty_count == 0;
+    const uint32_t size = buffer->capacity > UINT32_MAX ? UINT32_MAX : (uint32_t)buffer->capacity;
+    if (offset >= size) return 0;
+    const uint32_t start = offset;
+    const uint32_t end = (length > size - offset) ? size : offset + length;
+    if (start == end) return 0;
+
+    // [first, last) are the existing ranges that overlap or touch the new one, and get replaced by a single range
+    uint32_t first = 0;
+    uint32_t last = buffer->dirty_count;
+    while (first < last) {
+        const uint32_t mid = first + ((last - first) / 2);
+        if (buffer->dirty[mid].end < start) first = mid + 1;
+        else last = mid;
     }
-    for (size_t i = 0; i < contexts.capacity; i += 1) {
-        struct GLContext* ptr = &((struct GLContext*)(contexts.data))[i];
-        if (ptr->id == 0) {
-            _bolt_glcontext_init(ptr, egl_context, shared);
-            ptr->is_attached = 1;
-            return;
+    last = first;
+    while (last < buffer->dirty_count && buffer->dirty[last].start <= end) last += 1;
+
+    if (first == last) {
+        if (buffer->dirty_count == buffer->dirty_capacity) {
+            const uint32_t capacity = buffer->dirty_capacity ? buffer->dirty_capacity * 2 : 8;
+            struct GLBufferRange* dirty = realloc(buffer->dirty, capacity * sizeof(*dirty));
+            if (!dirty) {
+                // can't track it separately, so the whole shadow gets uploaded instead, which is always correct
+                if (!buffer->dirty_count) return 0;
+                buffer->dirty[0] = (struct GLBufferRange){.start = 0, .end = size};
+                buffer->dirty_count = 1;
+                return 0;
+            }
+            buffer->dirty = dirty;
+            buffer->dirty_capacity = capacity;
         }
+        memmove(&buffer->dirty[first + 1], &buffer->dirty[first], (buffer->dirty_count - first) * sizeof(*buffer->dirty));
+        buffer->dirty[first] = (struct GLBufferRange){.start = start, .end = end};
+        buffer->dirty_count += 1;
+        return was_clean;
     }
+
+    struct GLBufferRange* merged = &buffer->dirty[first];
+    if (start < merged->start) merged->start = start;
+    merged->end = buffer->dirty[last - 1].end > end ? buffer->dirty[last - 1].end : end;
+    memmove(&buffer->dirty[first + 1], &buffer->dirty[last], (buffer->dirty_count - last) * sizeof(*buffer->dirty));
+    buffer->dirty_count -= (last - first) - 1;
+    return 0;
 }
 
-void _bolt_make_context_current(void* egl_context) {
-    if (current_context) {
-        current_context->is_attached = 0;
-        if (current_context->deferred_destroy) _bolt_destroy_context(current_context);
+// epoch-based reclamation for the context registry. each thread that reads the registry has a record, which holds the
+// global epoch as it was when the thread started reading, or 0 while it isn't reading. anything removed from the
+// registry is retired with the epoch it was removed in, and the epoch moves on. once every reading thread's record
+// shows a later epoch, or none, nothing can still be looking at it. records are reused once their thread exits.
+struct GLEpochRecord {
+    _Atomic uint64_t epoch;
+    _Atomic uint8_t in_use;
+    struct GLEpochRecord* next;
+};
+struct GLRetired {
+    void* ptr;
+    uint64_t epoch;
+};
+static _Atomic uint64_t global_epoch = 1;
+static _Atomic(struct GLEpochRecord*) epoch_records = NULL;
+static _Thread_local struct GLEpochRecord* epoch_record = NULL;
+static pthread_key_t epoch_key;
+static pthread_once_t epoch_key_once = PTHREAD_ONCE_INIT;
+// only touched by writers, which the caller serialises
+static struct GLRetired* retired = NULL;
+static size_t retired_count = 0;
+static size_t retired_capacity = 0;
+
+static void _bolt_epoch_release_record(void* record) {
+    atomic_store(&((struct GLEpochRecord*)record)->in_use, 0);
+}
+
+static void _bolt_epoch_create_key() {
+    pthread_key_create(&epoch_key, _bolt_epoch_release_record);
+}
+
+static struct GLEpochRecord* _bolt_epoch_record() {
+    if (epoch_record) return epoch_record;
+    struct GLEpochRecord* record;
+    for (record = atomic_load(&epoch_records); record; record = record->next) {
+        uint8_t expected = 0;
+        if (atomic_compare_exchange_strong(&record->in_use, &expected, 1)) break;
     }
-    if (!egl_context) {
-        current_context = 0;
-        return;
+    if (!record) {
+        record = calloc(1, sizeof(*record));
+        if (!record) return NULL;
+        atomic_store(&record->in_use, 1);
+        record->next = atomic_load(&epoch_records);
+        while (!atomic_compare_exchange_weak(&epoch_records, &record->next, record));
+    }
+    pthread_once(&epoch_key_once, _bolt_epoch_create_key);
+    pthread_setspecific(epoch_key, record);
+    epoch_record = record;
+    return record;
+}
+
+// smallest epoch of any thread that's currently reading, or UINT64_MAX if none are
+static uint64_t _bolt_epoch_oldest_reader() {
+    uint64_t oldest = UINT64_MAX;
+    for (struct GLEpochRecord* record = atomic_load(&epoch_records); record; record = record->next) {
+        const uint64_t epoch = atomic_load(&record->epoch);
+        if (epoch && epoch < oldest) oldest = epoch;
     }
-    if (!contexts.capacity) {
-        contexts.capacity = CONTEXTS_CAPACITY;
-        contexts.data = malloc(CONTEXTS_CAPACITY * sizeof(struct GLContext));
+    return oldest;
+}
+
+static void _bolt_epoch_reclaim() {
+    const uint64_t oldest = _bolt_epoch_oldest_reader();
+    size_t kept = 0;
+    for (size_t i = 0; i < retired_count; i += 1) {
+        if (retired[i].epoch < oldest) free(retired[i].ptr);
+        else retired[kept++] = retired[i];
     }
-    for (size_t i = 0; i < contexts.capacity; i += 1) {
-        struct GLContext* ptr = &((struct GLContext*)(contexts.data))[i];
-        if (ptr->id == (uintptr_t)egl_context) {
-            current_context = ptr;
+    retired_count = kept;
+}
+
+// frees `ptr`, which has just been removed from the registry, once no reader can still have a pointer to it
+static void _bolt_epoch_retire(void* ptr) {
+    const uint64_t epoch = atomic_fetch_add(&global_epoch, 1);
+    if (retired_count == retired_capacity) {
+        const size_t capacity = retired_capacity ? retired_capacity * 2 : 16;
+        struct GLRetired* list = realloc(retired, capacity * sizeof(*list));
+        if (!list) {
+            // nowhere to keep it, so wait for the readers instead. lookups are short so this won't take long.
+            while (_bolt_epoch_oldest_reader() <= epoch) sched_yield();
+            free(ptr);
             return;
         }
+        retired = list;
+        retired_capacity = capacity;
     }
+    retired[retired_count++] = (struct GLRetired){.ptr = ptr, .epoch = epoch};
+    _bolt_epoch_reclaim();
 }
 
-void _bolt_destroy_context(void* egl_context) {
-    for (size_t i = 0; i < contexts.capacity; i += 1) {
-        struct GLContext* ptr = &((struct GLContext*)(contexts.data))[i];
-        if (ptr->id == (uintptr_t)egl_context) {
-            if (ptr->is_attached) {
-                ptr->deferred_destroy = 1;
-            } else {
-                _bolt_glcontext_free(ptr);
-                ptr->id = 0;
-            }
-            break;
+// open-addressing hash table of contexts by id, kept at most half full. removed entries are left as tombstones so that
+// probing doesn't stop early, and are cleared out when the table is rebuilt.
+#define CONTEXT_TOMBSTONE ((struct GLContext*)1)
+#define CONTEXT_HASH(ID, MASK) ((size_t)(((uint64_t)(ID) * 0x9E3779B97F4A7C15ull) >> 32) & (MASK))
+struct GLContextTable {
+    size_t capacity;
+    size_t used; // live entries and tombstones
+    _Atomic(struct GLContext*) slots[];
+};
+static _Atomic(struct GLContextTable*) context_table = NULL;
+
+// readers must be in an epoch, or be a writer. contexts that have been destroyed are skipped, since EGL can give their
+// id to a new context as soon as they're no longer current, which can be before we've finished with them.
+static struct GLContext* _bolt_registry_find(uintptr_t id) {
+    struct GLContextTable* table = atomic_load(&context_table);
+    if (!table) return NULL;
+    const size_t mask = table->capacity - 1;
+    for (size_t i = CONTEXT_HASH(id, mask);; i = (i + 1) & mask) {
+        struct GLContext* ptr = atomic_load(&table->slots[i]);
+        if (!ptr) return NULL;
+        if (ptr != CONTEXT_TOMBSTONE && ptr->id == id && !(atomic_load(&ptr->state) & CONTEXT_DESTROYED)) return ptr;
+    }
+}
+
+static uint8_t _bolt_registry_insert(struct GLContext* context) {
+    struct GLContextTable* table = atomic_load(&context_table);
+    if (!table || (table->used + 1) * 2 > table->capacity) {
+        size_t live = 0;
+        for (size_t i = 0; table && i < table->capacity; i += 1) {
+            struct GLContext* ptr = atomic_load(&table->slots[i]);
+            if (ptr && ptr != CONTEXT_TOMBSTONE) live += 1;
         }
+        size_t capacity = CONTEXT_TABLE_MIN_CAPACITY;
+        while (capacity < (live + 1) * 4) capacity *= 2;
+        struct GLContextTable* new_table = calloc(1, sizeof(*new_table) + (capacity * sizeof(*new_table->slots)));
+        if (!new_table) return 0;
+        new_table->capacity = capacity;
+        for (size_t i = 0; table && i < table->capacity; i += 1) {
+            struct GLContext* ptr = atomic_load(&table->slots[i]);
+            if (!ptr || ptr == CONTEXT_TOMBSTONE) continue;
+            size_t j = CONTEXT_HASH(ptr->id, capacity - 1);
+            while (atomic_load(&new_table->slots[j])) j = (j + 1) & (capacity - 1);
+            atomic_store(&new_table->slots[j], ptr);
+            new_table->used += 1;
+        }
+        atomic_store(&context_table, new_table);
+        if (table) _bolt_epoch_retire(table);
+        table = new_table;
+    }
+    const size_t mask = table->capacity - 1;
+    size_t i = CONTEXT_HASH(context->id, mask);
+    while (1) {
+        struct GLContext* ptr = atomic_load(&table->slots[i]);
+        if (!ptr) table->used += 1;
+        if (!ptr || ptr == CONTEXT_TOMBSTONE) break;
+        i = (i + 1) & mask;
+    }
+    atomic_store(&table->slots[i], context);
+    return 1;
+}
+
+static void _bolt_registry_remove(struct GLContext* context) {
+    struct GLContextTable* table = atomic_load(&context_table);
+    if (!table) return;
+    const size_t mask = table->capacity - 1;
+    for (size_t i = CONTEXT_HASH(context->id, mask);; i = (i + 1) & mask) {
+        struct GLContext* ptr = atomic_load(&table->slots[i]);
+        if (!ptr) return;
+        if (ptr == context) {
+            atomic_store(&table->slots[i], CONTEXT_TOMBSTONE);
+            return;
+        }
+    }
+}
+
+struct GLContext* _bolt_context() {
+    return current_context;
+}
+
+struct GLContext* _bolt_create_context(void* egl_context, void* shared) {
+    struct GLContext* context = malloc(sizeof(*context));
+    if (!context) return NULL;
+    _bolt_glcontext_init(context, egl_context, shared);
+    if (!context->share_group) {
+        free(context);
+        return NULL;
+    }
+    if (!_bolt_registry_insert(context)) {
+        _bolt_glcontext_free(context);
+        free(context);
+        return NULL;
+    }
+    return context;
+}
+
+// a context that's destroyed while it's current can't be freed until it's made not current. attaching and destroying
+// each set their own bit in the context's state and look at the other one in the same atomic operation, so exactly one
+// of the two threads involved sees both bits and is the one that finishes destroying it.
+struct GLContext* _bolt_make_context_current(void* egl_context) {
+    struct GLContext* destroyed = NULL;
+    if (current_context) {
+        if (atomic_fetch_and(&current_context->state, ~CONTEXT_ATTACHED) & CONTEXT_DESTROYED) destroyed = current_context;
+        current_context = NULL;
+    }
+    struct GLEpochRecord* record = egl_context ? _bolt_epoch_record() : NULL;
+    if (record) {
+        atomic_store(&record->epoch, atomic_load(&global_epoch));
+        struct GLContext* context = _bolt_registry_find((uintptr_t)egl_context);
+        uint32_t state = context ? atomic_load(&context->state) : CONTEXT_DESTROYED;
+        while (!(state & CONTEXT_DESTROYED) && !atomic_compare_exchange_weak(&context->state, &state, state | CONTEXT_ATTACHED));
+        if (!(state & CONTEXT_DESTROYED)) current_context = context;
+        atomic_store(&record->epoch, 0);
+    }
+    return destroyed;
+}
+
+struct GLShareGroup* _bolt_destroy_context(void* egl_context) {
+    struct GLContext* context = _bolt_registry_find((uintptr_t)egl_context);
+    if (!context) return NULL;
+    if (atomic_fetch_or(&context->state, CONTEXT_DESTROYED) & CONTEXT_ATTACHED) return NULL;
+    return _bolt_free_context(context);
+}
+
+struct GLShareGroup* _bolt_free_context(struct GLContext* context) {
+    struct GLShareGroup* group = context->share_group;
+    const uint8_t orphaned = --group->context_count == 0 && group->refcount > 1;
+    _bolt_registry_remove(context);
+    _bolt_glcontext_free(context);
+    _bolt_epoch_retire(context);
+    return orphaned ? group : NULL;
+}
+
+void _bolt_share_group_ref(struct GLShareGroup* group) {
+    group->refcount += 1;
+}
+
+void _bolt_share_group_unref(struct GLShareGroup* group) {
+    if (--group->refcount) return;
+    // buffer shadows belong to the platform code's allocator, so they have to have been freed already
+    struct GLArrayBuffer* buffers = group->buffers.data;
+    for (size_t i = 0; i < group->buffers.count; i += 1) {
+        free(buffers[i].dirty);
+        free(buffers[i].page_sums);
     }
+    struct GLTexture2D* textures = group->textures.data;
+    for (size_t i = 0; i < group->textures.count; i += 1) _bolt_texture_free(&textures[i]);
+    _bolt_list_free(&group->programs);
+    _bolt_list_free(&group->buffers);
+    _bolt_list_free(&group->textures);
+    free(group->dirty_buffers.ids);
+    pthread_mutex_destroy(&group->buffers_lock);
+    pthread_mutex_destroy(&group->programs_lock);
+    free(group);
 }
 
 void _bolt_set_attr_binding(struct GLAttrBinding* binding, unsigned int buffer, int size, const void* offset, unsigned int stride, uint32_t type, uint8_t normalise) {
@@ -130,128 +434,703 @@ void _bolt_set_attr_binding(struct GLAttrBinding* binding, unsigned int buffer,
     binding->stride = stride;
     binding->normalise = normalise;
     binding->type = type;
+    _bolt_attr_resolve(binding);
 }
 
-uint8_t _bolt_get_attr_binding(struct GLContext* c, const struct GLAttrBinding* binding, size_t index, size_t num_out, float* out) {
-    struct GLArrayBuffer* buffer = _bolt_find_buffer(c->shared_buffers, binding->buffer);
-    if (!buffer || !buffer->data) return 0;
-    uintptr_t buf_offset = binding->offset + (binding->stride * index);
-
-    const void* ptr = buffer->data + buf_offset;
-    if (!binding->normalise) {
-        switch (binding->type) {
-            case GL_FLOAT:
-                memcpy(out, ptr, num_out * sizeof(float));
-                break;
-            case GL_UNSIGNED_BYTE:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(uint8_t*)(ptr + i);
-                break;
-            case GL_UNSIGNED_SHORT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(uint16_t*)(ptr + (i * 2));
-                break;
-            case GL_UNSIGNED_INT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(uint32_t*)(ptr + (i * 4));
-                break;
-            case GL_BYTE:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(int8_t*)(ptr + i);
-                break;
-            case GL_SHORT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(int16_t*)(ptr + (i * 2));
-                break;
-            case GL_INT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = (float)*(int32_t*)(ptr + (i * 4));
-                break;
-            default:
-                printf("warning: unsupported non-normalise type %u\n", binding->type);
-                memset(out, 0, num_out * sizeof(float));
-                break;
-        }
-    } else {
-        switch (binding->type) {
-            case GL_FLOAT:
-                memcpy(out, ptr, num_out * sizeof(float));
-                break;
-            case GL_UNSIGNED_BYTE:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = ((float)*(uint8_t*)(ptr + i)) / 255.0;
-                break;
-            case GL_UNSIGNED_SHORT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = ((float)*(uint16_t*)(ptr + (i * 2))) / 65535.0;
-                break;
-            case GL_UNSIGNED_INT:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = ((float)*(uint32_t*)(ptr + (i * 4))) / 4294967295.0;
-                break;
-            case GL_BYTE:
-                for (size_t i = 0; i < num_out; i += 1) out[i] = ((((float)*(int8_t*)(ptr + i)) + 128.0) * 2.0 / 255.0) - 1.0;
-                break;
-            default:
-                printf("warning: unsupported normalise type %u\n", binding->type);
-                memset(out, 0, num_out * sizeof(float));
-                break;
-        }
-    }
-    return 1;
+uint8_t _bolt_get_attr_binding(struct GLContext* c, const struct GLAttrBinding* binding, size_t index, size_t num_out, float* out, uint32_t generation) {
+    return _bolt_get_attr_bindings(c, binding, NULL, index, 1, num_out, out, generation);
+}
+
+uint8_t _bolt_get_attr_bindings(struct GLContext* c, const struct GLAttrBinding* binding, const uint16_t* indices, size_t first, size_t count, size_t num_out, float* out, uint32_t generation) {
+    pthread_mutex_lock(c->shared_buffers_lock);
+    struct GLArrayBuffer* buffer = _bolt_find_current_buffer(c->shared_buffers, binding->buffer, generation);
+    const void* data = buffer ? buffer->data : NULL;
+    const size_t capacity = buffer ? buffer->capacity : 0;
+    pthread_mutex_unlock(c->shared_buffers_lock);
+    return _bolt_attr_decode(binding, data, capacity, indices, first, count, num_out, out);
 }
 
 void _bolt_glcontext_init(struct GLContext* context, void* egl_context, void* egl_shared) {
-    struct GLContext* shared = NULL;
+    struct GLShareGroup* group = NULL;
     if (egl_shared) {
-        for (size_t i = 0; i < contexts.capacity; i += 1) {
-            struct GLContext* ptr = &((struct GLContext*)(contexts.data))[i];
-            if (ptr->id == (uintptr_t)egl_shared) {
-                shared = ptr;
-                break;
-            }
-        }
+        const struct GLContext* shared = _bolt_registry_find((uintptr_t)egl_shared);
+        if (shared) group = shared->share_group;
     }
     memset(context, 0, sizeof(*context));
     context->id = (uintptr_t)egl_context;
-    if (shared) {
-        context->shared_programs = &shared->programs;
-        context->shared_buffers = &shared->buffers;
-        context->shared_textures = &shared->textures;
-    } else {
-        context->is_shared_owner = 1;
-        context->programs.pointers = calloc(PTR_LIST_CAPACITY, sizeof(void*));
-        context->buffers.pointers = calloc(PTR_LIST_CAPACITY, sizeof(void*));
-        context->textures.pointers = calloc(PTR_LIST_CAPACITY, sizeof(void*));
-        context->shared_programs = &context->programs;
-        context->shared_buffers = &context->buffers;
-        context->shared_textures = &context->textures;
+    context->vertex_array = &context->default_vertex_array;
+    if (!group) {
+        group = calloc(1, sizeof(*group));
+        if (!group) return;
+        pthread_mutex_init(&group->buffers_lock, NULL);
+        pthread_mutex_init(&group->programs_lock, NULL);
     }
+    _bolt_share_group_ref(group);
+    group->context_count += 1;
+    context->share_group = group;
+    context->shared_programs = &group->programs;
+    context->shared_buffers = &group->buffers;
+    context->shared_textures = &group->textures;
+    context->shared_buffers_lock = &group->buffers_lock;
+    context->shared_programs_lock = &group->programs_lock;
+    context->shared_dirty_buffers = &group->dirty_buffers;
 }
 
 void _bolt_glcontext_free(struct GLContext* context) {
-    if (context->is_shared_owner) {
-        free(context->programs.pointers);
-        free(context->buffers.pointers);
-        free(context->textures.pointers);
-        free(context->programs.data);
-        free(context->buffers.data);
-        free(context->textures.data);
-    }
+    _bolt_list_free(&context->vertex_arrays);
+    _bolt_list_free(&context->framebuffers);
+    _bolt_list_free(&context->texture_targets);
+    _bolt_share_group_unref(context->share_group);
 }
 
-void _bolt_context_destroy_buffers(struct GLContext* context, unsigned int n, const unsigned int* list) {
+size_t _bolt_context_destroy_buffers(struct GLContext* context, unsigned int n, const unsigned int* list, struct GLBufferBlock* blocks) {
+    size_t count = 0;
     for (size_t i = 0; i < n; i += 1) {
         struct GLArrayBuffer* buffer = _bolt_find_buffer(context->shared_buffers, list[i]);
         if (!buffer) continue;
-        buffer->id = 0;
-        free(buffer->data);
-        buffer->data = NULL;
-        if (list[i] < PTR_LIST_CAPACITY) ((struct GLArrayBuffer**)(context->shared_buffers->pointers))[list[i]] = NULL;
-        if (context->shared_buffers->first_empty > list[i]) context->shared_buffers->first_empty = list[i];
+        if (buffer->data) blocks[count++] = (struct GLBufferBlock){.data = buffer->data, .capacity = buffer->capacity};
+        if (buffer->spare) blocks[count++] = (struct GLBufferBlock){.data = buffer->spare, .capacity = buffer->spare_capacity};
+        free(buffer->dirty);
+        free(buffer->page_sums);
+        _bolt_remove_buffer(context->shared_buffers, list[i]);
+    }
+    return count;
+}
+
+void _bolt_context_mark_buffer_dirty(struct GLContext* context, struct GLArrayBuffer* buffer, uint32_t offset, uint32_t length) {
+    if (!_bolt_buffer_mark_dirty(buffer, offset, length)) return;
+    struct GLDirtyBuffers* dirty = context->shared_dirty_buffers;
+    if (dirty->count == dirty->capacity) {
+        const size_t capacity = dirty->capacity ? dirty->capacity * 2 : 16;
+        unsigned int* ids = realloc(dirty->ids, capacity * sizeof(*ids));
+        if (!ids) {
+            // nothing would ever upload it, so it's better to lose track of it as dirty than to stay dirty forever
+            buffer->dirty_count = 0;
+            return;
+        }
+        dirty->ids = ids;
+        dirty->capacity = capacity;
+    }
+    dirty->ids[dirty->count++] = buffer->id;
+}
+
+// 64-bit checksum of part of a page. four independent lanes so that it isn't limited by multiply latency, and it only
+// has to tell whether a page has changed, not resist collisions on purpose.
+static uint64_t _bolt_page_checksum(const uint8_t* data, size_t length) {
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t lanes[4] = {length, prime, prime << 1, prime << 2};
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        uint64_t words[4];
+        memcpy(words, data + i, sizeof(words));
+        for (size_t j = 0; j < 4; j += 1) lanes[j] = (lanes[j] ^ words[j]) * prime;
+    }
+    for (; i < length; i += 1) lanes[0] = (lanes[0] ^ data[i]) * prime;
+    uint64_t sum = 0;
+    for (size_t j = 0; j < 4; j += 1) sum = ((sum ^ lanes[j]) * prime) ^ (lanes[j] >> 29);
+    return sum;
+}
+
+// gets the part of a buffer's shadow that's mapped, as [start, end)
+static void _bolt_mapped_range(const struct GLArrayBuffer* buffer, size_t* start, size_t* end) {
+    *start = buffer->mapping_offset < 0 ? 0 : (size_t)buffer->mapping_offset;
+    *end = *start + buffer->mapping_len;
+    if (*end > buffer->capacity) *end = buffer->capacity;
+    if (*start > *end) *start = *end;
+}
+
+// pages are numbered from the first one in the mapping, and each page's checksum only covers the part of it that's
+// inside the mapping, since nothing outside the mapping can have been written through it.
+uint8_t _bolt_buffer_snapshot_pages(struct GLArrayBuffer* buffer, size_t page_size) {
+    size_t start, end;
+    _bolt_mapped_range(buffer, &start, &end);
+    buffer->page_sums_count = 0;
+    if (start == end) return 0;
+    const size_t count = ((end - 1) / page_size) - (start / page_size) + 1;
+    if (count > buffer->page_sums_capacity) {
+        uint64_t* sums = realloc(buffer->page_sums, count * sizeof(*sums));
+        if (!sums) return 0;
+        buffer->page_sums = sums;
+        buffer->page_sums_capacity = count;
+    }
+    const uint8_t* data = buffer->data;
+    for (size_t page = 0, pos = start; pos < end; page += 1) {
+        const size_t next = (pos & ~(page_size - 1)) + page_size < end ? (pos & ~(page_size - 1)) + page_size : end;
+        buffer->page_sums[page] = _bolt_page_checksum(data + pos, next - pos);
+        pos = next;
+    }
+    buffer->page_sums_count = count;
+    return 1;
+}
+
+size_t _bolt_context_mark_written_pages(struct GLContext* context, struct GLArrayBuffer* buffer, size_t page_size) {
+    size_t start, end;
+    _bolt_mapped_range(buffer, &start, &end);
+    const uint8_t* data = buffer->data;
+    size_t marked = 0;
+    for (size_t page = 0, pos = start; pos < end && page < buffer->page_sums_count; page += 1) {
+        const size_t next = (pos & ~(page_size - 1)) + page_size < end ? (pos & ~(page_size - 1)) + page_size : end;
+        if (_bolt_page_checksum(data + pos, next - pos) != buffer->page_sums[page]) {
+            _bolt_context_mark_buffer_dirty(context, buffer, pos, next - pos);
+            marked += next - pos;
+        }
+        pos = next;
+    }
+    buffer->page_sums_count = 0;
+    return marked;
+}
+
+size_t _bolt_context_buffer_upload_count(struct GLContext* context) {
+    const struct GLDirtyBuffers* dirty = context->shared_dirty_buffers;
+    size_t count = 0;
+    for (size_t i = 0; i < dirty->count; i += 1) {
+        const struct GLArrayBuffer* buffer = _bolt_find_buffer(context->shared_buffers, dirty->ids[i]);
+        if (buffer && buffer->data) count += buffer->dirty_count;
+    }
+    return count;
+}
+
+size_t _bolt_context_take_buffer_uploads(struct GLContext* context, struct GLBufferUpload* uploads) {
+    struct GLDirtyBuffers* dirty = context->shared_dirty_buffers;
+    size_t count = 0;
+    for (size_t i = 0; i < dirty->count; i += 1) {
+        struct GLArrayBuffer* buffer = _bolt_find_buffer(context->shared_buffers, dirty->ids[i]);
+        if (!buffer) continue;
+        for (uint32_t j = 0; buffer->data && j < buffer->dirty_count; j += 1) {
+            const struct GLBufferRange* range = &buffer->dirty[j];
+            uploads[count++] = (struct GLBufferUpload){.data = (uint8_t*)buffer->data + range->start, .buffer = buffer->id, .offset = range->start, .length = range->end - range->start};
+        }
+        buffer->dirty_count = 0;
+    }
+    dirty->count = 0;
+    return count;
+}
+
+unsigned int _bolt_context_buffer_binding(struct GLContext* context, uint32_t target) {
+    if (target == GL_ARRAY_BUFFER) return context->array_buffer_binding;
+    if (target != GL_ELEMENT_ARRAY_BUFFER) return 0;
+    return context->vertex_array->element_buffer;
+}
+
+void _bolt_context_bind_buffer(struct GLContext* context, uint32_t target, unsigned int buffer) {
+    if (target == GL_ARRAY_BUFFER) {
+        context->array_buffer_binding = buffer;
+    } else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        context->vertex_array->element_buffer = buffer;
+    }
+}
+
+// the bound VAO is kept as a pointer into the context's list, which moves when the list grows or something is removed
+// from it. the only places that happen are here and _bolt_context_delete_vertex_arrays, and both re-find it after.
+void _bolt_context_bind_vertex_array(struct GLContext* context, unsigned int vao) {
+    context->vertex_array_binding = vao;
+    struct GLVertexArray* array = vao ? _bolt_get_vertex_array(&context->vertex_arrays, vao) : NULL;
+    context->vertex_array = array ? array : &context->default_vertex_array;
+}
+
+void _bolt_context_bind_texture(struct GLContext* context, uint32_t target, unsigned int texture) {
+    if (target == GL_TEXTURE_2D && context->active_texture_unit < MAX_TEXTURE_UNITS) {
+        context->texture_units[context->active_texture_unit] = texture;
+    } else if (target != GL_TEXTURE_2D && texture) {
+        struct GLTextureTarget* other = _bolt_get_texture_target(&context->texture_targets, texture);
+        if (other) other->target = target;
+    }
+}
+
+void _bolt_context_bind_unit_texture(struct GLContext* context, unsigned int unit, unsigned int texture) {
+    if (unit >= MAX_TEXTURE_UNITS) return;
+    if (!texture || !_bolt_find_texture_target(&context->texture_targets, texture)) context->texture_units[unit] = texture;
+}
+
+unsigned int _bolt_context_texture_binding(struct GLContext* context) {
+    return _bolt_context_unit_texture_binding(context, context->active_texture_unit);
+}
+
+unsigned int _bolt_context_unit_texture_binding(struct GLContext* context, unsigned int unit) {
+    return unit < MAX_TEXTURE_UNITS ? context->texture_units[unit] : 0;
+}
+
+void _bolt_context_unbind_buffers(struct GLContext* context, unsigned int n, const unsigned int* list) {
+    // GL only unbinds deleted buffers from the current VAO, so that's all that needs checking here
+    const unsigned int element_buffer = _bolt_context_buffer_binding(context, GL_ELEMENT_ARRAY_BUFFER);
+    for (size_t i = 0; i < n; i += 1) {
+        if (!list[i]) continue;
+        if (list[i] == context->array_buffer_binding) context->array_buffer_binding = 0;
+        if (list[i] == element_buffer) _bolt_context_bind_buffer(context, GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 }
 
-void _bolt_context_destroy_textures(struct GLContext* context, unsigned int n, const unsigned int* list) {
+void _bolt_context_unbind_textures(struct GLContext* context, unsigned int n, const unsigned int* list) {
     for (size_t i = 0; i < n; i += 1) {
-        struct GLTexture2D* tex = _bolt_find_texture(context->shared_textures, list[i]);
+        if (!list[i]) continue;
+        for (size_t unit = 0; unit < MAX_TEXTURE_UNITS; unit += 1) {
+            if (context->texture_units[unit] == list[i]) context->texture_units[unit] = 0;
+        }
+        _bolt_remove_texture_target(&context->texture_targets, list[i]);
+    }
+}
+
+void _bolt_context_delete_vertex_arrays(struct GLContext* context, unsigned int n, const unsigned int* list) {
+    for (size_t i = 0; i < n; i += 1) {
+        if (!list[i]) continue;
+        if (list[i] == context->vertex_array_binding) context->vertex_array_binding = 0;
+        _bolt_remove_vertex_array(&context->vertex_arrays, list[i]);
+    }
+    _bolt_context_bind_vertex_array(context, context->vertex_array_binding);
+}
+
+unsigned int _bolt_context_render_target(struct GLContext* context) {
+    if (!context->current_draw_framebuffer) return 0;
+    const struct GLFramebuffer* framebuffer = _bolt_find_framebuffer(&context->framebuffers, context->current_draw_framebuffer);
+    return framebuffer ? framebuffer->texture : 0;
+}
+
+void _bolt_context_attach_texture(struct GLContext* context, uint32_t target, unsigned int texture) {
+    const unsigned int bound = target == GL_READ_FRAMEBUFFER ? context->current_read_framebuffer : context->current_draw_framebuffer;
+    if (!bound) return;
+    struct GLFramebuffer* framebuffer = texture ? _bolt_get_framebuffer(&context->framebuffers, bound) : _bolt_find_framebuffer(&context->framebuffers, bound);
+    if (framebuffer) framebuffer->texture = texture;
+}
+
+void _bolt_context_delete_framebuffers(struct GLContext* context, unsigned int n, const unsigned int* list) {
+    for (size_t i = 0; i < n; i += 1) {
+        if (!list[i]) continue;
+        // deleting a bound framebuffer binds 0 in its place
+        if (list[i] == context->current_draw_framebuffer) context->current_draw_framebuffer = 0;
+        if (list[i] == context->current_read_framebuffer) context->current_read_framebuffer = 0;
+        _bolt_remove_framebuffer(&context->framebuffers, list[i]);
+    }
+}
+
+void _bolt_context_set_attr(struct GLContext* context, unsigned int index, int size, const void* offset, unsigned int stride, uint32_t type, uint8_t normalise) {
+    if (index >= MAX_VERTEX_ATTRIBS) return;
+    struct GLVertexArray* vao = context->vertex_array;
+    _bolt_set_attr_binding(&vao->attributes[index], context->array_buffer_binding, size, offset, stride, type, normalise);
+    vao->layout += 1;
+}
+
+void _bolt_context_enable_attr(struct GLContext* context, unsigned int index, uint8_t enabled) {
+    if (index >= MAX_VERTEX_ATTRIBS) return;
+    struct GLVertexArray* vao = context->vertex_array;
+    vao->attributes[index].enabled = enabled;
+    vao->layout += 1;
+}
+
+const struct GLVertexFetcher* _bolt_context_vertex_fetcher(struct GLContext* context) {
+    struct GLVertexArray* vao = context->vertex_array;
+    struct GLVertexFetcher* fetcher = &vao->fetcher;
+    const struct GLProgram* p = &context->current_program;
+    // program 0 never gets a fetcher, so a VAO that's never had one built can't match
+    if (fetcher->program == p->id && fetcher->link == p->link && fetcher->layout == vao->layout && p->id) return fetcher;
+    if (p->loc_aVertexPosition2D >= MAX_VERTEX_ATTRIBS || p->loc_aVertexColour >= MAX_VERTEX_ATTRIBS || p->loc_aTextureUV >= MAX_VERTEX_ATTRIBS ||
+        p->loc_aTextureUVAtlasMin >= MAX_VERTEX_ATTRIBS || p->loc_aTextureUVAtlasExtents >= MAX_VERTEX_ATTRIBS) return NULL;
+    fetcher->program = p->id;
+    fetcher->link = p->link;
+    fetcher->layout = vao->layout;
+    fetcher->aVertexPosition2D = vao->attributes[p->loc_aVertexPosition2D];
+    fetcher->aVertexColour = vao->attributes[p->loc_aVertexColour];
+    fetcher->aTextureUV = vao->attributes[p->loc_aTextureUV];
+    fetcher->aTextureUVAtlasMin = vao->attributes[p->loc_aTextureUVAtlasMin];
+    fetcher->aTextureUVAtlasExtents = vao->attributes[p->loc_aTextureUVAtlasExtents];
+    return fetcher;
+}
+
+void _bolt_share_group_destroy_textures(struct GLShareGroup* group, unsigned int n, const unsigned int* list) {
+    for (size_t i = 0; i < n; i += 1) {
+        struct GLTexture2D* tex = _bolt_find_texture(&group->textures, list[i]);
         if (!tex) continue;
-        free(tex->data);
-        tex->data = NULL;
-        tex->width = 0;
-        tex->height = 0;
-        if (list[i] < PTR_LIST_CAPACITY) ((struct GLTexture2D**)(context->shared_textures->pointers))[list[i]] = NULL;
-        if (context->shared_textures->first_empty > list[i]) context->shared_textures->first_empty = list[i];
+        if (group->sprites) _bolt_sprite_index_clear(group->sprites, list[i]);
+        _bolt_texture_free(tex);
+        _bolt_remove_texture(&group->textures, list[i]);
+    }
+}
+
+// number of bytes per pixel that a texture with the given internal format is stored with. compressed textures are
+// stored decoded, and anything not listed is assumed to fit in RGBA.
+static uint8_t _bolt_texture_bytes_per_pixel(uint32_t internalformat) {
+    switch (internalformat) {
+        case GL_R8: return 1;
+        case GL_RG8: return 2;
+        default: return 4;
+    }
+}
+
+// number of channels in an uncompressed upload format
+static uint8_t _bolt_texture_format_channels(uint32_t format) {
+    switch (format) {
+        case GL_RED: return 1;
+        case GL_RG: return 2;
+        default: return 4;
+    }
+}
+
+size_t _bolt_texture_upload_size(uint32_t format, unsigned int w, unsigned int h) {
+    const size_t block_size = _bolt_dxt_block_size(format);
+    if (block_size) return ((w + 3) / 4) * ((h + 3) / 4) * block_size;
+    return (size_t)w * h * _bolt_texture_format_channels(format);
+}
+
+// copies `count` pixels between channel layouts, the same way GL expands them when sampling: missing colour
+// channels become 0 and missing alpha becomes 255
+static void _bolt_convert_pixels(uint8_t* out, uint8_t out_channels, const uint8_t* in, uint8_t in_channels, size_t count) {
+    if (out_channels == in_channels) {
+        memcpy(out, in, count * out_channels);
+        return;
+    }
+    for (size_t i = 0; i < count; i += 1) {
+        for (uint8_t c = 0; c < out_channels; c += 1) {
+            out[c] = (c < in_channels) ? in[c] : ((c == 3) ? 255 : 0);
+        }
+        out += out_channels;
+        in += in_channels;
+    }
+}
+
+static uint8_t _bolt_rect_contains(unsigned int x, unsigned int y, unsigned int w, unsigned int h, const struct GLTextureUpload* u) {
+    return u->x >= x && u->y >= y && u->x + u->w <= x + w && u->y + u->h <= y + h;
+}
+
+// gets the pixel bounds of a tile, which are smaller than TEXTURE_TILE_SIZE along the right and bottom edges
+static void _bolt_texture_tile_rect(const struct GLTexture2D* tex, unsigned int tx, unsigned int ty, unsigned int* x0, unsigned int* y0, unsigned int* x1, unsigned int* y1) {
+    *x0 = tx * TEXTURE_TILE_SIZE;
+    *y0 = ty * TEXTURE_TILE_SIZE;
+    *x1 = (*x0 + TEXTURE_TILE_SIZE > tex->width) ? tex->width : *x0 + TEXTURE_TILE_SIZE;
+    *y1 = (*y0 + TEXTURE_TILE_SIZE > tex->height) ? tex->height : *y0 + TEXTURE_TILE_SIZE;
+}
+
+static void _bolt_texture_drop_upload(struct GLTexture2D* tex, size_t i) {
+    struct GLTextureUpload* upload = tex->uploads[i];
+    const size_t size = sizeof(*upload) + _bolt_texture_upload_size(upload->format, upload->data_width, upload->data_height);
+    tex->journal_bytes -= size;
+    tex->resident_bytes -= size;
+    free(upload);
+    tex->uploads[i] = NULL;
+}
+
+// drops the texture's reference to a tile's pixels, freeing them if nothing else is using them
+static void _bolt_texture_release_tile(struct GLTexture2D* tex, struct GLTextureTile* tile) {
+    if (!tile->pixels) return;
+    tex->resident_bytes -= tile->pixels->size;
+    tile->pixels->refcount -= 1;
+    if (!tile->pixels->refcount) free(tile->pixels);
+    tile->pixels = NULL;
+}
+
+// gets a tile's pixels ready to be written to, allocating them if this is the first write or taking a private copy
+// of them if they're shared with another tile
+static uint8_t* _bolt_texture_writable_tile(struct GLTexture2D* tex, unsigned int tx, unsigned int ty) {
+    struct GLTextureTile* tile = &tex->tiles[(ty * tex->tiles_wide) + tx];
+    if (!tile->pixels) {
+        unsigned int x0, y0, x1, y1;
+        _bolt_texture_tile_rect(tex, tx, ty, &x0, &y0, &x1, &y1);
+        const uint32_t size = (x1 - x0) * (y1 - y0) * tex->bytes_per_pixel;
+        tile->pixels = calloc(sizeof(*tile->pixels) + size, 1);
+        tile->pixels->refcount = 1;
+        tile->pixels->size = size;
+        tex->resident_bytes += size;
+    } else if (tile->pixels->refcount > 1) {
+        struct GLTilePixels* copy = malloc(sizeof(*copy) + tile->pixels->size);
+        copy->refcount = 1;
+        copy->size = tile->pixels->size;
+        memcpy(copy->data, tile->pixels->data, copy->size);
+        tile->pixels->refcount -= 1;
+        tile->pixels = copy;
+    }
+    return tile->pixels->data;
+}
+
+static void _bolt_texture_compact_uploads(struct GLTexture2D* tex) {
+    size_t count = 0;
+    for (size_t i = 0; i < tex->upload_count; i += 1) {
+        if (tex->uploads[i]) tex->uploads[count++] = tex->uploads[i];
+    }
+    tex->upload_count = count;
+}
+
+// decodes the part of `upload` that intersects the tile (tx, ty) into the tile's pixels, converting to the
+// texture's format if necessary
+static void _bolt_texture_apply(struct GLTexture2D* tex, const struct GLTextureUpload* upload, unsigned int tx, unsigned int ty) {
+    unsigned int tile_x, tile_y, x1, y1;
+    _bolt_texture_tile_rect(tex, tx, ty, &tile_x, &tile_y, &x1, &y1);
+    const size_t pitch = (x1 - tile_x) * tex->bytes_per_pixel;
+    unsigned int x0 = tile_x, y0 = tile_y;
+    if (upload->x > x0) x0 = upload->x;
+    if (upload->y > y0) y0 = upload->y;
+    if (upload->x + upload->w < x1) x1 = upload->x + upload->w;
+    if (upload->y + upload->h < y1) y1 = upload->y + upload->h;
+    if (x0 >= x1 || y0 >= y1) return;
+    uint8_t* out = tex->tiles[(ty * tex->tiles_wide) + tx].pixels->data + ((y0 - tile_y) * pitch) + ((x0 - tile_x) * tex->bytes_per_pixel);
+    if (_bolt_dxt_block_size(upload->format)) {
+        if (tex->bytes_per_pixel == 4) {
+            _bolt_dxt_decode_region(upload->format, upload->data, upload->data_width, upload->data_height, x0 - upload->x, y0 - upload->y, x1 - x0, y1 - y0, out, pitch);
+            return;
+        }
+        uint8_t rgba[TEXTURE_TILE_SIZE * TEXTURE_TILE_SIZE * 4];
+        const size_t rgba_pitch = (x1 - x0) * 4;
+        _bolt_dxt_decode_region(upload->format, upload->data, upload->data_width, upload->data_height, x0 - upload->x, y0 - upload->y, x1 - x0, y1 - y0, rgba, rgba_pitch);
+        for (unsigned int y = y0; y < y1; y += 1) {
+            _bolt_convert_pixels(out, tex->bytes_per_pixel, rgba + ((y - y0) * rgba_pitch), 4, x1 - x0);
+            out += pitch;
+        }
+    } else {
+        const uint8_t channels = _bolt_texture_format_channels(upload->format);
+        const size_t in_pitch = upload->data_width * channels;
+        const uint8_t* in = upload->data + ((y0 - upload->y) * in_pitch) + ((x0 - upload->x) * channels);
+        for (unsigned int y = y0; y < y1; y += 1) {
+            _bolt_convert_pixels(out, tex->bytes_per_pixel, in, channels, x1 - x0);
+            out += pitch;
+            in += in_pitch;
+        }
+    }
+}
+
+static void _bolt_texture_decode_tile(struct GLTexture2D* tex, unsigned int tx, unsigned int ty) {
+    struct GLTextureTile* tile = &tex->tiles[(ty * tex->tiles_wide) + tx];
+    if (tile->seq == tex->upload_seq) return;
+    unsigned int x0, y0, x1, y1;
+    _bolt_texture_tile_rect(tex, tx, ty, &x0, &y0, &x1, &y1);
+    uint8_t removed = 0;
+    for (size_t i = 0; i < tex->upload_count; i += 1) {
+        struct GLTextureUpload* upload = tex->uploads[i];
+        if (upload->seq <= tile->seq) continue;
+        if (upload->x >= x1 || upload->y >= y1 || upload->x + upload->w <= x0 || upload->y + upload->h <= y0) continue;
+        _bolt_texture_writable_tile(tex, tx, ty);
+        _bolt_texture_apply(tex, upload, tx, ty);
+        upload->pending_tiles -= 1;
+        if (!upload->pending_tiles) {
+            _bolt_texture_drop_upload(tex, i);
+            removed = 1;
+        }
     }
+    if (removed) _bolt_texture_compact_uploads(tex);
+    tile->seq = tex->upload_seq;
+}
+
+// marks a tile as up to date without applying anything to it, for when its contents are about to be replaced wholesale
+static void _bolt_texture_discard_tile(struct GLTexture2D* tex, unsigned int tx, unsigned int ty) {
+    struct GLTextureTile* tile = &tex->tiles[(ty * tex->tiles_wide) + tx];
+    if (tile->seq == tex->upload_seq) return;
+    unsigned int x0, y0, x1, y1;
+    _bolt_texture_tile_rect(tex, tx, ty, &x0, &y0, &x1, &y1);
+    uint8_t removed = 0;
+    for (size_t i = 0; i < tex->upload_count; i += 1) {
+        struct GLTextureUpload* upload = tex->uploads[i];
+        if (upload->seq <= tile->seq) continue;
+        if (upload->x >= x1 || upload->y >= y1 || upload->x + upload->w <= x0 || upload->y + upload->h <= y0) continue;
+        upload->pending_tiles -= 1;
+        if (!upload->pending_tiles) {
+            _bolt_texture_drop_upload(tex, i);
+            removed = 1;
+        }
+    }
+    if (removed) _bolt_texture_compact_uploads(tex);
+    tile->seq = tex->upload_seq;
+}
+
+// appends an upload to the journal, taking ownership of it. must already be clipped to the texture.
+static void _bolt_texture_journal(struct GLTexture2D* tex, struct GLTextureUpload* upload) {
+    // anything that this upload completely covers will never be visible again, so it can be dropped right away
+    uint8_t removed = 0;
+    for (size_t i = 0; i < tex->upload_count; i += 1) {
+        if (_bolt_rect_contains(upload->x, upload->y, upload->w, upload->h, tex->uploads[i])) {
+            _bolt_texture_drop_upload(tex, i);
+            removed = 1;
+        }
+    }
+    if (removed) _bolt_texture_compact_uploads(tex);
+
+    if (tex->upload_count >= tex->upload_capacity) {
+        tex->upload_capacity = tex->upload_capacity ? tex->upload_capacity * 2 : 16;
+        tex->uploads = realloc(tex->uploads, tex->upload_capacity * sizeof(*tex->uploads));
+    }
+    const unsigned int tx0 = upload->x / TEXTURE_TILE_SIZE;
+    const unsigned int ty0 = upload->y / TEXTURE_TILE_SIZE;
+    const unsigned int tx1 = (upload->x + upload->w - 1) / TEXTURE_TILE_SIZE;
+    const unsigned int ty1 = (upload->y + upload->h - 1) / TEXTURE_TILE_SIZE;
+    upload->pending_tiles = (tx1 - tx0 + 1) * (ty1 - ty0 + 1);
+    upload->seq = ++tex->upload_seq;
+    tex->uploads[tex->upload_count++] = upload;
+    const size_t size = sizeof(*upload) + _bolt_texture_upload_size(upload->format, upload->data_width, upload->data_height);
+    tex->journal_bytes += size;
+    tex->resident_bytes += size;
+
+    // decoding every tile the oldest upload touches is what frees it, see _bolt_texture_decode_tile
+    const size_t decoded_size = (size_t)tex->width * tex->height * tex->bytes_per_pixel;
+    while (tex->upload_count > TEXTURE_JOURNAL_MAX_UPLOADS || (tex->upload_count > 1 && tex->journal_bytes > decoded_size)) {
+        const struct GLTextureUpload* oldest = tex->uploads[0];
+        const unsigned int otx0 = oldest->x / TEXTURE_TILE_SIZE;
+        const unsigned int oty0 = oldest->y / TEXTURE_TILE_SIZE;
+        const unsigned int otx1 = (oldest->x + oldest->w - 1) / TEXTURE_TILE_SIZE;
+        const unsigned int oty1 = (oldest->y + oldest->h - 1) / TEXTURE_TILE_SIZE;
+        for (unsigned int ty = oty0; ty <= oty1; ty += 1) {
+            for (unsigned int tx = otx0; tx <= otx1; tx += 1) _bolt_texture_decode_tile(tex, tx, ty);
+        }
+    }
+}
+
+// reads (x, y, w, h), which must be inside the texture, with the given number of channels per pixel
+static void _bolt_texture_read_pixels(struct GLTexture2D* tex, unsigned int x, unsigned int y, unsigned int w, unsigned int h, uint8_t* out, size_t out_pitch, uint8_t channels) {
+    const uint8_t zero[4] = {0};
+    for (unsigned int ty = y / TEXTURE_TILE_SIZE; ty <= (y + h - 1) / TEXTURE_TILE_SIZE; ty += 1) {
+        for (unsigned int tx = x / TEXTURE_TILE_SIZE; tx <= (x + w - 1) / TEXTURE_TILE_SIZE; tx += 1) {
+            _bolt_texture_decode_tile(tex, tx, ty);
+            const struct GLTextureTile* tile = &tex->tiles[(ty * tex->tiles_wide) + tx];
+            unsigned int x0, y0, x1, y1;
+            _bolt_texture_tile_rect(tex, tx, ty, &x0, &y0, &x1, &y1);
+            const size_t pitch = (x1 - x0) * tex->bytes_per_pixel;
+            const unsigned int rx0 = (x > x0) ? x : x0;
+            const unsigned int ry0 = (y > y0) ? y : y0;
+            const unsigned int rx1 = (x + w < x1) ? x + w : x1;
+            const unsigned int ry1 = (y + h < y1) ? y + h : y1;
+            for (unsigned int row = ry0; row < ry1; row += 1) {
+                uint8_t* dst = out + ((row - y) * out_pitch) + ((rx0 - x) * channels);
+                if (tile->pixels) {
+                    _bolt_convert_pixels(dst, channels, tile->pixels->data + ((row - y0) * pitch) + ((rx0 - x0) * tex->bytes_per_pixel), tex->bytes_per_pixel, rx1 - rx0);
+                } else {
+                    for (unsigned int i = rx0; i < rx1; i += 1) _bolt_convert_pixels(dst + ((i - rx0) * channels), channels, zero, tex->bytes_per_pixel, 1);
+                }
+            }
+        }
+    }
+}
+
+void _bolt_texture_storage(struct GLTexture2D* tex, uint32_t internalformat, unsigned int width, unsigned int height) {
+    _bolt_texture_free(tex);
+    if (!width || !height) return;
+    tex->width = width;
+    tex->height = height;
+    tex->internalformat = internalformat;
+    tex->bytes_per_pixel = _bolt_texture_bytes_per_pixel(internalformat);
+    tex->tiles_wide = (width + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+    tex->tiles_high = (height + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+    tex->tiles = calloc((size_t)tex->tiles_wide * tex->tiles_high, sizeof(*tex->tiles));
+    tex->upload_seq = 0;
+    tex->resident_bytes = 0;
+}
+
+void _bolt_texture_upload(struct GLTexture2D* tex, uint32_t format, unsigned int x, unsigned int y, unsigned int w, unsigned int h, const void* data, size_t data_pitch) {
+    if (!tex->tiles || !data || !w || !h || x >= tex->width || y >= tex->height) return;
+    const size_t size = _bolt_texture_upload_size(format, w, h);
+    struct GLTextureUpload* upload = malloc(sizeof(*upload) + size);
+    upload->format = format;
+    upload->x = x;
+    upload->y = y;
+    upload->w = (x + w > tex->width) ? tex->width - x : w;
+    upload->h = (y + h > tex->height) ? tex->height - y : h;
+    upload->data_width = w;
+    upload->data_height = h;
+    const size_t row_size = _bolt_dxt_block_size(format) ? size : (size_t)w * _bolt_texture_format_channels(format);
+    if (data_pitch == 0 || data_pitch == row_size) {
+        memcpy(upload->data, data, size);
+    } else {
+        // padded rows get packed tightly, so the journal never holds more than it needs
+        for (unsigned int row = 0; row < h; row += 1) {
+            memcpy(upload->data + (row * row_size), (const uint8_t*)data + (row * data_pitch), row_size);
+        }
+    }
+    _bolt_texture_journal(tex, upload);
+}
+
+uint8_t _bolt_texture_copy(struct GLTexture2D* dst, unsigned int dst_x, unsigned int dst_y, struct GLTexture2D* src, unsigned int src_x, unsigned int src_y, unsigned int w, unsigned int h) {
+    if (!dst->tiles || !src->tiles || !w || !h) return 0;
+    if ((size_t)src_x + w > src->width || (size_t)src_y + h > src->height) return 0;
+    if ((size_t)dst_x + w > dst->width || (size_t)dst_y + h > dst->height) return 0;
+    const uint8_t can_share = (src->bytes_per_pixel == dst->bytes_per_pixel) &&
+        (src_x % TEXTURE_TILE_SIZE == dst_x % TEXTURE_TILE_SIZE) && (src_y % TEXTURE_TILE_SIZE == dst_y % TEXTURE_TILE_SIZE);
+    for (unsigned int ty = dst_y / TEXTURE_TILE_SIZE; ty <= (dst_y + h - 1) / TEXTURE_TILE_SIZE; ty += 1) {
+        for (unsigned int tx = dst_x / TEXTURE_TILE_SIZE; tx <= (dst_x + w - 1) / TEXTURE_TILE_SIZE; tx += 1) {
+            unsigned int x0, y0, x1, y1;
+            _bolt_texture_tile_rect(dst, tx, ty, &x0, &y0, &x1, &y1);
+            const unsigned int rx0 = (dst_x > x0) ? dst_x : x0;
+            const unsigned int ry0 = (dst_y > y0) ? dst_y : y0;
+            const unsigned int rx1 = (dst_x + w < x1) ? dst_x + w : x1;
+            const unsigned int ry1 = (dst_y + h < y1) ? dst_y + h : y1;
+            const unsigned int sx = rx0 - dst_x + src_x;
+            const unsigned int sy = ry0 - dst_y + src_y;
+
+            if (can_share && rx0 == x0 && ry0 == y0 && rx1 == x1 && ry1 == y1) {
+                // the whole destination tile is being replaced, so if it lines up with a source tile of exactly the
+                // same size, it can just point at the source tile's pixels
+                const unsigned int stx = sx / TEXTURE_TILE_SIZE;
+                const unsigned int sty = sy / TEXTURE_TILE_SIZE;
+                unsigned int sx0, sy0, sx1, sy1;
+                _bolt_texture_tile_rect(src, stx, sty, &sx0, &sy0, &sx1, &sy1);
+                if (sx1 - sx0 == x1 - x0 && sy1 - sy0 == y1 - y0) {
+                    _bolt_texture_decode_tile(src, stx, sty);
+                    struct GLTilePixels* pixels = src->tiles[(sty * src->tiles_wide) + stx].pixels;
+                    struct GLTextureTile* tile = &dst->tiles[(ty * dst->tiles_wide) + tx];
+                    _bolt_texture_discard_tile(dst, tx, ty);
+                    if (pixels) pixels->refcount += 1;
+                    _bolt_texture_release_tile(dst, tile);
+                    tile->pixels = pixels;
+                    if (pixels) dst->resident_bytes += pixels->size;
+                    continue;
+                }
+            }
+
+            // partially-covered tiles are copied for real, which means bringing them up to date first
+            _bolt_texture_decode_tile(dst, tx, ty);
+            uint8_t* out = _bolt_texture_writable_tile(dst, tx, ty);
+            const size_t pitch = (x1 - x0) * dst->bytes_per_pixel;
+            out += ((ry0 - y0) * pitch) + ((rx0 - x0) * dst->bytes_per_pixel);
+            _bolt_texture_read_pixels(src, sx, sy, rx1 - rx0, ry1 - ry0, out, pitch, dst->bytes_per_pixel);
+        }
+    }
+    return 1;
+}
+
+void _bolt_texture_upload_pixels(const struct GLTexture2D* tex, uint32_t format, unsigned int w, unsigned int h, const void* data, size_t data_pitch, uint8_t* out, size_t out_pitch) {
+    // the texture keeps the first bytes_per_pixel channels of whatever's uploaded, and reading expands them again
+    const uint8_t compressed = _bolt_dxt_block_size(format) != 0;
+    const uint8_t in_channels = compressed ? 4 : _bolt_texture_format_channels(format);
+    const uint8_t kept = (in_channels < tex->bytes_per_pixel) ? in_channels : tex->bytes_per_pixel;
+    if (compressed) _bolt_dxt_decode_region(format, data, w, h, 0, 0, w, h, out, out_pitch);
+    const size_t in_pitch = compressed ? out_pitch : (data_pitch ? data_pitch : (size_t)w * in_channels);
+    const uint8_t* in = compressed ? out : data;
+    for (unsigned int row = 0; row < h; row += 1) {
+        if (kept == 4) {
+            if (!compressed) memcpy(out, in, (size_t)w * 4);
+        } else {
+            for (unsigned int i = 0; i < w; i += 1) {
+                for (uint8_t c = 0; c < 4; c += 1) out[(i * 4) + c] = (c < kept) ? in[(i * in_channels) + c] : ((c == 3) ? 255 : 0);
+            }
+        }
+        out += out_pitch;
+        in += in_pitch;
+    }
+}
+
+uint8_t _bolt_texture_read(struct GLTexture2D* tex, unsigned int x, unsigned int y, unsigned int w, unsigned int h, uint8_t* out, size_t out_pitch) {
+    if (!tex->tiles || !w || !h || x + w > tex->width || y + h > tex->height) return 0;
+    _bolt_texture_read_pixels(tex, x, y, w, h, out, out_pitch, 4);
+    return 1;
+}
+
+size_t _bolt_texture_resident_bytes(const struct GLTexture2D* tex) {
+    return tex->resident_bytes;
+}
+
+size_t _bolt_share_group_texture_bytes(const struct GLShareGroup* group) {
+    size_t total = 0;
+    const struct GLTexture2D* textures = group->textures.data;
+    for (size_t i = 0; i < group->textures.count; i += 1) total += _bolt_texture_resident_bytes(&textures[i]);
+    return total;
+}
+
+void _bolt_texture_free(struct GLTexture2D* tex) {
+    for (size_t i = 0; i < tex->upload_count; i += 1) free(tex->uploads[i]);
+    free(tex->uploads);
+    tex->uploads = NULL;
+    tex->upload_count = 0;
+    tex->upload_capacity = 0;
+    tex->journal_bytes = 0;
+    const size_t tile_count = (size_t)tex->tiles_wide * tex->tiles_high;
+    for (size_t i = 0; tex->tiles && i < tile_count; i += 1) _bolt_texture_release_tile(tex, &tex->tiles[i]);
+    free(tex->tiles);
+    tex->tiles = NULL;
+    tex->width = 0;
+    tex->height = 0;
+    tex->tiles_wide = 0;
+    tex->tiles_high = 0;
+    tex->resident_bytes = 0;
 }
@@ -1,12 +1,19 @@
 #ifndef _BOLT_LIBRARY_GL_H_
 #define _BOLT_LIBRARY_GL_H_
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 /* consts used from libgl */
 #define GL_TEXTURE_2D 3553
 #define GL_RGBA 6408
+#define GL_RED 6403
+#define GL_RG 33319
+#define GL_R8 33321
+#define GL_RG8 33323
+#define GL_UNPACK_ALIGNMENT 3317
 #define GL_UNSIGNED_BYTE 5121
 #define GL_UNSIGNED_SHORT 5123
 #define GL_UNSIGNED_INT 5125
@@ -17,42 +24,168 @@
 #define GL_TRIANGLES 4
 #define GL_MAP_READ_BIT 1
 #define GL_MAP_WRITE_BIT 2
+#define GL_MAP_INVALIDATE_RANGE_BIT 4
+#define GL_MAP_INVALIDATE_BUFFER_BIT 8
 #define GL_MAP_FLUSH_EXPLICIT_BIT 16
-#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
-#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
 #define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT 0x8C4E
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
 #define GL_ARRAY_BUFFER 34962
 #define GL_ELEMENT_ARRAY_BUFFER 34963
 #define GL_ARRAY_BUFFER_BINDING 34964
 #define GL_ELEMENT_ARRAY_BUFFER_BINDING 34965
+#define GL_VERTEX_ARRAY_BINDING 34229
+#define GL_TEXTURE0 33984
+#define GL_ACTIVE_TEXTURE 34016
+#define GL_TEXTURE_BINDING_2D 32873
+#define GL_READ_FRAMEBUFFER 36008
+#define GL_DRAW_FRAMEBUFFER 36009
+#define GL_FRAMEBUFFER 36160
+#define GL_COLOR_ATTACHMENT0 36064
 
-// my haphazard implementation of an arena allocator
+// dense array of GL objects with an open-addressing hash index from GL id to position in the array.
+// lookups and inserts are O(1) and memory is proportional to the number of live objects. removing an
+// object moves the last one into its place, so pointers returned by the getters are only valid until
+// the next time something is added to or removed from the same list.
+struct GLListSlot {
+    unsigned int id; // 0 means empty, since 0 is never a valid GL object name
+    uint32_t position;
+};
 struct GLList {
     void* data;
-    void* pointers;
+    unsigned int* ids;
+    struct GLListSlot* index;
+    size_t count;
     size_t capacity;
-    size_t first_empty;
+    size_t index_capacity;
 };
 
+// buffer shadows come from a size-class pool (see so/pool.h), so each one remembers the capacity of its block.
+// `spare` is the previous shadow, handed back by the worker once nothing queued refers to it any more, so that
+// a buffer which is re-specified every frame can keep reusing the same block.
+// `dirty` holds the parts of the shadow that the game has written through a mapping and that haven't been uploaded
+// to the real buffer yet, as half-open byte ranges sorted by start. ranges that overlap or touch are merged, so each
+// dirty byte is only uploaded once no matter how many times it gets mapped, flushed or unmapped in between.
+// `page_sums` is only used if page write detection is on: it has a checksum of each page of the current mapping, as
+// it was when it was mapped, so that unmapping can tell which pages were actually written to.
+struct GLBufferRange {
+    uint32_t start;
+    uint32_t end;
+};
 struct GLArrayBuffer {
     void* data;
     unsigned int id;
+    size_t capacity;
+    void* spare;
+    size_t spare_capacity;
     int32_t mapping_offset;
     uint32_t mapping_len;
     uint32_t mapping_access_type;
     uint8_t mapped;
+    struct GLBufferRange* dirty;
+    uint32_t dirty_count;
+    uint32_t dirty_capacity;
+    uint64_t* page_sums;
+    uint32_t page_sums_count; // 0 if the current mapping isn't being tracked
+    uint32_t page_sums_capacity;
+    uint32_t generation; // set by the platform code, to tell whether the shadow could have missed an update
 };
+// these don't look at the generation, so they're only for keeping the shadows themselves up to date. anything that
+// reads what's in a shadow has to use _bolt_find_current_buffer or _bolt_find_current_texture instead.
 struct GLArrayBuffer* _bolt_find_buffer(struct GLList*, unsigned int);
 struct GLArrayBuffer* _bolt_get_buffer(struct GLList*, unsigned int);
+uint8_t _bolt_remove_buffer(struct GLList*, unsigned int);
+// adds a range to the buffer's dirty set, clamped to the shadow's capacity. returns 1 if the set was empty before.
+uint8_t _bolt_buffer_mark_dirty(struct GLArrayBuffer*, uint32_t offset, uint32_t length);
+// finds a buffer whose shadow can be read, i.e. it has one, and it was made in `generation`, which is odd because the
+// buffers set is on. a shadow from any other generation might have missed writes to the real buffer. the buffers lock
+// must be held for as long as the result is used.
+struct GLArrayBuffer* _bolt_find_current_buffer(struct GLList*, unsigned int, uint32_t generation);
+
+// one glTexSubImage2D or glCompressedTexSubImage2D call, kept as the raw bytes the game uploaded, with rows packed
+// tightly. format is GL_RED, GL_RG or GL_RGBA (all GL_UNSIGNED_BYTE) or an S3TC format.
+// (x, y, w, h) is the part of the texture it writes to, which may be smaller than the data if it was clipped.
+struct GLTextureUpload {
+    uint32_t seq;
+    uint32_t format;
+    uint32_t pending_tiles; // tiles that overlap this upload but haven't decoded it yet
+    unsigned int x;
+    unsigned int y;
+    unsigned int w;
+    unsigned int h;
+    unsigned int data_width;
+    unsigned int data_height;
+    uint8_t data[];
+};
 
+// texture shadows are stored as a grid of tiles, each of which only gets memory when something is written to it,
+// in the texture's own format (so an R8 texture uses one byte per pixel, and compressed textures are stored decoded).
+// tiles along the right and bottom edges are only as big as the part of the texture they cover.
+// uploads are decoded lazily: they go into a journal, and only get decoded into tiles when something asks for pixels
+// from a tile they overlap. uploads are freed once every tile they touch has decoded them, or as soon as a later
+// upload completely covers them. uploads that only partly overlap each other would otherwise pile up forever in a
+// texture that's never read, so once there are more than TEXTURE_JOURNAL_MAX_UPLOADS of them, or they hold more bytes
+// than the decoded texture would, the oldest ones get decoded straight away.
+#define TEXTURE_TILE_SIZE 64
+#define TEXTURE_JOURNAL_MAX_UPLOADS 256
+// tile-aligned glCopyImageSubData calls don't copy anything, they just make the destination tile point at the same
+// pixels as the source tile. pixels are reference-counted, and a tile gets its own copy before anything writes to it.
+struct GLTilePixels {
+    uint32_t refcount;
+    uint32_t size;
+    uint8_t data[];
+};
+struct GLTextureTile {
+    struct GLTilePixels* pixels; // NULL if nothing has been written to this tile yet
+    uint32_t seq; // seq of the newest upload that this tile is up to date with
+};
 struct GLTexture2D {
-    unsigned char* data;
+    struct GLTextureTile* tiles;
     unsigned int id;
     unsigned int width;
     unsigned int height;
+    uint32_t internalformat;
+    uint8_t bytes_per_pixel;
+    unsigned int tiles_wide;
+    unsigned int tiles_high;
+    uint32_t upload_seq;
+    struct GLTextureUpload** uploads;
+    size_t upload_count;
+    size_t upload_capacity;
+    size_t journal_bytes; // held by the uploads
+    size_t resident_bytes; // allocated tile pixels, including ones shared with other textures, plus journalled uploads
+    uint32_t generation; // same as GLArrayBuffer::generation
 };
 struct GLTexture2D* _bolt_find_texture(struct GLList*, unsigned int);
 struct GLTexture2D* _bolt_get_texture(struct GLList*, unsigned int);
+uint8_t _bolt_remove_texture(struct GLList*, unsigned int);
+// finds a texture whose shadow can be read, the same way as _bolt_find_current_buffer does for buffers
+struct GLTexture2D* _bolt_find_current_texture(struct GLList*, unsigned int, uint32_t generation);
+
+// (re)allocates a texture's storage, discarding any previous contents. no tile memory is allocated until it's written.
+void _bolt_texture_storage(struct GLTexture2D*, uint32_t internalformat, unsigned int width, unsigned int height);
+// journals an upload of `data`, which is either GL_UNSIGNED_BYTE pixels in GL_RED, GL_RG or GL_RGBA format, or S3TC
+// blocks, depending on format. data_pitch is the distance in bytes between uncompressed rows, or 0 if tightly packed.
+void _bolt_texture_upload(struct GLTexture2D*, uint32_t format, unsigned int x, unsigned int y, unsigned int w, unsigned int h, const void* data, size_t data_pitch);
+// number of bytes of upload data needed for a tightly packed w*h upload in the given format
+size_t _bolt_texture_upload_size(uint32_t format, unsigned int w, unsigned int h);
+// copies a region from one texture to another. returns 0, without copying anything, if the region isn't inside both
+// textures. whole tiles are shared if the two textures have the same format and the region is tile-aligned in both.
+uint8_t _bolt_texture_copy(struct GLTexture2D* dst, unsigned int dst_x, unsigned int dst_y, struct GLTexture2D* src, unsigned int src_x, unsigned int src_y, unsigned int w, unsigned int h);
+// converts a whole w*h upload, with the same arguments as _bolt_texture_upload, to the RGBA that _bolt_texture_read
+// will give back for it once it's in the texture, without decoding anything in the texture itself
+void _bolt_texture_upload_pixels(const struct GLTexture2D*, uint32_t format, unsigned int w, unsigned int h, const void* data, size_t data_pitch, uint8_t* out, size_t out_pitch);
+// decodes (x, y, w, h) if necessary and copies it out as RGBA, expanding single- and two-channel textures the same
+// way GL does when sampling them. returns 0 if the region isn't inside the texture.
+uint8_t _bolt_texture_read(struct GLTexture2D*, unsigned int x, unsigned int y, unsigned int w, unsigned int h, uint8_t* out, size_t out_pitch);
+// bytes of memory currently held by this texture's shadow
+size_t _bolt_texture_resident_bytes(const struct GLTexture2D*);
+void _bolt_texture_free(struct GLTexture2D*);
 
 struct GLProgram {
     unsigned int id;
@@ -64,9 +197,14 @@ struct GLProgram {
     int loc_uProjectionMatrix;
     int loc_uDiffuseMap;
     uint8_t is_important;
+    // unique within the share group, and changed whenever the fields above are, i.e. whenever the program is created or
+    // linked, so that anything keyed on a program can't be fooled by a relink or by a deleted program's id being reused
+    uint32_t link;
+    int diffuse_unit; // the texture unit uDiffuseMap samples from, i.e. its value
 };
 struct GLProgram* _bolt_find_program(struct GLList*, unsigned int);
 struct GLProgram* _bolt_get_program(struct GLList*, unsigned int);
+uint8_t _bolt_remove_program(struct GLList*, unsigned int);
 
 struct GLAttrBinding {
     unsigned int buffer;
@@ -76,29 +214,156 @@ struct GLAttrBinding {
     uint32_t type;
     uint8_t normalise;
     uint8_t enabled;
+    // resolved by _bolt_set_attr_binding from the fields above, so that decoding doesn't have to work them out again
+    // for every draw. see _bolt_attr_resolve.
+    uint8_t kind; // 0 if the type can't be decoded
+    size_t fetch_stride; // stride, or the size of one vertex's worth of the attribute if stride is 0
+    float scale;
+    float bias;
 };
 
-// Context-specific information - this is thread-specific on EGL, not sure about elsewhere
-// this method of context-sharing takes advantage of the fact that the game never chains shares together
-// with a depth greater than 1, and always deletes the non-owner before the owner. neither of those things
-// are actually safe assumptions in valid OpenGL usage.
-struct GLContext {
-    uintptr_t id;
+#define MAX_VERTEX_ATTRIBS 16
+
+// the attributes that an important program reads, as they were found in a VAO for a particular program and layout
+struct GLVertexFetcher {
+    unsigned int program;
+    uint32_t link; // GLProgram::link of the program it was built for
+    uint32_t layout;
+    struct GLAttrBinding aVertexPosition2D;
+    struct GLAttrBinding aVertexColour;
+    struct GLAttrBinding aTextureUV;
+    struct GLAttrBinding aTextureUVAtlasMin;
+    struct GLAttrBinding aTextureUVAtlasExtents;
+};
+
+// vertex array objects aren't shared between contexts, so each context has its own list of them, plus one for VAO 0.
+// attribute bindings and the element buffer binding belong to the VAO rather than the context. `layout` goes up
+// whenever any of the attributes change, and the fetcher is rebuilt on the next draw that finds it out of date, so
+// draws that keep using the same VAO and program don't have to look anything up.
+struct GLVertexArray {
+    unsigned int id;
+    unsigned int element_buffer;
+    uint32_t layout;
+    struct GLAttrBinding attributes[MAX_VERTEX_ATTRIBS];
+    struct GLVertexFetcher fetcher;
+};
+struct GLVertexArray* _bolt_find_vertex_array(struct GLList*, unsigned int);
+struct GLVertexArray* _bolt_get_vertex_array(struct GLList*, unsigned int);
+uint8_t _bolt_remove_vertex_array(struct GLList*, unsigned int);
+
+// framebuffers aren't shared between contexts either. only colour attachment 0 is tracked, and only if it's level 0 of
+// a GL_TEXTURE_2D, since that's the only way rendering can change anything in a texture's shadow.
+struct GLFramebuffer {
+    unsigned int id;
+    unsigned int texture; // 0 if colour attachment 0 isn't a 2D texture
+};
+struct GLFramebuffer* _bolt_find_framebuffer(struct GLList*, unsigned int);
+struct GLFramebuffer* _bolt_get_framebuffer(struct GLList*, unsigned int);
+uint8_t _bolt_remove_framebuffer(struct GLList*, unsigned int);
+
+// textures that a context has bound to a target other than GL_TEXTURE_2D. glBindTextures and glBindTextureUnit don't
+// say which target they bind to, so these are the ones that they're known not to be binding as 2D textures.
+struct GLTextureTarget {
+    unsigned int id;
+    uint32_t target;
+};
+struct GLTextureTarget* _bolt_find_texture_target(struct GLList*, unsigned int);
+struct GLTextureTarget* _bolt_get_texture_target(struct GLList*, unsigned int);
+uint8_t _bolt_remove_texture_target(struct GLList*, unsigned int);
+
+// an "important" draw call as it was when the game made it, for the worker to look at later
+struct GLDrawSnapshot {
+    unsigned int program;
+    unsigned int texture; // GL_TEXTURE_2D binding of the unit that uDiffuseMap samples from
+    unsigned int element_buffer;
+    uintptr_t indices; // offset into the element buffer
+    unsigned int count;
+    struct GLVertexFetcher attributes;
+    // filled in by _bolt_capture_pin, see capture.h: `elements` is the draw's indices less the lowest of them, and the
+    // offset of each enabled attribute is into `vertices` rather than its buffer
+    const uint16_t* elements;
+    const uint8_t* vertices;
+    size_t vertices_size;
+};
+
+#define MAX_TEXTURE_UNITS 32
+
+// ids of the buffers in a share group that have dirty ranges, so a sync point only has to look at those. a buffer
+// can be in here more than once, or not exist any more, if it was deleted and re-created in the meantime.
+struct GLDirtyBuffers {
+    unsigned int* ids;
+    size_t count;
+    size_t capacity;
+};
+
+// everything that's shared between the contexts in an EGL share group. a context created with a share context joins
+// that context's group, however many levels of sharing away from the original context it is. each context holds a
+// reference to its group, as does anything else that needs the group to stay alive, such as the platform code's
+// worker for it. the group is freed when the last reference is dropped. references are counted under the same lock
+// as context creation and destruction.
+struct GLShareGroup {
     struct GLList programs;
     struct GLList buffers;
     struct GLList textures;
+    // buffer shadows are created and mapped on the game's threads, not the worker, so the buffer list needs a lock.
+    // programs are only ever touched by the game's threads, but contexts in the same share group can be current
+    // on different threads at once, so they need one too.
+    pthread_mutex_t buffers_lock;
+    pthread_mutex_t programs_lock;
+    struct GLDirtyBuffers dirty_buffers; // protected by the buffers lock
+    // set when dirty_buffers has ranges waiting to be uploaded. they're all uploaded in one message at the group's next
+    // sync point, which is the next draw call, glBufferSubData or glFlush on any of its contexts.
+    _Atomic uint8_t sync_before_next_draw;
+    uint32_t refcount;
+    uint32_t context_count;
+    // owned by the platform code, along with `worker_users`, which it can use to keep the worker alive while using it
+    _Atomic(void*) worker;
+    _Atomic uint32_t worker_users;
+    // goes up every time a program in the group is created, linked or has its uDiffuseMap set, see GLProgram::link.
+    // protected by the programs lock, but read without it to tell whether a context's copy of its program is out of date.
+    _Atomic uint32_t program_links;
+    // the worker's index of what's been uploaded to the group's textures, or NULL if there's no worker. only for use
+    // on the worker thread, e.g. by render callbacks.
+    struct BoltSpriteIndex* sprites;
+};
+void _bolt_share_group_ref(struct GLShareGroup*);
+void _bolt_share_group_unref(struct GLShareGroup*);
+
+#define CONTEXT_ATTACHED 1 // current on some thread
+#define CONTEXT_DESTROYED 2 // destroyed by the game, and will be freed as soon as it isn't current any more
+// Context-specific information - this is thread-specific on EGL, not sure about elsewhere. anything shared with other
+// contexts lives in the share group, see GLShareGroup.
+struct GLContext {
+    uintptr_t id;
+    struct GLShareGroup* share_group;
+    // shortcuts into share_group
     struct GLList* shared_programs;
     struct GLList* shared_buffers;
     struct GLList* shared_textures;
-    size_t bound_program_id;
-    size_t bound_texture_id;
-    uint8_t current_program_is_important;
-    uint8_t is_attached;
-    uint8_t deferred_destroy;
-    uint8_t is_shared_owner;
+    pthread_mutex_t* shared_buffers_lock;
+    pthread_mutex_t* shared_programs_lock;
+    struct GLDirtyBuffers* shared_dirty_buffers;
+    _Atomic uint32_t state; // CONTEXT_ATTACHED and CONTEXT_DESTROYED, see _bolt_make_context_current
+    // state below here is tracked by the hooks on whichever thread the context is current on, so that they never
+    // have to ask the driver for it or send a message for it. the worker must not touch any of this - anything it
+    // needs gets copied into the message that needs it.
+    unsigned int bound_program_id;
+    struct GLProgram current_program; // copy of the bound program, taken when it was bound
+    uint32_t program_links; // the group's program_links when current_program was copied
     unsigned int current_draw_framebuffer;
     unsigned int current_read_framebuffer;
-    struct GLAttrBinding attributes[16];
+    struct GLList framebuffers;
+    // the texture that the worker was last told is being rendered to, see _bolt_context_render_target. it only has to
+    // be told again once something else has written to a texture, since it only needs to drop what was indexed there.
+    unsigned int rendered_texture;
+    unsigned int array_buffer_binding;
+    unsigned int vertex_array_binding;
+    struct GLVertexArray* vertex_array; // the bound VAO, which is default_vertex_array if it's 0
+    struct GLVertexArray default_vertex_array;
+    struct GLList vertex_arrays;
+    unsigned int active_texture_unit;
+    unsigned int texture_units[MAX_TEXTURE_UNITS]; // GL_TEXTURE_2D binding of each texture unit
+    struct GLList texture_targets; // see GLTextureTarget
 };
 
 struct GLFence {
@@ -108,16 +373,90 @@ struct GLFence {
     pthread_cond_t cond;
 };
 
+// contexts are kept in a hash table keyed by EGL context, which gets replaced with a bigger copy when it fills up.
+// _bolt_make_context_current reads it without taking any lock, so tables and contexts that are removed from it aren't
+// freed until every thread that might still be looking at them has finished its lookup (epoch-based reclamation).
+// creating and destroying contexts must be serialised by the caller.
 struct GLContext* _bolt_context();
-void _bolt_create_context(void*, void*);
-void _bolt_make_context_current(void*);
-void _bolt_destroy_context(void*);
+// creates a context, in the same share group as the second argument if it's a context we know about, or in a new share
+// group otherwise. returns NULL on allocation failure.
+struct GLContext* _bolt_create_context(void*, void*);
+// makes a context current on this thread, or makes no context current if NULL or unknown. takes no lock. if the game
+// destroyed the previously current context while it was current, this returns it, and the caller must then pass it
+// to _bolt_free_context.
+struct GLContext* _bolt_make_context_current(void*);
+// destroys a context, unless it's current on some thread, in which case it'll be returned by _bolt_make_context_current
+// on that thread later. this can remove the last context from a share group. if anything else still holds a reference
+// to the group when that happens, the group is returned so the caller can let go of it. otherwise returns NULL.
+struct GLShareGroup* _bolt_destroy_context(void*);
+// finishes destroying a context returned by _bolt_make_context_current, returning the same as _bolt_destroy_context
+struct GLShareGroup* _bolt_free_context(struct GLContext*);
 struct GLArrayBuffer* _bolt_context_get_buffer(struct GLContext*, uint32_t);
 struct GLArrayBuffer* _bolt_context_find_buffer(struct GLContext*, uint32_t);
 struct GLArrayBuffer* _bolt_context_find_named_buffer(struct GLContext*, unsigned int);
-void _bolt_context_destroy_buffers(struct GLContext*, unsigned int, const unsigned int*);
-void _bolt_context_destroy_textures(struct GLContext*, unsigned int, const unsigned int*);
+// removes the buffers from the list and writes their shadow and spare blocks to the output array, which must have
+// space for at least 2n blocks, without freeing them. returns the number of blocks written.
+struct GLBufferBlock {
+    void* data;
+    size_t capacity;
+};
+size_t _bolt_context_destroy_buffers(struct GLContext*, unsigned int n, const unsigned int*, struct GLBufferBlock*);
+// one merged range to be copied from a buffer's shadow to the real buffer. `data` points into the shadow.
+struct GLBufferUpload {
+    const void* data;
+    unsigned int buffer;
+    uint32_t offset;
+    uint32_t length;
+};
+// marks part of a buffer in this context's share group as dirty, see GLArrayBuffer. the buffers lock must be held
+// for this and the next two functions.
+void _bolt_context_mark_buffer_dirty(struct GLContext*, struct GLArrayBuffer*, uint32_t offset, uint32_t length);
+// page write detection for a mapped buffer: snapshot checksums each page of the buffer's current mapping, and written
+// marks dirty only the parts of the mapping that are in pages whose checksum has changed since then, returning the
+// number of bytes it marked. page_size must be a power of two. snapshot returns 0 and leaves the mapping untracked if
+// it can't allocate, in which case the caller should mark the whole mapping dirty on unmap as usual.
+uint8_t _bolt_buffer_snapshot_pages(struct GLArrayBuffer*, size_t page_size);
+size_t _bolt_context_mark_written_pages(struct GLContext*, struct GLArrayBuffer*, size_t page_size);
+// returns the number of uploads that _bolt_context_take_buffer_uploads would write
+size_t _bolt_context_buffer_upload_count(struct GLContext*);
+// writes an upload for every dirty range in the share group, grouped by buffer, and marks them all clean.
+// returns the number of uploads written.
+size_t _bolt_context_take_buffer_uploads(struct GLContext*, struct GLBufferUpload*);
+void _bolt_share_group_destroy_textures(struct GLShareGroup*, unsigned int, const unsigned int*);
+// total bytes held by the shadows of every texture in the group. tiles shared between textures are counted once per texture.
+size_t _bolt_share_group_texture_bytes(const struct GLShareGroup*);
+// the texture attached to the bound draw framebuffer, see GLFramebuffer, or 0 if there isn't one
+unsigned int _bolt_context_render_target(struct GLContext*);
+// attaches a texture to colour attachment 0 of the framebuffer bound to `target`, or detaches it if texture is 0
+void _bolt_context_attach_texture(struct GLContext*, uint32_t target, unsigned int texture);
+void _bolt_context_delete_framebuffers(struct GLContext*, unsigned int n, const unsigned int*);
+// binding state tracked by the hooks, see GLContext. buffer targets other than GL_ARRAY_BUFFER and
+// GL_ELEMENT_ARRAY_BUFFER are ignored, as are texture targets other than GL_TEXTURE_2D.
+unsigned int _bolt_context_buffer_binding(struct GLContext*, uint32_t target);
+void _bolt_context_bind_buffer(struct GLContext*, uint32_t target, unsigned int);
+void _bolt_context_bind_vertex_array(struct GLContext*, unsigned int);
+void _bolt_context_bind_texture(struct GLContext*, uint32_t target, unsigned int);
+unsigned int _bolt_context_texture_binding(struct GLContext*);
+// same, for any texture unit rather than the active one
+unsigned int _bolt_context_unit_texture_binding(struct GLContext*, unsigned int unit);
+// glBindTextures and glBindTextureUnit, which bind a texture to whichever target it was created for, or unbind every
+// target if it's 0. a texture is assumed to be a 2D one unless this context has bound it to some other target before.
+void _bolt_context_bind_unit_texture(struct GLContext*, unsigned int unit, unsigned int texture);
+// these do what GL does when a bound object is deleted, i.e. reset the binding to 0
+void _bolt_context_unbind_buffers(struct GLContext*, unsigned int n, const unsigned int*);
+void _bolt_context_unbind_textures(struct GLContext*, unsigned int n, const unsigned int*);
+void _bolt_context_delete_vertex_arrays(struct GLContext*, unsigned int n, const unsigned int*);
+// glVertexAttribPointer, glEnableVertexAttribArray and glDisableVertexAttribArray on the bound VAO
+void _bolt_context_set_attr(struct GLContext*, unsigned int index, int size, const void* offset, unsigned int stride, uint32_t type, uint8_t normalise);
+void _bolt_context_enable_attr(struct GLContext*, unsigned int index, uint8_t enabled);
+// returns the bound VAO's attributes for the bound program, rebuilding them first if the VAO's layout or the program
+// has changed since they were last built. returns NULL if the program's attribute locations are out of range.
+const struct GLVertexFetcher* _bolt_context_vertex_fetcher(struct GLContext*);
 void _bolt_set_attr_binding(struct GLAttrBinding*, unsigned int, int, const void*, unsigned int, uint32_t, uint8_t);
-uint8_t _bolt_get_attr_binding(struct GLContext*, const struct GLAttrBinding*, size_t, size_t, float*);
+// decodes `num_out` components of one vertex's attribute as floats. returns 0 if it couldn't be decoded, which
+// includes the buffer's shadow not being current in `generation`, the buffers set's, see _bolt_find_current_buffer.
+uint8_t _bolt_get_attr_binding(struct GLContext*, const struct GLAttrBinding*, size_t index, size_t num_out, float* out, uint32_t generation);
+// same, but for many vertices at once, with one buffer lookup and bounds check for all of them. see _bolt_attr_decode.
+uint8_t _bolt_get_attr_bindings(struct GLContext*, const struct GLAttrBinding*, const uint16_t* indices, size_t first, size_t count, size_t num_out, float* out, uint32_t generation);
 
 #endif
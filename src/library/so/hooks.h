@@ -0,0 +1,93 @@
+#ifndef _BOLT_LIBRARY_SO_HOOKS_H_
+#define _BOLT_LIBRARY_SO_HOOKS_H_
+
+// every function we intercept, as X(module, name, hook, flags). `module` is the library the real function comes from,
+// whose address is in <module>_addr, and the real function goes in real_<name>. `hook` is what the game gets instead.
+// main.c builds its dlsym and eglGetProcAddress lookups and its ELF symbol resolution from this list, so adding a hook
+// only means adding it here and defining it.
+
+// the module exports it: the real one is resolved when the module is found, and dlsym on the module returns the hook
+#define HOOK_EXPORT 1
+// eglGetProcAddress returns the hook
+#define HOOK_PROC 2
+// when eglGetProcAddress is asked for it, the real one is re-resolved through the real eglGetProcAddress first
+#define HOOK_PROC_RESOLVE 4
+// eglGetProcAddress returns NULL instead of the hook if the real one couldn't be resolved
+#define HOOK_PROC_OPTIONAL 8
+#define HOOK_GL_PROC (HOOK_PROC | HOOK_PROC_RESOLVE | HOOK_PROC_OPTIONAL)
+
+#define BOLT_HOOKS(X) \
+    X(libc, dlopen, dlopen, HOOK_EXPORT) \
+    X(libc, dlsym, dlsym, HOOK_EXPORT) \
+    X(libc, dlvsym, dlvsym, HOOK_EXPORT) \
+    X(libc, dlclose, dlclose, HOOK_EXPORT) \
+    X(libegl, eglGetProcAddress, eglGetProcAddress, HOOK_EXPORT | HOOK_PROC) \
+    X(libegl, eglSwapBuffers, eglSwapBuffers, HOOK_EXPORT | HOOK_PROC | HOOK_PROC_RESOLVE) \
+    X(libegl, eglMakeCurrent, eglMakeCurrent, HOOK_EXPORT | HOOK_PROC | HOOK_PROC_RESOLVE) \
+    X(libegl, eglDestroyContext, eglDestroyContext, HOOK_EXPORT | HOOK_PROC | HOOK_PROC_RESOLVE) \
+    X(libegl, eglInitialize, eglInitialize, HOOK_EXPORT | HOOK_PROC | HOOK_PROC_RESOLVE) \
+    X(libegl, eglCreateContext, eglCreateContext, HOOK_EXPORT | HOOK_PROC | HOOK_PROC_RESOLVE) \
+    X(libegl, eglTerminate, eglTerminate, HOOK_EXPORT | HOOK_PROC | HOOK_PROC_RESOLVE) \
+    X(libegl, glCreateProgram, _bolt_glCreateProgram, HOOK_GL_PROC) \
+    X(libegl, glBindAttribLocation, _bolt_glBindAttribLocation, HOOK_GL_PROC) \
+    X(libegl, glGetUniformLocation, _bolt_glGetUniformLocation, HOOK_GL_PROC) \
+    X(libegl, glGetUniformfv, _bolt_glGetUniformfv, HOOK_GL_PROC) \
+    X(libegl, glGetUniformiv, _bolt_glGetUniformiv, HOOK_GL_PROC) \
+    X(libegl, glLinkProgram, _bolt_glLinkProgram, HOOK_GL_PROC) \
+    X(libegl, glUseProgram, _bolt_glUseProgram, HOOK_GL_PROC) \
+    X(libegl, glUniform1i, _bolt_glUniform1i, HOOK_GL_PROC) \
+    X(libegl, glTexStorage2D, _bolt_glTexStorage2D, HOOK_GL_PROC) \
+    X(libegl, glVertexAttribPointer, _bolt_glVertexAttribPointer, HOOK_GL_PROC) \
+    X(libegl, glBindBuffer, _bolt_glBindBuffer, HOOK_GL_PROC) \
+    X(libegl, glBufferData, _bolt_glBufferData, HOOK_GL_PROC) \
+    X(libegl, glDeleteBuffers, _bolt_glDeleteBuffers, HOOK_GL_PROC) \
+    X(libegl, glBindFramebuffer, _bolt_glBindFramebuffer, HOOK_GL_PROC) \
+    X(libegl, glFramebufferTextureLayer, _bolt_glFramebufferTextureLayer, HOOK_GL_PROC) \
+    X(libegl, glFramebufferTexture2D, _bolt_glFramebufferTexture2D, HOOK_GL_PROC) \
+    X(libegl, glDeleteFramebuffers, _bolt_glDeleteFramebuffers, HOOK_GL_PROC) \
+    X(libegl, glBlitFramebuffer, _bolt_glBlitFramebuffer, HOOK_GL_PROC) \
+    X(libegl, glBindTextures, _bolt_glBindTextures, HOOK_GL_PROC) \
+    X(libegl, glBindTextureUnit, _bolt_glBindTextureUnit, HOOK_GL_PROC) \
+    X(libegl, glCompressedTexSubImage2D, _bolt_glCompressedTexSubImage2D, HOOK_GL_PROC) \
+    X(libegl, glCopyImageSubData, _bolt_glCopyImageSubData, HOOK_GL_PROC) \
+    X(libegl, glEnableVertexAttribArray, _bolt_glEnableVertexAttribArray, HOOK_GL_PROC) \
+    X(libegl, glDisableVertexAttribArray, _bolt_glDisableVertexAttribArray, HOOK_GL_PROC) \
+    X(libegl, glMapBufferRange, _bolt_glMapBufferRange, HOOK_GL_PROC) \
+    X(libegl, glUnmapBuffer, _bolt_glUnmapBuffer, HOOK_GL_PROC) \
+    X(libegl, glBufferStorage, _bolt_glBufferStorage, HOOK_GL_PROC) \
+    X(libegl, glFlushMappedBufferRange, _bolt_glFlushMappedBufferRange, HOOK_GL_PROC) \
+    X(libegl, glBufferSubData, _bolt_glBufferSubData, HOOK_GL_PROC) \
+    X(libegl, glGetIntegerv, _bolt_glGetIntegerv, HOOK_GL_PROC) \
+    X(libegl, glBindVertexArray, _bolt_glBindVertexArray, HOOK_GL_PROC) \
+    X(libegl, glDeleteVertexArrays, _bolt_glDeleteVertexArrays, HOOK_GL_PROC) \
+    X(libgl, glDrawElements, glDrawElements, HOOK_EXPORT) \
+    X(libgl, glDrawArrays, glDrawArrays, HOOK_EXPORT) \
+    X(libgl, glClear, glClear, HOOK_EXPORT) \
+    X(libgl, glBindTexture, glBindTexture, HOOK_EXPORT) \
+    X(libgl, glActiveTexture, glActiveTexture, HOOK_EXPORT | HOOK_GL_PROC) \
+    X(libgl, glTexSubImage2D, glTexSubImage2D, HOOK_EXPORT) \
+    X(libgl, glDeleteTextures, glDeleteTextures, HOOK_EXPORT) \
+    X(libgl, glGetError, glGetError, HOOK_EXPORT) \
+    X(libgl, glFlush, glFlush, HOOK_EXPORT) \
+    X(libxcb, xcb_poll_for_event, xcb_poll_for_event, HOOK_EXPORT) \
+    X(libxcb, xcb_wait_for_event, xcb_wait_for_event, HOOK_EXPORT)
+
+// feature sets, which can be turned on and off while the game is running (see _bolt_enable_hook_set in main.c).
+// anything not in a set is needed to keep the game working or to keep our own state consistent, so it's always on.
+#define HOOK_SET_TEXTURES 0
+#define HOOK_SET_BUFFERS 1
+#define HOOK_SET_DRAWS 2
+#define HOOK_SET_COUNT 3
+
+// hooks that belong to a feature set, as X(set, name, hook). the function the game gets from BOLT_HOOKS calls through
+// dispatch_<name>, which points at `hook` while the set is on and at real_<name> while it's off.
+#define BOLT_HOOK_SET_MEMBERS(X) \
+    X(HOOK_SET_TEXTURES, glTexStorage2D, _bolt_hooked_glTexStorage2D) \
+    X(HOOK_SET_TEXTURES, glTexSubImage2D, _bolt_hooked_glTexSubImage2D) \
+    X(HOOK_SET_TEXTURES, glCompressedTexSubImage2D, _bolt_hooked_glCompressedTexSubImage2D) \
+    X(HOOK_SET_TEXTURES, glCopyImageSubData, _bolt_hooked_glCopyImageSubData) \
+    X(HOOK_SET_BUFFERS, glBufferData, _bolt_hooked_glBufferData) \
+    X(HOOK_SET_BUFFERS, glBufferStorage, _bolt_hooked_glBufferStorage) \
+    X(HOOK_SET_DRAWS, glDrawElements, _bolt_hooked_glDrawElements)
+
+#endif
@@ -3,14 +3,23 @@
 #include <unistd.h>
 #undef _GNU_SOURCE
 
+#include <limits.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/socket.h>
 
 #include "../gl.h"
+#include "../capture.h"
+#include "../dxt.h"
+#include "../sprite.h"
+#include "../text.h"
+#include "hooks.h"
+#include "pool.h"
+#include "queue.h"
+#include "staging.h"
 
 // note: this is currently always triggered by single-threaded dlopen calls so no locking necessary
 uint8_t inited = 0;
@@ -18,36 +27,54 @@ uint8_t inited = 0;
 
 enum BoltMessageType {
     Message_Quit,
-    Message_Context,
-    Message_glCreateProgram,
-    Message_glLinkProgram,
-    Message_glUseProgram,
-    Message_glEnableVertexAttribArray,
-    Message_glDisableVertexAttribArray,
-    Message_glBindAttribLocation,
-    Message_glVertexAttribPointer,
     Message_glBufferData,
     Message_glBufferStorage,
-    Message_glMapBufferRange,
-    Message_glUnmapBuffer,
+    Message_BufferUploads,
     Message_glDeleteBuffers,
-    Message_glBindFramebuffer,
     Message_glCompressedTexSubImage2D,
     Message_glCopyImageSubData,
-    Message_glFlushMappedBufferRange,
     Message_glDrawElements,
-    Message_glBindTexture,
     Message_glTexStorage2D,
     Message_glTexSubImage2D,
     Message_glDeleteTextures,
     Message_eglSwapBuffers,
     Message_glFlush,
+    Message_FrameEnd,
+    Message_TextureWritten,
 };
-int read_socket;
-int write_socket;
-pthread_t worker_thread;
-uint8_t worker_thread_running = 0;
-uint8_t worker_context_exists = 0;
+// in messages. this is more than the game ever issues between two worker wakeups
+#define WORKER_QUEUE_CAPACITY (1 << 14)
+
+// each GL share group gets its own worker thread, with its own queue and its own EGL context in that share group, so
+// that contexts in different groups don't have to take turns on the same thread. a worker is started along with the
+// first context in its group, and holds a reference to the group until it's stopped, which happens when the last
+// context in the group is destroyed or when its display is terminated. the list of workers is protected by egl_lock.
+struct BoltWorker {
+    struct BoltQueue queue;
+    pthread_t thread;
+    struct GLShareGroup* group;
+    void* display;
+    void* context;
+    _Atomic uint8_t running;
+    // frame pacing, see max_frame_lag
+    _Atomic uint32_t frames_submitted;
+    _Atomic uint32_t frames_completed;
+    _Atomic uint32_t frame_waiters;
+    // UI capture, see capture_budget_ns. `capture` is the frame being drawn, and `captured` is the last complete one.
+    // `delta` is what changed between the last two complete frames, which is only worked out while something's
+    // subscribed to it. all three belong to the worker thread.
+    struct BoltRenderList capture;
+    struct BoltRenderList captured;
+    struct BoltRenderDelta delta;
+    // what's been uploaded where in the group's textures, see sprite.h. also belongs to the worker thread.
+    struct BoltSpriteIndex sprites;
+    // text read out of captured frames, which is only worked out while something's subscribed to it.
+    // `text_followed` is whether it was worked out for the previous frame, which the delta is from.
+    struct BoltTextEngine text;
+    uint8_t text_followed;
+    struct BoltWorker* next;
+};
+struct BoltWorker* workers = NULL;
 void* _bolt_worker_thread(void*);
 struct BoltMessage {
     struct GLContext* context;
@@ -58,18 +85,27 @@ struct BoltMessage {
     unsigned int h;
     unsigned int index;
     unsigned int asset;
-    unsigned int stride;
-    uint32_t type;
+    union {
+        struct {
+            unsigned int stride;
+            uint32_t type;
+        };
+        // glCopyImageSubData doesn't need a stride or type, but it does need a second position
+        struct {
+            unsigned int src_x;
+            unsigned int src_y;
+        };
+    };
     uint32_t target;
     uint32_t format;
     uint8_t bool_value;
     uint8_t do_free_data;
     enum BoltMessageType instruction;
 };
-#define SEND_MSG(...) {struct BoltMessage _message = __VA_ARGS__; write(write_socket, &_message, sizeof(struct BoltMessage));}
+#define SEND_MSG(...) {struct BoltMessage _message = __VA_ARGS__; _bolt_send_message(&_message);}
+static void _bolt_send_message(const struct BoltMessage*);
 
 struct BoltSyncData {
-    void* ptr;
     pthread_mutex_t mutex;
     pthread_cond_t cond;
     uint8_t done;
@@ -77,7 +113,87 @@ struct BoltSyncData {
 
 
 pthread_mutex_t egl_lock;
-atomic_bool sync_before_next_draw = 0;
+
+// buffer upload accounting, to show how much merging dirty ranges saves. "written" counts every byte that the game
+// unmapped or flushed, which is what used to get uploaded, and "uploaded" counts what actually gets uploaded after
+// merging. eglSwapBuffers moves the current frame's counts into last_frame and total. BOLT_UPLOAD_STATS=1 prints
+// the totals when the display is terminated.
+struct BoltUploadCounters {
+    _Atomic uint64_t written;
+    _Atomic uint64_t uploaded;
+};
+struct BoltUploadCounters upload_this_frame;
+struct BoltUploadCounters upload_last_frame;
+struct BoltUploadCounters upload_total;
+uint8_t print_upload_stats = 0;
+
+// optional page write detection for mapped buffers, turned on with BOLT_DIRTY_PAGES=1. mapping a big enough range
+// checksums each page of it, and unmapping only marks the pages whose checksum changed as dirty, instead of the whole
+// mapping. this costs two passes over the mapping on the game thread, so it's only worth it if the game maps much
+// more than it writes. mappings with an invalidate bit are about to be overwritten entirely, so they aren't checked.
+#define DIRTY_PAGES_MIN_PAGES 4
+size_t dirty_page_size = 0; // 0 if page write detection is off
+
+// frame pacing: eglSwapBuffers stamps each frame with a sequence number, and the worker publishes the number
+// of the last frame it finished. the game thread only blocks if it gets more than max_frame_lag frames ahead,
+// so a slow message doesn't turn directly into a frame-time spike. a lag of 0 makes every swap synchronous.
+// can be overridden with the BOLT_MAX_FRAME_LAG environment variable. frames are counted per worker.
+#define DEFAULT_MAX_FRAME_LAG 2
+uint32_t max_frame_lag = DEFAULT_MAX_FRAME_LAG;
+_Atomic uint32_t total_frames = 0;
+uint8_t staging_initialised = 0;
+
+// buffer shadow pool settings, see pool.h. huge pages are off by default, and can be turned on with
+// BOLT_POOL_HUGE_PAGES=1. the cache limit can be changed with BOLT_POOL_CACHE_MB, and BOLT_POOL_STATS=1
+// prints the pool's statistics when the display is terminated.
+#define DEFAULT_POOL_CACHE_BYTES (64 << 20)
+uint8_t print_pool_stats = 0;
+
+// BOLT_TEXTURE_STATS=1 prints how much memory each share group's texture shadows hold, and which textures hold the
+// most of it, when its worker stops, which is at the latest when the display is terminated
+#define TEXTURE_STATS_LARGEST 5
+uint8_t print_texture_stats = 0;
+
+// binding state is tracked by the hooks rather than queried from the driver (see GLContext). setting
+// BOLT_DEBUG_BINDINGS=1 makes every use of it query the driver anyway and print a warning if they disagree.
+uint8_t debug_bindings = 0;
+
+// size of each of the staging arenas that message payloads are copied into, see staging.h. there's one more arena
+// than max_frame_lag (but always at least two), so a frame's arena is normally free again by the time it comes back
+// around. can be changed with BOLT_STAGING_MB.
+#define DEFAULT_STAGING_ARENA_BYTES (8 << 20)
+size_t staging_arena_bytes = DEFAULT_STAGING_ARENA_BYTES;
+
+// the worker has two lanes. sync messages are handled as soon as they're read, because the game is either waiting for
+// them (glFlush, eglSwapBuffers) or waiting for the memory they give back (buffer shadows). bulk messages only feed the
+// worker's own texture shadows and draw snapshots, which nothing on the game side ever waits for, so they go into a
+// backlog that the worker gets through whenever the queue is empty. messages in the same lane are always handled in
+// order, which is enough because the lanes never share state: everything that touches the texture shadows is in the
+// bulk lane, and nothing in the bulk lane touches a buffer. draw snapshots carry their own copy of the vertex data they
+// read, taken when the draw was made (see _bolt_capture_pin), since by the time the worker gets to them the game has
+// usually written the next frame into the same buffers. if the backlog grows past backlog_limit, droppable bulk work
+// (draw snapshots) is dropped as it arrives, and one backlogged message is handled for every message read, so the
+// backlog can't grow any further unless the game keeps sending texture work faster than it can be journalled. can be
+// set with BOLT_WORKER_BACKLOG, and setting it to 0 turns the lanes off, so that everything is handled in the order it
+// was sent.
+#define DEFAULT_BACKLOG_LIMIT 4096
+size_t backlog_limit = DEFAULT_BACKLOG_LIMIT;
+_Atomic uint64_t backlog_dropped = 0;
+
+// the worker turns each important draw into a list of quads, see capture.h. the draws are in the bulk lane, so the end
+// of a frame is marked by a bulk message too, sent just before the swap. capturing is limited to this much of the
+// worker's time per frame, and anything drawn after that's used up is only counted. can be changed with
+// BOLT_CAPTURE_BUDGET_US, where 0 means no limit.
+#define DEFAULT_CAPTURE_BUDGET_NS 1000000
+uint64_t capture_budget_ns = DEFAULT_CAPTURE_BUDGET_NS;
+
+// feature sets (see hooks.h). BOLT_HOOK_SETS is a comma-separated list of the ones to turn on, e.g. "textures,buffers",
+// and all of them are on if it isn't set. each set has a generation number, which is odd while the set is on and goes
+// up by one every time it's turned on or off. shadows remember the generation they were made in, so that one which
+// could have missed an update while its set was off is never mistaken for a current one.
+const char* hook_set_names[HOOK_SET_COUNT] = {"textures", "buffers", "draws"};
+_Atomic uint32_t hook_set_generation[HOOK_SET_COUNT];
+pthread_mutex_t hook_sets_lock = PTHREAD_MUTEX_INITIALIZER;
 
 const char* libc_name = "libc.so.6";
 const char* libegl_name = "libEGL.so.1";
@@ -114,7 +230,7 @@ void (*real_glGetUniformiv)(unsigned int, int, int*) = NULL;
 void (*real_glLinkProgram)(unsigned int) = NULL;
 void (*real_glUseProgram)(unsigned int) = NULL;
 void (*real_glTexStorage2D)(uint32_t, int, uint32_t, unsigned int, unsigned int) = NULL;
-void (*real_glUniform1i)(int, int);
+void (*real_glUniform1i)(int, int) = NULL;
 void (*real_glUniformMatrix4fv)(int, unsigned int, uint8_t, const float*) = NULL;
 void (*real_glVertexAttribPointer)(unsigned int, int, uint32_t, uint8_t, unsigned int, const void*) = NULL;
 void (*real_glBindBuffer)(uint32_t, unsigned int) = NULL;
@@ -122,6 +238,11 @@ void (*real_glBufferData)(uint32_t, uintptr_t, const void*, uint32_t) = NULL;
 void (*real_glDeleteBuffers)(unsigned int, const unsigned int*) = NULL;
 void (*real_glBindFramebuffer)(uint32_t, unsigned int) = NULL;
 void (*real_glFramebufferTextureLayer)(uint32_t, uint32_t, unsigned int, int, int) = NULL;
+void (*real_glFramebufferTexture2D)(uint32_t, uint32_t, uint32_t, unsigned int, int) = NULL;
+void (*real_glDeleteFramebuffers)(unsigned int, const unsigned int*) = NULL;
+void (*real_glBlitFramebuffer)(int, int, int, int, int, int, int, int, uint32_t, uint32_t) = NULL;
+void (*real_glBindTextures)(unsigned int, int, const unsigned int*) = NULL;
+void (*real_glBindTextureUnit)(unsigned int, unsigned int) = NULL;
 void (*real_glCompressedTexSubImage2D)(uint32_t, int, int, int, unsigned int, unsigned int, uint32_t, unsigned int, const void*) = NULL;
 void (*real_glCopyImageSubData)(unsigned int, uint32_t, int, int, int, int, unsigned int, uint32_t, int, int, int, int, unsigned int, unsigned int, unsigned int) = NULL;
 void (*real_glEnableVertexAttribArray)(unsigned int) = NULL;
@@ -132,24 +253,24 @@ void (*real_glBufferStorage)(unsigned int, uintptr_t, const void*, uintptr_t) =
 void (*real_glFlushMappedBufferRange)(uint32_t, intptr_t, uintptr_t) = NULL;
 void (*real_glBufferSubData)(uint32_t, intptr_t, uintptr_t, const void*) = NULL;
 void (*real_glGetIntegerv)(uint32_t, int*) = NULL;
+void (*real_glBindVertexArray)(unsigned int) = NULL;
+void (*real_glDeleteVertexArrays)(unsigned int, const unsigned int*) = NULL;
 
 /* opengl functions that are usually loaded dynamically from libGL.so */
 void (*real_glDrawElements)(uint32_t, unsigned int, uint32_t, const void*) = NULL;
 void (*real_glDrawArrays)(uint32_t, int, unsigned int) = NULL;
+void (*real_glClear)(uint32_t) = NULL;
 void (*real_glBindTexture)(uint32_t, unsigned int) = NULL;
+void (*real_glActiveTexture)(uint32_t) = NULL;
 void (*real_glTexSubImage2D)(uint32_t, int, int, int, unsigned int, unsigned int, uint32_t, uint32_t, const void*) = NULL;
 void (*real_glDeleteTextures)(unsigned int, const unsigned int*) = NULL;
 uint32_t (*real_glGetError)() = NULL;
 void (*real_glFlush)() = NULL;
 
-void _bolt_unpack_rgb565(uint16_t packed, uint8_t out[3]) {
-    out[0] = (packed >> 11) & 0b00011111;
-    out[0] = (out[0] << 3) | (out[0] >> 2);
-    out[1] = (packed >> 5) & 0b00111111;
-    out[1] = (out[1] << 2) | (out[1] >> 4);
-    out[2] = packed & 0b00011111;
-    out[2] = (out[2] << 3) | (out[2] >> 2);
-}
+#define HOOK_DISPATCH(SET, NAME, HOOK) static _Atomic(__typeof__(real_##NAME)) dispatch_##NAME = NULL;
+BOLT_HOOK_SET_MEMBERS(HOOK_DISPATCH)
+#undef HOOK_DISPATCH
+#define DISPATCH(NAME) atomic_load_explicit(&dispatch_##NAME, memory_order_relaxed)
 
 ElfW(Word) _bolt_hash_elf(const char* name) {
 	ElfW(Word) tmp, hash = 0;
@@ -179,7 +300,8 @@ Elf32_Word _bolt_hash_gnu(const char* name) {
 
 // Note: it'd be possible to one-pass all the symbols in the module instead of seeking them one-at-a-time,
 // but I'm pretty sure the DT hash lookup mechanisms make the one-at-a-time method faster for this use-case.
-const ElfW(Sym)* _bolt_lookup_symbol(const char* symbol_name, const Elf32_Word* gnu_hash_table, const ElfW(Word)* hash_table, const char* string_table, const ElfW(Sym)* symbol_table) {
+// gnu_hash must be _bolt_hash_gnu(symbol_name), which callers already have from the hook table.
+const ElfW(Sym)* _bolt_lookup_symbol(const char* symbol_name, Elf32_Word gnu_hash, const Elf32_Word* gnu_hash_table, const ElfW(Word)* hash_table, const char* string_table, const ElfW(Sym)* symbol_table) {
     if (gnu_hash_table && gnu_hash_table[0] != 0) {
         const Elf32_Word nbuckets = gnu_hash_table[0];
         const Elf32_Word symbias = gnu_hash_table[1];
@@ -190,7 +312,7 @@ const ElfW(Sym)* _bolt_lookup_symbol(const char* symbol_name, const Elf32_Word*
         const Elf32_Word* buckets = &gnu_hash_table[4 + (__ELF_NATIVE_CLASS / 32) * bitmask_nwords];
         const Elf32_Word* chain_zero = &buckets[nbuckets] - symbias;
 
-        Elf32_Word hash = _bolt_hash_gnu(symbol_name);
+        const Elf32_Word hash = gnu_hash;
 
         ElfW(Addr) bitmask_word = bitmask[(hash / __ELF_NATIVE_CLASS) & bitmask_idxbits];
         Elf32_Word hashbit1 = hash & (__ELF_NATIVE_CLASS - 1);
@@ -232,60 +354,17 @@ const ElfW(Sym)* _bolt_lookup_symbol(const char* symbol_name, const Elf32_Word*
     return NULL;
 }
 
-void _bolt_init_libc(unsigned long addr, const Elf32_Word* gnu_hash_table, const ElfW(Word)* hash_table, const char* string_table, const ElfW(Sym)* symbol_table) {
-    libc_addr = (void*)addr;
-    const ElfW(Sym)* sym = _bolt_lookup_symbol("dlopen", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_dlopen = sym->st_value + libc_addr;
-    sym = _bolt_lookup_symbol("dlsym", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_dlsym = sym->st_value + libc_addr;
-    sym = _bolt_lookup_symbol("dlvsym", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_dlvsym = sym->st_value + libc_addr;
-    sym = _bolt_lookup_symbol("dlclose", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_dlclose = sym->st_value + libc_addr;
-}
-
-void _bolt_init_libegl(unsigned long addr, const Elf32_Word* gnu_hash_table, const ElfW(Word)* hash_table, const char* string_table, const ElfW(Sym)* symbol_table) {
-    libegl_addr = (void*)addr;
-    const ElfW(Sym)* sym = _bolt_lookup_symbol("eglGetProcAddress", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_eglGetProcAddress = sym->st_value + libegl_addr;
-    sym = _bolt_lookup_symbol("eglSwapBuffers", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_eglSwapBuffers = sym->st_value + libegl_addr;
-    sym = _bolt_lookup_symbol("eglMakeCurrent", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_eglMakeCurrent = sym->st_value + libegl_addr;
-    sym = _bolt_lookup_symbol("eglDestroyContext", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_eglDestroyContext = sym->st_value + libegl_addr;
-    sym = _bolt_lookup_symbol("eglInitialize", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_eglInitialize = sym->st_value + libegl_addr;
-    sym = _bolt_lookup_symbol("eglCreateContext", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_eglCreateContext = sym->st_value + libegl_addr;
-    sym = _bolt_lookup_symbol("eglTerminate", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_eglTerminate = sym->st_value + libegl_addr;
-}
-
-void _bolt_init_libgl(unsigned long addr, const Elf32_Word* gnu_hash_table, const ElfW(Word)* hash_table, const char* string_table, const ElfW(Sym)* symbol_table) {
-    libgl_addr = (void*)addr;
-    const ElfW(Sym)* sym = _bolt_lookup_symbol("glDrawElements", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_glDrawElements = sym->st_value + libgl_addr;
-    sym = _bolt_lookup_symbol("glDrawArrays", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_glDrawArrays = sym->st_value + libgl_addr;
-    sym = _bolt_lookup_symbol("glBindTexture", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_glBindTexture = sym->st_value + libgl_addr;
-    sym = _bolt_lookup_symbol("glTexSubImage2D", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_glTexSubImage2D = sym->st_value + libgl_addr;
-    sym = _bolt_lookup_symbol("glDeleteTextures", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_glDeleteTextures = sym->st_value + libgl_addr;
-    sym = _bolt_lookup_symbol("glGetError", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_glGetError = sym->st_value + libgl_addr;
-    sym = _bolt_lookup_symbol("glFlush", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_glFlush = sym->st_value + libgl_addr;
-}
-
-void _bolt_init_libxcb(unsigned long addr, const Elf32_Word* gnu_hash_table, const ElfW(Word)* hash_table, const char* string_table, const ElfW(Sym)* symbol_table) {
-    libxcb_addr = (void*)addr;
-    const ElfW(Sym)* sym = _bolt_lookup_symbol("xcb_poll_for_event", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_xcb_poll_for_event = sym->st_value + libxcb_addr;
-    sym = _bolt_lookup_symbol("xcb_wait_for_event", gnu_hash_table, hash_table, string_table, symbol_table);
-    if (sym) real_xcb_wait_for_event = sym->st_value + libxcb_addr;
+static void _bolt_init_module(void**, unsigned long, const Elf32_Word*, const ElfW(Word)*, const char*, const ElfW(Sym)*);
+static void _bolt_build_hook_table();
+static void _bolt_refresh_hook_sets();
+
+// whether a comma-separated list contains `name`
+static uint8_t _bolt_list_has(const char* list, const char* name) {
+    const size_t len = strlen(name);
+    for (const char* p = list; *p; p += 1) {
+        if ((p == list || p[-1] == ',') && !strncmp(p, name, len) && (p[len] == ',' || !p[len])) return 1;
+    }
+    return 0;
 }
 
 int _bolt_dl_iterate_callback(struct dl_phdr_info* info, size_t size, void* args) {
@@ -323,7 +402,7 @@ int _bolt_dl_iterate_callback(struct dl_phdr_info* info, size_t size, void* args
 
     // checks if the currently-iterated module name ends with '/'+name
     // and if it does, calls the init function for that module, then returns 0
-#define FILENAME_EQ_INIT(NAME) { size_t lib_name_len = strlen(NAME##_name); if (name_len > lib_name_len && info->dlpi_name[name_len - lib_name_len - 1] == '/' && !strcmp(info->dlpi_name + name_len - lib_name_len, NAME##_name)) { _bolt_init_##NAME(info->dlpi_addr, gnu_hash_table, hash_table, string_table, symbol_table); return 0; } }
+#define FILENAME_EQ_INIT(NAME) { size_t lib_name_len = strlen(NAME##_name); if (name_len > lib_name_len && info->dlpi_name[name_len - lib_name_len - 1] == '/' && !strcmp(info->dlpi_name + name_len - lib_name_len, NAME##_name)) { _bolt_init_module(&NAME##_addr, info->dlpi_addr, gnu_hash_table, hash_table, string_table, symbol_table); return 0; } }
     FILENAME_EQ_INIT(libc);
     FILENAME_EQ_INIT(libegl);
     FILENAME_EQ_INIT(libxcb);
@@ -335,26 +414,128 @@ int _bolt_dl_iterate_callback(struct dl_phdr_info* info, size_t size, void* args
 
 void _bolt_init_functions() {
     pthread_mutex_init(&egl_lock, NULL);
+    const char* lag = getenv("BOLT_MAX_FRAME_LAG");
+    if (lag && *lag) max_frame_lag = (uint32_t)strtoul(lag, NULL, 10);
+    const char* huge_pages = getenv("BOLT_POOL_HUGE_PAGES");
+    const char* cache_mb = getenv("BOLT_POOL_CACHE_MB");
+    const char* stats = getenv("BOLT_POOL_STATS");
+    _bolt_pool_init(huge_pages && *huge_pages && *huge_pages != '0', (cache_mb && *cache_mb) ? strtoul(cache_mb, NULL, 10) << 20 : DEFAULT_POOL_CACHE_BYTES);
+    print_pool_stats = stats && *stats && *stats != '0';
+    const char* debug = getenv("BOLT_DEBUG_BINDINGS");
+    debug_bindings = debug && *debug && *debug != '0';
+    const char* staging_mb = getenv("BOLT_STAGING_MB");
+    if (staging_mb && *staging_mb) staging_arena_bytes = strtoul(staging_mb, NULL, 10) << 20;
+    const char* backlog = getenv("BOLT_WORKER_BACKLOG");
+    if (backlog && *backlog) backlog_limit = strtoul(backlog, NULL, 10);
+    const char* capture_budget = getenv("BOLT_CAPTURE_BUDGET_US");
+    if (capture_budget && *capture_budget) capture_budget_ns = (uint64_t)strtoull(capture_budget, NULL, 10) * 1000;
+    const char* upload_stats = getenv("BOLT_UPLOAD_STATS");
+    print_upload_stats = upload_stats && *upload_stats && *upload_stats != '0';
+    const char* texture_stats = getenv("BOLT_TEXTURE_STATS");
+    print_texture_stats = texture_stats && *texture_stats && *texture_stats != '0';
+    const char* dirty_pages = getenv("BOLT_DIRTY_PAGES");
+    if (dirty_pages && *dirty_pages && *dirty_pages != '0') {
+        const long page_size = sysconf(_SC_PAGESIZE);
+        if (page_size > 0 && !(page_size & (page_size - 1))) dirty_page_size = (size_t)page_size;
+    }
+    const char* hook_sets = getenv("BOLT_HOOK_SETS");
+    for (unsigned int set = 0; set < HOOK_SET_COUNT; set += 1) {
+        atomic_store(&hook_set_generation[set], (!hook_sets || _bolt_list_has(hook_sets, hook_set_names[set])) ? 1 : 0);
+    }
+    _bolt_build_hook_table();
     dl_iterate_phdr(_bolt_dl_iterate_callback, NULL);
+    _bolt_refresh_hook_sets();
     inited = 1;
 }
 
 void glFlush();
 
+// gets binding state from what the hooks have tracked, and if BOLT_DEBUG_BINDINGS is set, checks it against the driver
+static void _bolt_check_binding(uint32_t pname, unsigned int tracked) {
+    int actual;
+    real_glGetIntegerv(pname, &actual);
+    if ((unsigned int)actual != tracked) printf("warning: binding 0x%X is %i, but the tracked value is %u\n", pname, actual, tracked);
+}
+
+// whether the current context's share group has buffer uploads that have to land before its next draw. other groups'
+// uploads don't matter here, since this context can't draw from their buffers.
+static uint8_t _bolt_sync_pending() {
+    struct GLContext* c = _bolt_context();
+    return c && atomic_load(&c->share_group->sync_before_next_draw);
+}
+
+static unsigned int _bolt_bound_buffer(struct GLContext* c, uint32_t target) {
+    const unsigned int bound = _bolt_context_buffer_binding(c, target);
+    if (debug_bindings) {
+        if (target == GL_ELEMENT_ARRAY_BUFFER) _bolt_check_binding(GL_VERTEX_ARRAY_BINDING, c->vertex_array_binding);
+        _bolt_check_binding(target == GL_ARRAY_BUFFER ? GL_ARRAY_BUFFER_BINDING : GL_ELEMENT_ARRAY_BUFFER_BINDING, bound);
+    }
+    return bound;
+}
+
+static unsigned int _bolt_bound_texture(struct GLContext* c) {
+    const unsigned int bound = _bolt_context_texture_binding(c);
+    if (debug_bindings) {
+        _bolt_check_binding(GL_ACTIVE_TEXTURE, GL_TEXTURE0 + c->active_texture_unit);
+        _bolt_check_binding(GL_TEXTURE_BINDING_2D, bound);
+    }
+    return bound;
+}
+
+// the texture that the bound program's uDiffuseMap samples from, which is on whatever unit the sampler is set to, not
+// necessarily the active one
+static unsigned int _bolt_diffuse_texture(struct GLContext* c) {
+    const int unit = c->current_program.diffuse_unit;
+    if (debug_bindings) {
+        int actual;
+        real_glGetUniformiv(c->bound_program_id, c->current_program.loc_uDiffuseMap, &actual);
+        if (actual != unit) printf("warning: uDiffuseMap is %i, but the tracked value is %i\n", actual, unit);
+    }
+    return unit < 0 ? 0 : _bolt_context_unit_texture_binding(c, (unsigned int)unit);
+}
+
+// program state is only needed by the hooks, so unlike textures and buffers, programs are managed entirely on the
+// calling thread and never go through the worker
 unsigned int _bolt_glCreateProgram() {
     unsigned int id = real_glCreateProgram();
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glCreateProgram, .asset = id})
+    struct GLContext* c = _bolt_context();
+    if (!c) return id;
+    pthread_mutex_lock(c->shared_programs_lock);
+    struct GLProgram* program = _bolt_get_program(c->shared_programs, id);
+    if (program) {
+        program->loc_aVertexPosition2D = -1;
+        program->loc_aVertexColour = -1;
+        program->loc_aTextureUV = -1;
+        program->loc_aTextureUVAtlasMin = -1;
+        program->loc_aTextureUVAtlasExtents = -1;
+        program->loc_uProjectionMatrix = -1;
+        program->loc_uDiffuseMap = -1;
+        program->is_important = 0;
+        // the id may have belonged to a program that's been deleted since
+        program->link = atomic_fetch_add(&c->share_group->program_links, 1) + 1;
+    }
+    pthread_mutex_unlock(c->shared_programs_lock);
     return id;
 }
 
 void _bolt_glBindAttribLocation(unsigned int program, unsigned int index, const char* name) {
     real_glBindAttribLocation(program, index, name);
-    // I think `name` always points to an embedded string in the exe, so we don't need to reallocate it here
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glBindAttribLocation, .asset = program, .index = index, .data = (void*)name, .do_free_data = 0})
+    struct GLContext* c = _bolt_context();
+    if (!c) return;
+    pthread_mutex_lock(c->shared_programs_lock);
+    struct GLProgram* p = _bolt_find_program(c->shared_programs, program);
+    if (p) {
+        if (!strcmp(name, "aVertexPosition2D")) p->loc_aVertexPosition2D = index;
+        if (!strcmp(name, "aVertexColour")) p->loc_aVertexColour = index;
+        if (!strcmp(name, "aTextureUV")) p->loc_aTextureUV = index;
+        if (!strcmp(name, "aTextureUVAtlasMin")) p->loc_aTextureUVAtlasMin = index;
+        if (!strcmp(name, "aTextureUVAtlasExtents")) p->loc_aTextureUVAtlasExtents = index;
+    }
+    pthread_mutex_unlock(c->shared_programs_lock);
 }
 
-void _bolt_glGetUniformLocation(unsigned int program, const char* name) {
-    real_glGetUniformLocation(program, name);
+int _bolt_glGetUniformLocation(unsigned int program, const char* name) {
+    return real_glGetUniformLocation(program, name);
 }
 
 void _bolt_glGetUniformfv(unsigned int program, int location, float* params) {
@@ -365,149 +546,399 @@ void _bolt_glGetUniformiv(unsigned int program, int location, int* params) {
     real_glGetUniformiv(program, location, params);
 }
 
+// copies the bound program into the context, see GLContext::current_program
+static void _bolt_refresh_current_program(struct GLContext* c) {
+    pthread_mutex_lock(c->shared_programs_lock);
+    c->program_links = atomic_load(&c->share_group->program_links);
+    const struct GLProgram* p = _bolt_find_program(c->shared_programs, c->bound_program_id);
+    if (p) c->current_program = *p;
+    else memset(&c->current_program, 0, sizeof(c->current_program));
+    pthread_mutex_unlock(c->shared_programs_lock);
+}
+
 void _bolt_glLinkProgram(unsigned int program) {
     real_glLinkProgram(program);
+    struct GLContext* c = _bolt_context();
+    if (!c) return;
     int uDiffuseMap = real_glGetUniformLocation(program, "uDiffuseMap");
     int uProjectionMatrix = real_glGetUniformLocation(program, "uProjectionMatrix");
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glLinkProgram, .asset = program, .x = uDiffuseMap, .y = uProjectionMatrix})
+    // linking resets uniforms to their initial values, which for a sampler is 0 unless the shader gives it a binding
+    int diffuse_unit = 0;
+    if (uDiffuseMap != -1) real_glGetUniformiv(program, uDiffuseMap, &diffuse_unit);
+    pthread_mutex_lock(c->shared_programs_lock);
+    struct GLProgram* p = _bolt_find_program(c->shared_programs, program);
+    if (p) {
+        // a relink can change everything, so nothing from the last link is kept
+        p->is_important = 0;
+        p->diffuse_unit = diffuse_unit;
+        p->link = atomic_fetch_add(&c->share_group->program_links, 1) + 1;
+    }
+    if (p && p->loc_aVertexPosition2D != -1 && p->loc_aVertexColour != -1 && p->loc_aTextureUV != -1 && p->loc_aTextureUVAtlasMin != -1 && p->loc_aTextureUVAtlasExtents != -1) {
+        // yeah, this is lazy
+        if (uDiffuseMap != -1 && uProjectionMatrix != -1) {
+            p->loc_uDiffuseMap = uDiffuseMap;
+            p->loc_uProjectionMatrix = uProjectionMatrix;
+            p->is_important = 1;
+        }
+    }
+    pthread_mutex_unlock(c->shared_programs_lock);
+    if (program == c->bound_program_id) _bolt_refresh_current_program(c);
 }
 
 void _bolt_glUseProgram(unsigned int program) {
     real_glUseProgram(program);
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glUseProgram, .asset = program})
+    struct GLContext* c = _bolt_context();
+    if (!c) return;
+    // binding the same program again is only redundant if nothing in the group has been linked since it was copied
+    if (program == c->bound_program_id && c->program_links == atomic_load(&c->share_group->program_links)) return;
+    c->bound_program_id = program;
+    _bolt_refresh_current_program(c);
 }
 
-void _bolt_glTexStorage2D(uint32_t target, int levels, uint32_t internalformat, unsigned int width, unsigned int height) {
+// the only uniform that's tracked is uDiffuseMap, so that draws know which texture unit to take their texture from
+void _bolt_glUniform1i(int location, int v0) {
+    real_glUniform1i(location, v0);
+    struct GLContext* c = _bolt_context();
+    if (!c || location < 0) return;
+    if (c->program_links != atomic_load(&c->share_group->program_links)) _bolt_refresh_current_program(c);
+    if (location != c->current_program.loc_uDiffuseMap || v0 == c->current_program.diffuse_unit) return;
+    // uniforms belong to the program, so every context's copy of it has to pick this up
+    pthread_mutex_lock(c->shared_programs_lock);
+    struct GLProgram* p = _bolt_find_program(c->shared_programs, c->bound_program_id);
+    if (p) {
+        p->diffuse_unit = v0;
+        atomic_fetch_add(&c->share_group->program_links, 1);
+    }
+    pthread_mutex_unlock(c->shared_programs_lock);
+    _bolt_refresh_current_program(c);
+}
+
+void _bolt_hooked_glTexStorage2D(uint32_t target, int levels, uint32_t internalformat, unsigned int width, unsigned int height) {
     real_glTexStorage2D(target, levels, internalformat, width, height);
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glTexStorage2D, .target = target, .w = width, .h = height})
+    struct GLContext* c = _bolt_context();
+    if (!c || target != GL_TEXTURE_2D) return;
+    c->rendered_texture = 0;
+    // index is the generation the shadow is being made in
+    const uint32_t generation = atomic_load(&hook_set_generation[HOOK_SET_TEXTURES]);
+    SEND_MSG({.context = c, .instruction = Message_glTexStorage2D, .target = target, .asset = _bolt_bound_texture(c), .format = internalformat, .w = width, .h = height, .index = generation})
+}
+
+void _bolt_glTexStorage2D(uint32_t target, int levels, uint32_t internalformat, unsigned int width, unsigned int height) {
+    DISPATCH(glTexStorage2D)(target, levels, internalformat, width, height);
 }
 
 void _bolt_glVertexAttribPointer(unsigned int index, int size, uint32_t type, uint8_t normalised, unsigned int stride, const void* pointer) {
     real_glVertexAttribPointer(index, size, type, normalised, stride, pointer);
-    int array_binding;
-    real_glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &array_binding);
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glVertexAttribPointer, .index = index, .type = type, .asset = array_binding, .w = size, .bool_value = normalised, .stride = stride, .data = (void*)(uintptr_t)pointer})
+    struct GLContext* c = _bolt_context();
+    if (c) _bolt_context_set_attr(c, index, size, pointer, stride, type, normalised);
 }
 
 void _bolt_glBindBuffer(uint32_t target, unsigned int buffer) {
     real_glBindBuffer(target, buffer);
+    struct GLContext* c = _bolt_context();
+    if (c) _bolt_context_bind_buffer(c, target, buffer);
 }
 
-void _bolt_glBufferData(uint32_t target, uintptr_t size, const void* data, uint32_t usage) {
+void _bolt_glBindVertexArray(unsigned int array) {
+    real_glBindVertexArray(array);
+    struct GLContext* c = _bolt_context();
+    if (c) _bolt_context_bind_vertex_array(c, array);
+}
+
+void _bolt_glDeleteVertexArrays(unsigned int n, const unsigned int* arrays) {
+    real_glDeleteVertexArrays(n, arrays);
+    struct GLContext* c = _bolt_context();
+    if (c) _bolt_context_delete_vertex_arrays(c, n, arrays);
+}
+
+// buffer shadows are created and replaced on the calling thread, so that glMapBufferRange can resolve its
+// pointer without a round-trip to the worker. the shadow being replaced may still be referenced by messages
+// that are queued but not yet processed, so it gets sent to the worker, which puts it back in the buffer's
+// `spare` slot once it gets there. the next re-specification of the same size picks it up from there.
+void _bolt_set_buffer_shadow(uint32_t target, const void* data, uintptr_t size, enum BoltMessageType instruction) {
+    struct GLContext* c = _bolt_context();
+    if (!c) return;
+    const uint32_t generation = atomic_load(&hook_set_generation[HOOK_SET_BUFFERS]);
+    const unsigned int bound = _bolt_bound_buffer(c, target);
+    if (!bound) return;
+    const size_t capacity = _bolt_pool_capacity(size);
+    pthread_mutex_lock(c->shared_buffers_lock);
+    struct GLArrayBuffer* buffer = _bolt_get_buffer(c->shared_buffers, bound);
+    void* block = buffer->spare;
+    const size_t spare_capacity = buffer->spare_capacity;
+    buffer->spare = NULL;
+    pthread_mutex_unlock(c->shared_buffers_lock);
+
+    // the copy is done without holding the lock, since the worker needs it to read vertex data
+    if (block && spare_capacity != capacity) {
+        _bolt_pool_free(block, spare_capacity);
+        block = NULL;
+    }
+    // ranges in a shadow are 32-bit, and so is the capacity that goes back to the worker in BoltMessage::w, so a
+    // buffer of 4GiB or more just doesn't get a shadow, the same as if it couldn't be allocated
+    if (!block && capacity <= UINT_MAX) block = _bolt_pool_alloc(size);
+    if (block && data) memcpy(block, data, size);
+
+    pthread_mutex_lock(c->shared_buffers_lock);
+    buffer = _bolt_get_buffer(c->shared_buffers, bound);
+    void* old_data = buffer->data;
+    const size_t old_capacity = buffer->capacity;
+    buffer->data = block;
+    buffer->capacity = block ? capacity : 0;
+    buffer->generation = generation;
+    buffer->mapped = 0;
+    // the real buffer has just been given new contents, so anything that was waiting to be uploaded is out of date
+    buffer->dirty_count = 0;
+    pthread_mutex_unlock(c->shared_buffers_lock);
+    if (old_data) SEND_MSG({.context = c, .instruction = instruction, .target = target, .asset = bound, .data = old_data, .w = old_capacity})
+}
+
+void _bolt_hooked_glBufferData(uint32_t target, uintptr_t size, const void* data, uint32_t usage) {
     real_glBufferData(target, size, data, usage);
     if (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER) {
-        int bound;
-        real_glGetIntegerv(target == GL_ARRAY_BUFFER ? GL_ARRAY_BUFFER_BINDING : GL_ELEMENT_ARRAY_BUFFER_BINDING, &bound);
-        void* buffer = malloc(size);
-        if (data) memcpy(buffer, data, size);
-        SEND_MSG({.context = _bolt_context(), .instruction = Message_glBufferData, .target = target, .asset = bound, .data = buffer, .w = size, .do_free_data = 1})
+        _bolt_set_buffer_shadow(target, data, size, Message_glBufferData);
     }
 }
 
+// these sync first even when the buffers set is on, because when it's off nothing else would stop a pending upload from
+// the old shadow landing on top of the new contents. uploads are only pending between an unmap and the next draw, so
+// this almost never actually has to wait.
+void _bolt_glBufferData(uint32_t target, uintptr_t size, const void* data, uint32_t usage) {
+    if (_bolt_sync_pending()) glFlush();
+    DISPATCH(glBufferData)(target, size, data, usage);
+}
+
 void _bolt_glDeleteBuffers(unsigned int n, const unsigned int* buffers) {
     real_glDeleteBuffers(n, buffers);
-    void* ptr = malloc(n * sizeof(unsigned int));
-    memcpy(ptr, buffers, n * sizeof(unsigned int));
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glDeleteBuffers, .w = n, .data = ptr, .do_free_data = 1})
+    struct GLContext* c = _bolt_context();
+    if (!c) return;
+    _bolt_context_unbind_buffers(c, n, buffers);
+    struct GLBufferBlock* blocks = _bolt_staging_alloc(n * 2 * sizeof(*blocks));
+    pthread_mutex_lock(c->shared_buffers_lock);
+    size_t count = _bolt_context_destroy_buffers(c, n, buffers, blocks);
+    pthread_mutex_unlock(c->shared_buffers_lock);
+    SEND_MSG({.context = c, .instruction = Message_glDeleteBuffers, .w = count, .data = blocks, .do_free_data = 1})
 }
 
 void _bolt_glBindFramebuffer(uint32_t target, unsigned int framebuffer) {
     real_glBindFramebuffer(target, framebuffer);
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glBindFramebuffer, .target = target, .asset = framebuffer})
+    struct GLContext* c = _bolt_context();
+    if (!c) return;
+    switch (target) {
+        case 36008:
+            c->current_read_framebuffer = framebuffer;
+            break;
+        case 36009:
+            c->current_draw_framebuffer = framebuffer;
+            break;
+        case 36160:
+            c->current_read_framebuffer = framebuffer;
+            c->current_draw_framebuffer = framebuffer;
+            break;
+    }
 }
 
 void _bolt_glFramebufferTextureLayer(uint32_t target, uint32_t attachment, unsigned int texture, int level, int layer) {
     real_glFramebufferTextureLayer(target, attachment, texture, level, layer);
+    // a layer of an array texture replaces whatever 2D texture was attached
+    struct GLContext* c = _bolt_context();
+    if (c && attachment == GL_COLOR_ATTACHMENT0) _bolt_context_attach_texture(c, target, 0);
 }
 
-void _bolt_glCompressedTexSubImage2D(uint32_t target, int level, int xoffset, int yoffset, unsigned int width, unsigned int height, uint32_t format, unsigned int imageSize, const void* data) {
+void _bolt_glFramebufferTexture2D(uint32_t target, uint32_t attachment, uint32_t textarget, unsigned int texture, int level) {
+    real_glFramebufferTexture2D(target, attachment, textarget, texture, level);
+    struct GLContext* c = _bolt_context();
+    if (c && attachment == GL_COLOR_ATTACHMENT0) _bolt_context_attach_texture(c, target, (textarget == GL_TEXTURE_2D && level == 0) ? texture : 0);
+}
+
+void _bolt_glDeleteFramebuffers(unsigned int n, const unsigned int* framebuffers) {
+    real_glDeleteFramebuffers(n, framebuffers);
+    struct GLContext* c = _bolt_context();
+    if (c) _bolt_context_delete_framebuffers(c, n, framebuffers);
+}
+
+// the sprite index only knows about what was uploaded or copied into a texture, so anything else that writes to one
+// has to tell the worker to drop what it had indexed there
+static void _bolt_texture_written(struct GLContext* c, unsigned int texture, unsigned int x, unsigned int y, unsigned int w, unsigned int h) {
+    if (!(atomic_load(&hook_set_generation[HOOK_SET_TEXTURES]) & 1)) return;
+    SEND_MSG({.context = c, .instruction = Message_TextureWritten, .asset = texture, .x = x, .y = y, .w = w, .h = h})
+}
+
+// called before anything that draws to the bound draw framebuffer. the worker only needs telling once per texture until
+// something else writes to a texture, see GLContext::rendered_texture.
+static void _bolt_render_target_written(struct GLContext* c) {
+    if (!c || !c->current_draw_framebuffer || !(atomic_load(&hook_set_generation[HOOK_SET_TEXTURES]) & 1)) return;
+    const unsigned int texture = _bolt_context_render_target(c);
+    if (!texture || texture == c->rendered_texture) return;
+    c->rendered_texture = texture;
+    _bolt_texture_written(c, texture, 0, 0, UINT_MAX, UINT_MAX);
+}
+
+void _bolt_glBlitFramebuffer(int srcX0, int srcY0, int srcX1, int srcY1, int dstX0, int dstY0, int dstX1, int dstY1, uint32_t mask, uint32_t filter) {
+    _bolt_render_target_written(_bolt_context());
+    real_glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+}
+
+void glClear(uint32_t mask) {
+    _bolt_render_target_written(_bolt_context());
+    real_glClear(mask);
+}
+
+void _bolt_hooked_glCompressedTexSubImage2D(uint32_t target, int level, int xoffset, int yoffset, unsigned int width, unsigned int height, uint32_t format, unsigned int imageSize, const void* data) {
     real_glCompressedTexSubImage2D(target, level, xoffset, yoffset, width, height, format, imageSize, data);
     if (target != GL_TEXTURE_2D || level != 0) return;
     struct GLContext* c = _bolt_context();
-    SEND_MSG({.context = c, .instruction = Message_glCompressedTexSubImage2D, .x = xoffset, .y = yoffset, .w = width, .h = height, .format = format, .data = (void*)(uintptr_t)data, .do_free_data = 0})
+    if (!c) return;
+    c->rendered_texture = 0;
+    if (xoffset < 0 || yoffset < 0) return;
+    if (!data || !_bolt_dxt_block_size(format)) {
+        _bolt_texture_written(c, _bolt_bound_texture(c), xoffset, yoffset, width, height);
+        return;
+    }
+    // the worker reads a whole w*h worth of blocks, so a short imageSize (which GL rejects anyway) can't be trusted to
+    // have uploaded anything we could read back
+    const size_t size = _bolt_texture_upload_size(format, width, height);
+    if (imageSize < size) {
+        _bolt_texture_written(c, _bolt_bound_texture(c), xoffset, yoffset, width, height);
+        return;
+    }
+    // the game is free to reuse its copy as soon as this returns, so the worker gets its own
+    void* payload = _bolt_staging_copy(data, size);
+    SEND_MSG({.context = c, .instruction = Message_glCompressedTexSubImage2D, .asset = _bolt_bound_texture(c), .x = xoffset, .y = yoffset, .w = width, .h = height, .format = format, .data = payload, .do_free_data = 1})
+}
+
+void _bolt_glCompressedTexSubImage2D(uint32_t target, int level, int xoffset, int yoffset, unsigned int width, unsigned int height, uint32_t format, unsigned int imageSize, const void* data) {
+    DISPATCH(glCompressedTexSubImage2D)(target, level, xoffset, yoffset, width, height, format, imageSize, data);
+}
+
+void _bolt_hooked_glCopyImageSubData(unsigned int srcName, uint32_t srcTarget, int srcLevel, int srcX, int srcY, int srcZ,
+                                     unsigned int dstName, uint32_t dstTarget, int dstLevel, int dstX, int dstY, int dstZ,
+                                     unsigned int srcWidth, unsigned int srcHeight, unsigned int srcDepth) {
+    real_glCopyImageSubData(srcName, srcTarget, srcLevel, srcX, srcY, srcZ, dstName, dstTarget, dstLevel, dstX, dstY, dstZ, srcWidth, srcHeight, srcDepth);
+    if (dstTarget != GL_TEXTURE_2D || dstLevel != 0) return;
+    struct GLContext* c = _bolt_context();
+    if (c) c->rendered_texture = 0;
+    // negative offsets are a GL error, so nothing was copied. bounds are checked against the shadows on the worker.
+    if (dstX < 0 || dstY < 0 || dstZ != 0 || srcDepth != 1) return;
+    if (srcTarget != GL_TEXTURE_2D || srcLevel != 0 || srcX < 0 || srcY < 0 || srcZ != 0) {
+        if (c) _bolt_texture_written(c, dstName, dstX, dstY, srcWidth, srcHeight);
+        return;
+    }
+    SEND_MSG({.context = c, .instruction = Message_glCopyImageSubData, .index = srcName, .asset = dstName, .src_x = srcX, .src_y = srcY, .x = dstX, .y = dstY, .w = srcWidth, .h = srcHeight})
 }
 
 void _bolt_glCopyImageSubData(unsigned int srcName, uint32_t srcTarget, int srcLevel, int srcX, int srcY, int srcZ,
                               unsigned int dstName, uint32_t dstTarget, int dstLevel, int dstX, int dstY, int dstZ,
                               unsigned int srcWidth, unsigned int srcHeight, unsigned int srcDepth) {
-    real_glCopyImageSubData(srcName, srcTarget, srcLevel, srcX, srcY, srcZ, dstName, dstTarget, dstLevel, dstX, dstY, dstZ, srcWidth, srcHeight, srcDepth);
-    if (srcTarget == GL_TEXTURE_2D && dstTarget == GL_TEXTURE_2D && srcLevel == 0 && dstLevel == 0) {
-        struct {
-            struct BoltMessage head;
-            int tail[8];
-        } message = {
-            .head = {.context = _bolt_context(), .instruction = Message_glCopyImageSubData},
-            .tail = {srcName, srcX, srcY, dstName, dstX, dstY, srcWidth, srcHeight},
-        };
-        write(write_socket, &message, sizeof(message));
-    }
+    DISPATCH(glCopyImageSubData)(srcName, srcTarget, srcLevel, srcX, srcY, srcZ, dstName, dstTarget, dstLevel, dstX, dstY, dstZ, srcWidth, srcHeight, srcDepth);
 }
 
 void _bolt_glEnableVertexAttribArray(unsigned int index) {
     real_glEnableVertexAttribArray(index);
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glEnableVertexAttribArray, .index = index})
+    struct GLContext* c = _bolt_context();
+    if (c) _bolt_context_enable_attr(c, index, 1);
 }
 
 void _bolt_glDisableVertexAttribArray(unsigned int index) {
-    real_glEnableVertexAttribArray(index);
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glDisableVertexAttribArray, .index = index})
+    real_glDisableVertexAttribArray(index);
+    struct GLContext* c = _bolt_context();
+    if (c) _bolt_context_enable_attr(c, index, 0);
 }
 
+// mapping state lives in the shadow buffer, which is owned by the calling thread (see _bolt_set_buffer_shadow),
+// so mapping and unmapping never have to wait for the worker. buffers that we don't have a shadow for are
+// mapped for real, so unmap and flush fall back to the real functions for those too.
 void* _bolt_glMapBufferRange(uint32_t target, intptr_t offset, uintptr_t length, uint32_t access) {
-    if (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER) {
-        int buffer;
-        real_glGetIntegerv(target == GL_ARRAY_BUFFER ? GL_ARRAY_BUFFER_BINDING : GL_ELEMENT_ARRAY_BUFFER_BINDING, &buffer);
-        struct BoltSyncData data;
-        data.done = 0;
-        pthread_mutex_init(&data.mutex, NULL);
-        pthread_cond_init(&data.cond, NULL);
-        SEND_MSG({.context = _bolt_context(), .data = &data, .instruction = Message_glMapBufferRange, .target = target, .asset = buffer, .x = offset, .w = length, .format = access})
-        pthread_mutex_lock(&data.mutex);
-        while (!data.done) pthread_cond_wait(&data.cond, &data.mutex);
-        pthread_mutex_unlock(&data.mutex);
-        pthread_mutex_destroy(&data.mutex);
-        pthread_cond_destroy(&data.cond);
-        return data.ptr;
-    } else {
-        return real_glMapBufferRange(target, offset, length, access);
+    struct GLContext* c = _bolt_context();
+    if (c && (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER)) {
+        const unsigned int bound = _bolt_bound_buffer(c, target);
+        const uint32_t generation = atomic_load(&hook_set_generation[HOOK_SET_BUFFERS]);
+        void* ptr = NULL;
+        uint8_t stale = 0;
+        pthread_mutex_lock(c->shared_buffers_lock);
+        struct GLArrayBuffer* buffer = _bolt_find_buffer(c->shared_buffers, bound);
+        // a shadow from before the buffers set was last turned off might not match the real buffer any more
+        if (buffer && buffer->data && !((generation & 1) && buffer->generation == generation)) stale = 1;
+        else if (buffer && buffer->data) {
+            buffer->mapped = 1;
+            buffer->mapping_offset = offset;
+            buffer->mapping_len = length;
+            buffer->mapping_access_type = access;
+            buffer->page_sums_count = 0;
+            // shadows of a page or more come from mmap, so they're page-aligned
+            const uint32_t untracked = GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+            if (dirty_page_size && (access & GL_MAP_WRITE_BIT) && !(access & untracked) && buffer->capacity >= dirty_page_size &&
+                length >= DIRTY_PAGES_MIN_PAGES * dirty_page_size) {
+                _bolt_buffer_snapshot_pages(buffer, dirty_page_size);
+            }
+            ptr = buffer->data + offset;
+        }
+        pthread_mutex_unlock(c->shared_buffers_lock);
+        if (ptr) return ptr;
+        // the buffer gets mapped for real, so anything still waiting to be uploaded from the shadow has to land first
+        if (stale && atomic_load(&c->share_group->sync_before_next_draw)) glFlush();
     }
+    return real_glMapBufferRange(target, offset, length, access);
 }
 
 uint8_t _bolt_glUnmapBuffer(uint32_t target) {
-    if (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER) {
-        int buffer;
-        real_glGetIntegerv(target == GL_ARRAY_BUFFER ? GL_ARRAY_BUFFER_BINDING : GL_ELEMENT_ARRAY_BUFFER_BINDING, &buffer);
-        SEND_MSG({.context = _bolt_context(), .instruction = Message_glUnmapBuffer, .target = target, .asset = buffer})
-        sync_before_next_draw = 1;
-        return 1;
-    } else {
-        return real_glUnmapBuffer(target);
+    struct GLContext* c = _bolt_context();
+    if (c && (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER)) {
+        const unsigned int bound = _bolt_bound_buffer(c, target);
+        pthread_mutex_lock(c->shared_buffers_lock);
+        struct GLArrayBuffer* buffer = _bolt_find_buffer(c->shared_buffers, bound);
+        const uint8_t mapped = buffer && buffer->mapped;
+        const uint8_t upload = mapped && !(buffer->mapping_access_type & GL_MAP_FLUSH_EXPLICIT_BIT);
+        const unsigned int mapping_len = upload ? buffer->mapping_len : 0;
+        // a mapping without the write bit can't have changed anything
+        if (upload && (buffer->mapping_access_type & GL_MAP_WRITE_BIT)) {
+            if (buffer->page_sums_count) _bolt_context_mark_written_pages(c, buffer, dirty_page_size);
+            else _bolt_context_mark_buffer_dirty(c, buffer, buffer->mapping_offset, mapping_len);
+        }
+        if (mapped) buffer->mapped = 0;
+        pthread_mutex_unlock(c->shared_buffers_lock);
+        if (upload) {
+            atomic_fetch_add_explicit(&upload_this_frame.written, mapping_len, memory_order_relaxed);
+            atomic_store(&c->share_group->sync_before_next_draw, 1);
+        }
+        if (mapped) return 1;
     }
+    return real_glUnmapBuffer(target);
 }
 
-void _bolt_glBufferStorage(uint32_t target, uintptr_t size, const void* data, uintptr_t flags) {
+void _bolt_hooked_glBufferStorage(uint32_t target, uintptr_t size, const void* data, uintptr_t flags) {
     real_glBufferStorage(target, size, data, flags);
     if (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER) {
-        int bound;
-        real_glGetIntegerv(target == GL_ARRAY_BUFFER ? GL_ARRAY_BUFFER_BINDING : GL_ELEMENT_ARRAY_BUFFER_BINDING, &bound);
-        void* buffer = malloc(size);
-        if (data) memcpy(buffer, data, size);
-        SEND_MSG({.context = _bolt_context(), .instruction = Message_glBufferStorage, .target = target, .asset = bound, .data = buffer, .w = size, .do_free_data = 1})
+        _bolt_set_buffer_shadow(target, data, size, Message_glBufferStorage);
     }
 }
 
+void _bolt_glBufferStorage(uint32_t target, uintptr_t size, const void* data, uintptr_t flags) {
+    if (_bolt_sync_pending()) glFlush();
+    DISPATCH(glBufferStorage)(target, size, data, flags);
+}
+
 void _bolt_glFlushMappedBufferRange(uint32_t target, intptr_t offset, uintptr_t length) {
-    if (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER) {
-        int buffer;
-        real_glGetIntegerv(target == GL_ARRAY_BUFFER ? GL_ARRAY_BUFFER_BINDING : GL_ELEMENT_ARRAY_BUFFER_BINDING, &buffer);
-        SEND_MSG({.context = _bolt_context(), .instruction = Message_glFlushMappedBufferRange, .target = target, .asset = buffer, .x = offset, .w = length})
-        sync_before_next_draw = 1;
-    } else {
-        real_glFlushMappedBufferRange(target, offset, length);
+    struct GLContext* c = _bolt_context();
+    if (c && (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER)) {
+        const unsigned int bound = _bolt_bound_buffer(c, target);
+        pthread_mutex_lock(c->shared_buffers_lock);
+        struct GLArrayBuffer* buffer = _bolt_find_buffer(c->shared_buffers, bound);
+        const uint8_t mapped = buffer && buffer->mapped;
+        if (mapped) _bolt_context_mark_buffer_dirty(c, buffer, buffer->mapping_offset + offset, length);
+        pthread_mutex_unlock(c->shared_buffers_lock);
+        if (mapped) {
+            atomic_fetch_add_explicit(&upload_this_frame.written, length, memory_order_relaxed);
+            atomic_store(&c->share_group->sync_before_next_draw, 1);
+            return;
+        }
     }
+    real_glFlushMappedBufferRange(target, offset, length);
 }
 
 void _bolt_glBufferSubData(uint32_t target, intptr_t offset, uintptr_t size, const void* data) {
+    // a pending upload of the same range would overwrite this with older data from the shadow
+    if (_bolt_sync_pending()) glFlush();
     real_glBufferSubData(target, offset, size, data);
 }
 
@@ -515,67 +946,162 @@ void _bolt_glGetIntegerv(uint32_t pname, int* data) {
     real_glGetIntegerv(pname, data);
 }
 
-void glDrawElements(uint32_t mode, unsigned int count, uint32_t type, const void* indices) {
-    if (sync_before_next_draw) glFlush();
+void _bolt_hooked_glDrawElements(uint32_t mode, unsigned int count, uint32_t type, const void* indices) {
     real_glDrawElements(mode, count, type, indices);
 
-    if (type == GL_UNSIGNED_SHORT && mode == GL_TRIANGLES) {
-        int element_binding;
-        real_glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &element_binding);
-        SEND_MSG({.context = _bolt_context(), .instruction = Message_glDrawElements, .data = (void*)(uintptr_t)indices, .asset = element_binding, .w = count})
-    }
+    struct GLContext* c = _bolt_context();
+    if (!c || type != GL_UNSIGNED_SHORT || mode != GL_TRIANGLES || !count) return;
+    // the bound program may have been relinked since it was copied, maybe from a different context
+    if (c->program_links != atomic_load(&c->share_group->program_links)) _bolt_refresh_current_program(c);
+    if (!c->current_program.is_important || c->current_draw_framebuffer != 0) return;
+    const struct GLVertexFetcher* fetcher = _bolt_context_vertex_fetcher(c);
+    if (!fetcher) return;
+
+    // the worker sees this long after the context's state has moved on, and usually after the buffers have been
+    // written to again, so it gets a copy of everything it needs, including the vertex data itself
+    const struct GLDrawSnapshot draw = {
+        .attributes = *fetcher,
+        .program = c->bound_program_id,
+        .texture = _bolt_diffuse_texture(c),
+        .element_buffer = _bolt_bound_buffer(c, GL_ELEMENT_ARRAY_BUFFER),
+        .indices = (uintptr_t)indices,
+        .count = count,
+    };
+    const uint32_t generation = atomic_load(&hook_set_generation[HOOK_SET_BUFFERS]);
+    struct GLDrawSnapshot* snapshot = _bolt_capture_pin(c->share_group, &draw, generation, _bolt_staging_alloc);
+    if (snapshot) SEND_MSG({.context = c, .instruction = Message_glDrawElements, .data = snapshot, .do_free_data = 1})
+}
+
+// pending buffer uploads have to land before any draw, whether or not draws are being captured
+void glDrawElements(uint32_t mode, unsigned int count, uint32_t type, const void* indices) {
+    if (_bolt_sync_pending()) glFlush();
+    _bolt_render_target_written(_bolt_context());
+    DISPATCH(glDrawElements)(mode, count, type, indices);
 }
 
 void glDrawArrays(uint32_t mode, int first, unsigned int count) {
-    if (sync_before_next_draw) glFlush();
+    if (_bolt_sync_pending()) glFlush();
+    _bolt_render_target_written(_bolt_context());
     real_glDrawArrays(mode, first, count);
 }
 
 void glBindTexture(uint32_t target, unsigned int texture) {
     real_glBindTexture(target, texture);
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glBindTexture, .target = target, .asset = texture})
+    struct GLContext* c = _bolt_context();
+    if (c) _bolt_context_bind_texture(c, target, texture);
 }
 
-void glTexSubImage2D(uint32_t target, int level, int xoffset, int yoffset, unsigned int width, unsigned int height, uint32_t format, uint32_t type, const void* pixels) {
+void _bolt_glBindTextures(unsigned int first, int count, const unsigned int* textures) {
+    real_glBindTextures(first, count, textures);
+    struct GLContext* c = _bolt_context();
+    if (!c) return;
+    for (int i = 0; i < count; i += 1) _bolt_context_bind_unit_texture(c, first + i, textures ? textures[i] : 0);
+}
+
+void _bolt_glBindTextureUnit(unsigned int unit, unsigned int texture) {
+    real_glBindTextureUnit(unit, texture);
+    struct GLContext* c = _bolt_context();
+    if (c) _bolt_context_bind_unit_texture(c, unit, texture);
+}
+
+void glActiveTexture(uint32_t texture) {
+    real_glActiveTexture(texture);
+    struct GLContext* c = _bolt_context();
+    if (c) c->active_texture_unit = texture - GL_TEXTURE0;
+}
+
+void _bolt_hooked_glTexSubImage2D(uint32_t target, int level, int xoffset, int yoffset, unsigned int width, unsigned int height, uint32_t format, uint32_t type, const void* pixels) {
     real_glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
     struct GLContext* c = _bolt_context();
-    if (level == 0 && format == GL_RGBA) {
-        SEND_MSG({.context = c, .instruction = Message_glTexSubImage2D, .target = target, .x = xoffset, .y = yoffset, .w = width, .h = height, .format = format, .type = type, .data = (void*)(uintptr_t)pixels, .do_free_data = 0})
+    if (!c || target != GL_TEXTURE_2D || level != 0 || xoffset < 0 || yoffset < 0) return;
+    c->rendered_texture = 0;
+    if (type != GL_UNSIGNED_BYTE || (format != GL_RGBA && format != GL_RED && format != GL_RG)) {
+        _bolt_texture_written(c, _bolt_bound_texture(c), xoffset, yoffset, width, height);
+    } else {
+        // RGBA rows are always 4-byte aligned, but narrower formats depend on GL_UNPACK_ALIGNMENT, so only ask for it
+        // when it could actually make a difference. the game never sets an alignment of 8.
+        const unsigned int row_size = width * (format == GL_RGBA ? 4 : (format == GL_RG ? 2 : 1));
+        int alignment = 4;
+        if (row_size % 4) real_glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        if (alignment < 1) alignment = 1;
+        const unsigned int pitch = ((row_size + alignment - 1) / alignment) * alignment;
+        if (!pixels || !width || !height) return;
+        void* payload = _bolt_staging_copy(pixels, ((size_t)pitch * (height - 1)) + row_size);
+        SEND_MSG({.context = c, .instruction = Message_glTexSubImage2D, .target = target, .asset = _bolt_bound_texture(c), .x = xoffset, .y = yoffset, .w = width, .h = height, .format = format, .type = type, .stride = pitch, .data = payload, .do_free_data = 1})
     }
 }
 
+void glTexSubImage2D(uint32_t target, int level, int xoffset, int yoffset, unsigned int width, unsigned int height, uint32_t format, uint32_t type, const void* pixels) {
+    DISPATCH(glTexSubImage2D)(target, level, xoffset, yoffset, width, height, format, type, pixels);
+}
+
 void glDeleteTextures(unsigned int n, const unsigned int* textures) {
     real_glDeleteTextures(n, textures);
-    void* ptr = malloc(n * sizeof(unsigned int));
-    memcpy(ptr, textures, n * sizeof(unsigned int));
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_glDeleteTextures, .w = n, .data = ptr, .do_free_data = 1})
+    struct GLContext* c = _bolt_context();
+    if (c) _bolt_context_unbind_textures(c, n, textures);
+    void* ptr = _bolt_staging_copy(textures, n * sizeof(unsigned int));
+    SEND_MSG({.context = c, .instruction = Message_glDeleteTextures, .w = n, .data = ptr, .do_free_data = 1})
 }
 
 uint32_t glGetError() {
     return real_glGetError();
 }
 
+// sends everything that's dirty in the current context's share group to the worker in a single message
+static void _bolt_upload_dirty_buffers() {
+    struct GLContext* c = _bolt_context();
+    if (!c) return;
+    pthread_mutex_lock(c->shared_buffers_lock);
+    const size_t count = _bolt_context_buffer_upload_count(c);
+    struct GLBufferUpload* uploads = count ? _bolt_staging_alloc(count * sizeof(*uploads)) : NULL;
+    if (uploads) _bolt_context_take_buffer_uploads(c, uploads);
+    pthread_mutex_unlock(c->shared_buffers_lock);
+    if (!uploads) return;
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < count; i += 1) bytes += uploads[i].length;
+    atomic_fetch_add_explicit(&upload_this_frame.uploaded, bytes, memory_order_relaxed);
+    SEND_MSG({.context = c, .instruction = Message_BufferUploads, .data = uploads, .w = count, .do_free_data = 1})
+}
+
+// anything that uses a share group's worker has to hold on to it with these, so that it can't be freed in the meantime.
+// _bolt_stop_worker takes the worker out of its group first, so nothing new can pick it up, and then waits until
+// everything that already had it has let go. the caller's context keeps the group itself alive.
+static struct BoltWorker* _bolt_acquire_worker(struct GLShareGroup* group) {
+    atomic_fetch_add(&group->worker_users, 1);
+    struct BoltWorker* worker = atomic_load(&group->worker);
+    if (!worker) atomic_fetch_sub(&group->worker_users, 1);
+    return worker;
+}
+
+static void _bolt_release_worker(struct GLShareGroup* group) {
+    atomic_fetch_sub(&group->worker_users, 1);
+}
+
 void glFlush() {
-    sync_before_next_draw = 0;
+    struct GLContext* c = _bolt_context();
+    if (c) atomic_store(&c->share_group->sync_before_next_draw, 0);
+    _bolt_upload_dirty_buffers();
+    struct BoltWorker* worker = c ? _bolt_acquire_worker(c->share_group) : NULL;
+    if (!worker) {
+        real_glFlush();
+        return;
+    }
     struct BoltSyncData data;
     data.done = 0;
     pthread_mutex_init(&data.mutex, NULL);
     pthread_cond_init(&data.cond, NULL);
-    SEND_MSG({.instruction = Message_glFlush, .data = &data})
+    const struct BoltMessage message = {.context = c, .instruction = Message_glFlush, .data = &data};
+    _bolt_queue_push(&worker->queue, &message);
     real_glFlush();
     pthread_mutex_lock(&data.mutex);
-    while (!data.done) {
-        pthread_mutex_lock(&egl_lock);
-        uint8_t running = worker_thread_running;
-        pthread_mutex_unlock(&egl_lock);
-        if (!running) break;
-        pthread_cond_wait(&data.cond, &data.mutex);
-    }
+    while (!data.done && atomic_load(&worker->running)) pthread_cond_wait(&data.cond, &data.mutex);
     pthread_mutex_unlock(&data.mutex);
     pthread_mutex_destroy(&data.mutex);
     pthread_cond_destroy(&data.cond);
+    _bolt_release_worker(c->share_group);
 }
 
+void* eglGetProcAddress(const char*);
 unsigned int eglSwapBuffers(void*, void*);
 unsigned int eglMakeCurrent(void*, void*, void*, void*);
 unsigned int eglDestroyContext(void*, void*);
@@ -583,84 +1109,295 @@ unsigned int eglInitialize(void*, void*, void*);
 void* eglCreateContext(void*, void*, void*, const void*);
 unsigned int eglTerminate(void*);
 
-void* eglGetProcAddress(const char* name) {
-    //printf("eglGetProcAddress(%s)\n", name);
-    if (!strcmp(name, "eglGetProcAddress")) {
-        return eglGetProcAddress;
-    }
-    if (!strcmp(name, "eglSwapBuffers")) {
-        real_eglSwapBuffers = real_eglGetProcAddress("eglSwapBuffers");
-        return eglSwapBuffers;
+void* xcb_poll_for_event(void*);
+void* xcb_wait_for_event(void*);
+void* dlopen(const char*, int);
+void* dlsym(void*, const char*);
+void* dlvsym(void*, const char*, const char*);
+int dlclose(void*);
+
+struct BoltHook {
+    const char* name;
+    void** module; // where the address of the module it comes from is kept, e.g. &libgl_addr
+    void** real;
+    void* hook;
+    uint8_t flags;
+};
+#define HOOK_ENTRY(MODULE, NAME, HOOK, FLAGS) {.name = #NAME, .module = &MODULE##_addr, .real = (void**)&real_##NAME, .hook = (void*)HOOK, .flags = FLAGS},
+static const struct BoltHook hooks[] = {BOLT_HOOKS(HOOK_ENTRY)};
+#undef HOOK_ENTRY
+#define HOOK_COUNT (sizeof(hooks) / sizeof(*hooks))
+
+// hooks by name. the table is built once at init, using a multiplier on the GNU hash of each name that puts every hook
+// in its own slot, so a lookup is one hash, one slot, and at most one strcmp, and most misses don't need a strcmp at
+// all. if no such multiplier turns up, the last one tried is used with linear probing, which is still correct.
+#define HOOK_TABLE_BITS 8
+#define HOOK_TABLE_SIZE (1 << HOOK_TABLE_BITS)
+#define HOOK_SEED_ATTEMPTS 4096
+#define HOOK_SLOT(HASH) (((uint32_t)(HASH) * hook_seed) >> (32 - HOOK_TABLE_BITS))
+_Static_assert(HOOK_COUNT * 2 <= HOOK_TABLE_SIZE, "hook table is too small");
+static Elf32_Word hook_hashes[HOOK_COUNT];
+static uint8_t hook_slots[HOOK_TABLE_SIZE]; // index into hooks plus one, or 0 if empty
+static uint32_t hook_seed = 0;
+
+static void _bolt_build_hook_table() {
+    for (size_t i = 0; i < HOOK_COUNT; i += 1) hook_hashes[i] = _bolt_hash_gnu(hooks[i].name);
+    for (uint32_t attempt = 0; attempt < HOOK_SEED_ATTEMPTS; attempt += 1) {
+        hook_seed = 0x9E3779B1u + (attempt * 2);
+        memset(hook_slots, 0, sizeof(hook_slots));
+        uint8_t displaced = 0;
+        for (size_t i = 0; i < HOOK_COUNT; i += 1) {
+            uint32_t slot = HOOK_SLOT(hook_hashes[i]);
+            while (hook_slots[slot]) {
+                slot = (slot + 1) & (HOOK_TABLE_SIZE - 1);
+                displaced = 1;
+            }
+            hook_slots[slot] = (uint8_t)(i + 1);
+        }
+        if (!displaced) break;
     }
-    if (!strcmp(name, "eglMakeCurrent")) {
-        real_eglMakeCurrent = real_eglGetProcAddress("eglMakeCurrent");
-        return eglMakeCurrent;
+}
+
+static const struct BoltHook* _bolt_find_hook(const char* name) {
+    const Elf32_Word hash = _bolt_hash_gnu(name);
+    for (uint32_t slot = HOOK_SLOT(hash);; slot = (slot + 1) & (HOOK_TABLE_SIZE - 1)) {
+        const uint8_t index = hook_slots[slot];
+        if (!index) return NULL;
+        if (hook_hashes[index - 1] == hash && !strcmp(hooks[index - 1].name, name)) return &hooks[index - 1];
     }
-    if (!strcmp(name, "eglInitialize")) {
-        real_eglInitialize = real_eglGetProcAddress("eglInitialize");
-        return eglInitialize;
+}
+
+// resolves the real versions of everything we hook from one module, in one pass over the hooks
+static void _bolt_init_module(void** module, unsigned long addr, const Elf32_Word* gnu_hash_table, const ElfW(Word)* hash_table, const char* string_table, const ElfW(Sym)* symbol_table) {
+    *module = (void*)addr;
+    for (size_t i = 0; i < HOOK_COUNT; i += 1) {
+        if (hooks[i].module != module || !(hooks[i].flags & HOOK_EXPORT)) continue;
+        const ElfW(Sym)* sym = _bolt_lookup_symbol(hooks[i].name, hook_hashes[i], gnu_hash_table, hash_table, string_table, symbol_table);
+        if (sym) *hooks[i].real = (void*)(addr + sym->st_value);
     }
-    if (!strcmp(name, "eglDestroyContext")) {
-        real_eglDestroyContext = real_eglGetProcAddress("eglDestroyContext");
-        return eglDestroyContext;
+}
+
+// same as above, for a module that the game has just dlopen'd
+static void _bolt_dlsym_module(void** module) {
+    for (size_t i = 0; i < HOOK_COUNT; i += 1) {
+        if (hooks[i].module == module && (hooks[i].flags & HOOK_EXPORT)) *hooks[i].real = real_dlsym(*module, hooks[i].name);
     }
-    if (!strcmp(name, "eglCreateContext")) {
-        real_eglCreateContext = real_eglGetProcAddress("eglCreateContext");
-        return eglCreateContext;
+    _bolt_refresh_hook_sets();
+}
+
+struct BoltHookSetMember {
+    unsigned int set;
+    _Atomic(void*)* dispatch;
+    void** real;
+    void* hook;
+};
+#define HOOK_SET_MEMBER(SET, NAME, HOOK) {.set = SET, .dispatch = (_Atomic(void*)*)&dispatch_##NAME, .real = (void**)&real_##NAME, .hook = (void*)HOOK},
+static const struct BoltHookSetMember hook_set_members[] = {BOLT_HOOK_SET_MEMBERS(HOOK_SET_MEMBER)};
+#undef HOOK_SET_MEMBER
+
+// points every dispatch pointer at its hook or at the real function, depending on whether its set is on. this has to
+// be redone whenever a real function is resolved, since a set that's off uses the real function directly.
+static void _bolt_refresh_hook_sets() {
+    pthread_mutex_lock(&hook_sets_lock);
+    for (size_t i = 0; i < sizeof(hook_set_members) / sizeof(*hook_set_members); i += 1) {
+        const struct BoltHookSetMember* member = &hook_set_members[i];
+        const uint8_t on = atomic_load(&hook_set_generation[member->set]) & 1;
+        atomic_store(member->dispatch, on ? member->hook : *member->real);
     }
-    if (!strcmp(name, "eglTerminate")) {
-        real_eglTerminate = real_eglGetProcAddress("eglTerminate");
-        return eglTerminate;
+    pthread_mutex_unlock(&hook_sets_lock);
+}
+
+// turns a feature set on or off. may be called from any thread at any time. a set that's off costs the game one
+// indirect call per function in it, but anything it would have shadowed in the meantime is lost: shadows that could be
+// out of date are ignored from then on, so turning a set back on only picks up objects as the game respecifies them.
+void _bolt_enable_hook_set(unsigned int set, uint8_t enabled) {
+    if (set >= HOOK_SET_COUNT) return;
+    pthread_mutex_lock(&hook_sets_lock);
+    const uint32_t generation = atomic_load(&hook_set_generation[set]);
+    const uint8_t changed = (generation & 1) != (enabled ? 1 : 0);
+    if (changed) atomic_store(&hook_set_generation[set], generation + 1);
+    pthread_mutex_unlock(&hook_sets_lock);
+    if (changed) _bolt_refresh_hook_sets();
+}
+
+void* eglGetProcAddress(const char* name) {
+    //printf("eglGetProcAddress(%s)\n", name);
+    const struct BoltHook* hook = _bolt_find_hook(name);
+    if (hook && (hook->flags & HOOK_PROC)) {
+        if (hook->flags & HOOK_PROC_RESOLVE) {
+            *hook->real = real_eglGetProcAddress(name);
+            _bolt_refresh_hook_sets();
+        }
+        return (!(hook->flags & HOOK_PROC_OPTIONAL) || *hook->real) ? hook->hook : NULL;
     }
-#define PROC_ADDRESS_MAP(FUNC) if (!strcmp(name, #FUNC)) { real_##FUNC = real_eglGetProcAddress(#FUNC); return real_##FUNC ? _bolt_##FUNC : NULL; }
-    PROC_ADDRESS_MAP(glCreateProgram)
-    PROC_ADDRESS_MAP(glBindAttribLocation)
-    PROC_ADDRESS_MAP(glGetUniformLocation)
-    PROC_ADDRESS_MAP(glGetUniformfv)
-    PROC_ADDRESS_MAP(glGetUniformiv)
-    PROC_ADDRESS_MAP(glLinkProgram)
-    PROC_ADDRESS_MAP(glUseProgram)
-    PROC_ADDRESS_MAP(glTexStorage2D)
-    PROC_ADDRESS_MAP(glVertexAttribPointer)
-    PROC_ADDRESS_MAP(glBindBuffer)
-    PROC_ADDRESS_MAP(glBufferData)
-    PROC_ADDRESS_MAP(glDeleteBuffers)
-    PROC_ADDRESS_MAP(glBindFramebuffer)
-    PROC_ADDRESS_MAP(glFramebufferTextureLayer)
-    PROC_ADDRESS_MAP(glCompressedTexSubImage2D)
-    PROC_ADDRESS_MAP(glCopyImageSubData)
-    PROC_ADDRESS_MAP(glEnableVertexAttribArray)
-    PROC_ADDRESS_MAP(glDisableVertexAttribArray)
-    PROC_ADDRESS_MAP(glMapBufferRange)
-    PROC_ADDRESS_MAP(glUnmapBuffer)
-    PROC_ADDRESS_MAP(glBufferStorage)
-    PROC_ADDRESS_MAP(glFlushMappedBufferRange)
-    PROC_ADDRESS_MAP(glBufferSubData)
-    PROC_ADDRESS_MAP(glGetIntegerv)
-#undef PROC_ADDRESS_MAP
     return real_eglGetProcAddress(name);
 }
 
+// blocks until the worker has finished the given frame, or returns immediately if it already has
+void _bolt_wait_for_frame(struct BoltWorker* worker, uint32_t frame) {
+    atomic_fetch_add(&worker->frame_waiters, 1);
+    while (1) {
+        const uint32_t completed = atomic_load(&worker->frames_completed);
+        if ((int32_t)(completed - frame) >= 0) break;
+        _bolt_futex_wait(&worker->frames_completed, completed);
+    }
+    atomic_fetch_sub(&worker->frame_waiters, 1);
+}
+
 unsigned int eglSwapBuffers(void* display, void* surface) {
-    struct BoltSyncData data;
-    data.done = 0;
-    pthread_mutex_init(&data.mutex, NULL);
-    pthread_cond_init(&data.cond, NULL);
-    SEND_MSG({.context = _bolt_context(), .instruction = Message_eglSwapBuffers, .data = &data})
-    pthread_mutex_lock(&data.mutex);
-    while (!data.done) pthread_cond_wait(&data.cond, &data.mutex);
-    pthread_mutex_unlock(&data.mutex);
-    pthread_mutex_destroy(&data.mutex);
-    pthread_cond_destroy(&data.cond);
+    atomic_fetch_add(&total_frames, 1);
+    const uint64_t written = atomic_exchange_explicit(&upload_this_frame.written, 0, memory_order_relaxed);
+    const uint64_t uploaded = atomic_exchange_explicit(&upload_this_frame.uploaded, 0, memory_order_relaxed);
+    atomic_store_explicit(&upload_last_frame.written, written, memory_order_relaxed);
+    atomic_store_explicit(&upload_last_frame.uploaded, uploaded, memory_order_relaxed);
+    atomic_fetch_add_explicit(&upload_total.written, written, memory_order_relaxed);
+    atomic_fetch_add_explicit(&upload_total.uploaded, uploaded, memory_order_relaxed);
+    struct GLContext* c = _bolt_context();
+    struct BoltWorker* worker = c ? _bolt_acquire_worker(c->share_group) : NULL;
+    if (worker) {
+        const uint32_t frame = atomic_fetch_add(&worker->frames_submitted, 1) + 1;
+        const struct BoltMessage frame_end = {.context = c, .instruction = Message_FrameEnd, .index = frame};
+        const struct BoltMessage swap = {.context = c, .instruction = Message_eglSwapBuffers, .index = frame};
+        _bolt_queue_push(&worker->queue, &frame_end);
+        _bolt_queue_push(&worker->queue, &swap);
+        _bolt_wait_for_frame(worker, frame - max_frame_lag);
+        _bolt_release_worker(c->share_group);
+    }
+    _bolt_staging_next_frame();
     return real_eglSwapBuffers(display, surface);
 }
 
+// starts a worker for a new share group. egl_lock must be held.
+static void _bolt_start_worker(struct GLContext* c, void* display, void* config, const void* attrib_list) {
+    struct BoltWorker* worker = calloc(1, sizeof(*worker));
+    if (!worker) {
+        printf("warning: failed to allocate worker\n");
+        return;
+    }
+    if (_bolt_queue_init(&worker->queue, sizeof(struct BoltMessage), WORKER_QUEUE_CAPACITY)) {
+        printf("warning: failed to allocate worker queue\n");
+        free(worker);
+        return;
+    }
+    worker->display = display;
+    worker->context = real_eglCreateContext(display, config, (void*)c->id, attrib_list);
+    worker->group = c->share_group;
+    int err = pthread_create(&worker->thread, NULL, _bolt_worker_thread, worker);
+    if (err) {
+        printf("warning: pthread_create returned error %i\n", err);
+        if (worker->context) real_eglDestroyContext(display, worker->context);
+        _bolt_queue_destroy(&worker->queue);
+        free(worker);
+        return;
+    }
+    worker->running = 1;
+    _bolt_share_group_ref(worker->group);
+    atomic_store(&worker->group->worker, worker);
+    worker->group->sprites = &worker->sprites;
+    worker->next = workers;
+    workers = worker;
+}
+
+// see print_texture_stats. must only be called once the group's worker has stopped, since textures belong to it.
+static void _bolt_print_texture_stats(const struct GLShareGroup* group) {
+    const struct GLTexture2D* textures = group->textures.data;
+    const struct GLTexture2D* largest[TEXTURE_STATS_LARGEST] = {0};
+    for (size_t i = 0; i < group->textures.count; i += 1) {
+        const struct GLTexture2D* tex = &textures[i];
+        const size_t bytes = _bolt_texture_resident_bytes(tex);
+        if (!bytes) continue;
+        size_t j = TEXTURE_STATS_LARGEST;
+        while (j > 0 && (!largest[j - 1] || _bolt_texture_resident_bytes(largest[j - 1]) < bytes)) j -= 1;
+        if (j == TEXTURE_STATS_LARGEST) continue;
+        memmove(&largest[j + 1], &largest[j], (TEXTURE_STATS_LARGEST - j - 1) * sizeof(*largest));
+        largest[j] = tex;
+    }
+    printf("texture shadows: %lu bytes in %lu textures\n", (unsigned long)_bolt_share_group_texture_bytes(group), (unsigned long)group->textures.count);
+    for (size_t i = 0; i < TEXTURE_STATS_LARGEST && largest[i]; i += 1) {
+        printf("  texture %u (%ux%u): %lu bytes, %lu of them journalled\n", largest[i]->id, largest[i]->width, largest[i]->height,
+               (unsigned long)_bolt_texture_resident_bytes(largest[i]), (unsigned long)largest[i]->journal_bytes);
+    }
+}
+
+// stops a worker after it's handled everything already sent to it, and lets go of its share group. egl_lock must be held.
+static void _bolt_stop_worker(struct BoltWorker* worker) {
+    struct GLShareGroup* group = worker->group;
+    // see _bolt_acquire_worker. anything still using the worker is at most waiting for it to handle something, which
+    // it carries on doing until it gets the quit message.
+    atomic_store(&group->worker, NULL);
+    while (atomic_load(&group->worker_users)) sched_yield();
+    struct BoltMessage quit = {.instruction = Message_Quit};
+    _bolt_queue_push(&worker->queue, &quit);
+    pthread_join(worker->thread, NULL);
+    worker->running = 0;
+    if (print_texture_stats) _bolt_print_texture_stats(group);
+    for (struct BoltWorker** w = &workers; *w; w = &(*w)->next) {
+        if (*w == worker) {
+            *w = worker->next;
+            break;
+        }
+    }
+    group->sprites = NULL;
+    if (!group->context_count) {
+        // nothing else can touch the group's buffers any more, and the shadows have to go back to the pool
+        struct GLArrayBuffer* buffers = group->buffers.data;
+        for (size_t i = 0; i < group->buffers.count; i += 1) {
+            _bolt_pool_free(buffers[i].data, buffers[i].capacity);
+            _bolt_pool_free(buffers[i].spare, buffers[i].spare_capacity);
+            buffers[i].data = NULL;
+            buffers[i].spare = NULL;
+        }
+    }
+    _bolt_share_group_unref(group);
+    _bolt_queue_destroy(&worker->queue);
+    _bolt_render_list_free(&worker->capture);
+    _bolt_render_list_free(&worker->captured);
+    _bolt_render_delta_free(&worker->delta);
+    _bolt_sprite_index_free(&worker->sprites);
+    _bolt_text_engine_free(&worker->text);
+    free(worker);
+}
+
+// called with a share group that just lost its last context, see _bolt_destroy_context. egl_lock must be held.
+static void _bolt_release_share_group(struct GLShareGroup* group) {
+    if (group && group->worker) _bolt_stop_worker(group->worker);
+}
+
+static void _bolt_send_message(const struct BoltMessage* message) {
+    struct GLContext* c = message->context ? message->context : _bolt_context();
+    struct BoltWorker* worker = c ? _bolt_acquire_worker(c->share_group) : NULL;
+    if (worker) {
+        _bolt_queue_push(&worker->queue, message);
+        _bolt_release_worker(c->share_group);
+        return;
+    }
+    // nothing is going to handle this, so anything it was handing over to the worker has to be freed here instead
+    switch (message->instruction) {
+        case Message_glBufferData:
+        case Message_glBufferStorage:
+            _bolt_pool_free(message->data, message->w);
+            break;
+        case Message_glDeleteBuffers: {
+            const struct GLBufferBlock* blocks = message->data;
+            for (size_t i = 0; i < message->w; i += 1) _bolt_pool_free(blocks[i].data, blocks[i].capacity);
+            break;
+        }
+        default:
+            break;
+    }
+    if (message->do_free_data) _bolt_staging_free(message->data);
+}
+
 unsigned int eglMakeCurrent(void* display, void* draw, void* read, void* context) {
     unsigned int ret = real_eglMakeCurrent(display, draw, read, context);
     if (ret) {
-        pthread_mutex_lock(&egl_lock);
-        _bolt_make_context_current(context);
-        pthread_mutex_unlock(&egl_lock);
+        // only needs the lock if the context that was current has been destroyed in the meantime
+        struct GLContext* destroyed = _bolt_make_context_current(context);
+        if (destroyed) {
+            pthread_mutex_lock(&egl_lock);
+            _bolt_release_share_group(_bolt_free_context(destroyed));
+            pthread_mutex_unlock(&egl_lock);
+        }
     }
     return ret;
 }
@@ -669,7 +1406,7 @@ unsigned int eglDestroyContext(void* display, void* context) {
     unsigned int ret = real_eglDestroyContext(display, context);
     if (ret) {
         pthread_mutex_lock(&egl_lock);
-        _bolt_destroy_context(context);
+        _bolt_release_share_group(_bolt_destroy_context(context));
         pthread_mutex_unlock(&egl_lock);
     }
     return ret;
@@ -679,16 +1416,12 @@ unsigned int eglInitialize(void* display, void* major, void* minor) {
     INIT();
     unsigned int ret = real_eglInitialize(display, major, minor);
     pthread_mutex_lock(&egl_lock);
-    if (ret && !worker_thread_running) {
-        int socks[2];
-        socketpair(AF_UNIX, SOCK_STREAM, 0, socks);
-        read_socket = socks[1];
-        int err = pthread_create(&worker_thread, NULL, _bolt_worker_thread, NULL);
-        if (err) {
-            printf("warning: pthread_create returned error %i\n", err);
+    if (ret && !staging_initialised) {
+        const unsigned int arena_count = max_frame_lag < 1 ? 2 : max_frame_lag + 1;
+        if (_bolt_staging_init(arena_count, staging_arena_bytes)) {
+            printf("warning: failed to allocate staging arenas, falling back to malloc\n");
         }
-        write_socket = socks[0];
-        worker_thread_running = 1;
+        staging_initialised = 1;
     }
     pthread_mutex_unlock(&egl_lock);
     return ret;
@@ -696,25 +1429,43 @@ unsigned int eglInitialize(void* display, void* major, void* minor) {
 
 void* eglCreateContext(void* display, void* config, void* share_context, const void* attrib_list) {
     void* ret = real_eglCreateContext(display, config, share_context, attrib_list);
+    if (!ret) return ret;
     pthread_mutex_lock(&egl_lock);
-    _bolt_create_context(ret, share_context);
-    if (!worker_context_exists && share_context) {
-        void* worker_context = real_eglCreateContext(display, config, share_context, attrib_list);
-        SEND_MSG({.context = worker_context, .data = display, .instruction = Message_Context})
-        worker_context_exists = 1;
-    }
+    struct GLContext* c = _bolt_create_context(ret, share_context);
+    if (c && !c->share_group->worker && c->share_group->context_count == 1) _bolt_start_worker(c, display, config, attrib_list);
     pthread_mutex_unlock(&egl_lock);
     return ret;
 }
 
 unsigned int eglTerminate(void* display) {
     pthread_mutex_lock(&egl_lock);
-    if (worker_thread_running) {
-        SEND_MSG({ .instruction = Message_Quit });
-        pthread_join(worker_thread, NULL);
-        close(write_socket);
-        worker_thread_running = 0;
-        worker_context_exists = 0;
+    // terminating a display destroys all its contexts, so their workers have to go too
+    struct BoltWorker* worker = workers;
+    while (worker) {
+        struct BoltWorker* next = worker->next;
+        if (worker->display == display) _bolt_stop_worker(worker);
+        worker = next;
+    }
+    if (!workers && staging_initialised) {
+        _bolt_staging_destroy();
+        staging_initialised = 0;
+    }
+    if (print_pool_stats) {
+        struct BoltPoolStats stats;
+        _bolt_pool_stats(&stats);
+        printf("buffer pool: %lu allocations (%lu reused), %lu frees, %lu system allocations, %lu system frees, %lu huge-page blocks, %lu bytes in use, %lu bytes cached\n",
+               (unsigned long)stats.allocations, (unsigned long)stats.cache_hits, (unsigned long)stats.frees, (unsigned long)stats.system_allocations,
+               (unsigned long)stats.system_frees, (unsigned long)stats.huge_page_blocks, (unsigned long)stats.bytes_in_use, (unsigned long)stats.bytes_cached);
+    }
+    const uint64_t dropped = atomic_exchange(&backlog_dropped, 0);
+    if (dropped) printf("warning: the worker's backlog was full, so %lu draw snapshots were dropped\n", (unsigned long)dropped);
+    if (print_upload_stats) {
+        const uint32_t frames = atomic_load(&total_frames);
+        const uint64_t written = atomic_load(&upload_total.written);
+        const uint64_t uploaded = atomic_load(&upload_total.uploaded);
+        printf("buffer uploads: %lu bytes written, %lu bytes uploaded over %u frames (%lu/%lu per frame, last frame %lu/%lu)\n",
+               (unsigned long)written, (unsigned long)uploaded, frames, (unsigned long)(frames ? written / frames : 0), (unsigned long)(frames ? uploaded / frames : 0),
+               (unsigned long)atomic_load(&upload_last_frame.written), (unsigned long)atomic_load(&upload_last_frame.uploaded));
     }
     pthread_mutex_unlock(&egl_lock);
     return real_eglTerminate(display);
@@ -734,39 +1485,11 @@ void* xcb_wait_for_event(void* c) {
     return real_xcb_wait_for_event(c);
 }
 
-void* dlopen(const char*, int);
-void* dlsym(void*, const char*);
-void* dlvsym(void*, const char*, const char*);
-int dlclose(void*);
-
 void* _bolt_dl_lookup(void* handle, const char* symbol) {
-    if (!handle) return NULL;
-    if (handle == libc_addr) {
-        if (strcmp(symbol, "dlopen") == 0) return dlopen;
-        if (strcmp(symbol, "dlsym") == 0) return dlsym;
-        if (strcmp(symbol, "dlvsym") == 0) return dlvsym;
-        if (strcmp(symbol, "dlclose") == 0) return dlclose;
-    } else if (handle == libegl_addr) {
-        if (strcmp(symbol, "eglGetProcAddress") == 0) return eglGetProcAddress;
-        if (strcmp(symbol, "eglSwapBuffers") == 0) return eglSwapBuffers;
-        if (strcmp(symbol, "eglMakeCurrent") == 0) return eglMakeCurrent;
-        if (strcmp(symbol, "eglDestroyContext") == 0) return eglDestroyContext;
-        if (strcmp(symbol, "eglInitialize") == 0) return eglInitialize;
-        if (strcmp(symbol, "eglCreateContext") == 0) return eglCreateContext;
-        if (strcmp(symbol, "eglTerminate") == 0) return eglTerminate;
-    } else if (handle == libgl_addr) {
-        if (strcmp(symbol, "glDrawElements") == 0) return glDrawElements;
-        if (strcmp(symbol, "glDrawArrays") == 0) return glDrawArrays;
-        if (strcmp(symbol, "glBindTexture") == 0) return glBindTexture;
-        if (strcmp(symbol, "glTexSubImage2D") == 0) return glTexSubImage2D;
-        if (strcmp(symbol, "glDeleteTextures") == 0) return glDeleteTextures;
-        if (strcmp(symbol, "glGetError") == 0) return glGetError;
-        if (strcmp(symbol, "glFlush") == 0) return glFlush;
-    } else if (handle == libxcb_addr) {
-        if (strcmp(symbol, "xcb_poll_for_event") == 0) return xcb_poll_for_event;
-        if (strcmp(symbol, "xcb_wait_for_event") == 0) return xcb_wait_for_event;
-    }
-    return NULL;
+    // most dlsym calls in the process have nothing to do with us, so rule those out before hashing anything
+    if (!handle || (handle != libc_addr && handle != libegl_addr && handle != libgl_addr && handle != libxcb_addr)) return NULL;
+    const struct BoltHook* hook = _bolt_find_hook(symbol);
+    return (hook && (hook->flags & HOOK_EXPORT) && *hook->module == handle) ? hook->hook : NULL;
 }
 
 void* dlopen(const char* filename, int flags) {
@@ -777,30 +1500,17 @@ void* dlopen(const char* filename, int flags) {
         if (!libegl_addr && !strcmp(filename, libegl_name)) {
             libegl_addr = ret;
             if (!libegl_addr) return NULL;
-            real_eglGetProcAddress = real_dlsym(ret, "eglGetProcAddress");
-            real_eglSwapBuffers = real_dlsym(ret, "eglSwapBuffers");
-            real_eglMakeCurrent = real_dlsym(ret, "eglMakeCurrent");
-            real_eglDestroyContext = real_dlsym(ret, "eglDestroyContext");
-            real_eglInitialize = real_dlsym(ret, "eglInitialize");
-            real_eglCreateContext = real_dlsym(ret, "eglCreateContext");
-            real_eglTerminate = real_dlsym(ret, "eglTerminate");
+            _bolt_dlsym_module(&libegl_addr);
         }
         if (!libgl_addr && !strcmp(filename, libgl_name)) {
             libgl_addr = ret;
             if (!libgl_addr) return NULL;
-            real_glDrawElements = real_dlsym(ret, "glDrawElements");
-            real_glDrawArrays = real_dlsym(ret, "glDrawArrays");
-            real_glBindTexture = real_dlsym(ret, "glBindTexture");
-            real_glTexSubImage2D = real_dlsym(ret, "glTexSubImage2D");
-            real_glDeleteTextures = real_dlsym(ret, "glDeleteTextures");
-            real_glGetError = real_dlsym(ret, "glGetError");
-            real_glFlush = real_dlsym(ret, "glFlush");
+            _bolt_dlsym_module(&libgl_addr);
         }
         if (!libxcb_addr && !strcmp(filename, libxcb_name)) {
             libxcb_addr = ret;
             if (!libxcb_addr) return NULL;
-            real_xcb_poll_for_event = real_dlsym(ret, "xcb_poll_for_event");
-            real_xcb_wait_for_event = real_dlsym(ret, "xcb_wait_for_event");
+            _bolt_dlsym_module(&libxcb_addr);
         }
     }
     return ret;
@@ -824,320 +1534,243 @@ int dlclose(void* handle) {
     return real_dlclose(handle);
 }
 
-// dedicated thread for handling most tasks in a synchronous order, invoked by eglInitialize
-void* _bolt_worker_thread(void* arg) {
-    void* display = NULL;
-    void* context = NULL;
-    struct BoltMessage message;
-    while (1) {
-        if (read(read_socket, &message, sizeof(message)) != sizeof(message)) continue;
-        struct GLContext* c = message.context;
-        switch (message.instruction) {
-            case Message_Quit: {
-                close(read_socket);
-                if (display) real_eglDestroyContext(display, context);
-                return NULL;
-            }
-            case Message_Context: {
-                display = message.data;
-                context = c;
-                uint32_t b = real_eglMakeCurrent(display, NULL, NULL, context);
-                break;
-            }
-            case Message_glCreateProgram: {
-                struct GLProgram* program = _bolt_get_program(c->shared_programs, message.asset);
-                program->loc_aVertexPosition2D = -1;
-                program->loc_aVertexColour = -1;
-                program->loc_aTextureUV = -1;
-                program->loc_aTextureUVAtlasMin = -1;
-                program->loc_aTextureUVAtlasExtents = -1;
-                program->loc_uProjectionMatrix = -1;
-                program->loc_uDiffuseMap = -1;
-                program->is_important = 0;
-                break;
-            }
-            case Message_glBindAttribLocation: {
-                struct GLProgram* p = _bolt_find_program(c->shared_programs, message.asset);
-                const char* name = (const char*)message.data;
-                if (p) {
-                    if (!strcmp(name, "aVertexPosition2D")) p->loc_aVertexPosition2D = message.index;
-                    if (!strcmp(name, "aVertexColour")) p->loc_aVertexColour = message.index;
-                    if (!strcmp(name, "aTextureUV")) p->loc_aTextureUV = message.index;
-                    if (!strcmp(name, "aTextureUVAtlasMin")) p->loc_aTextureUVAtlasMin = message.index;
-                    if (!strcmp(name, "aTextureUVAtlasExtents")) p->loc_aTextureUVAtlasExtents = message.index;
-                }
-                if (message.do_free_data) free(message.data);
-                break;
-            }
-            case Message_glLinkProgram: {
-                struct GLProgram* p = _bolt_find_program(c->shared_programs, message.asset);
-                if (p && p->loc_aVertexPosition2D != -1 && p->loc_aVertexColour != -1 && p->loc_aTextureUV != -1 && p->loc_aTextureUVAtlasMin != -1 && p->loc_aTextureUVAtlasExtents != -1) {
-                    // yeah, this is lazy
-                    int uDiffuseMap = (int)message.x;
-                    int uProjectionMatrix = (int)message.y;
-                    if (uDiffuseMap != -1 && uProjectionMatrix != -1) {
-                        p->loc_uDiffuseMap = uDiffuseMap;
-                        p->loc_uProjectionMatrix = uProjectionMatrix;
-                        p->is_important = 1;
-                    }
-                }
-                break;
+struct BoltBacklog {
+    struct BoltMessage* messages;
+    size_t head;
+    size_t count;
+    size_t capacity;
+};
+
+static uint8_t _bolt_message_is_bulk(enum BoltMessageType instruction) {
+    switch (instruction) {
+        case Message_glTexStorage2D:
+        case Message_glTexSubImage2D:
+        case Message_glCompressedTexSubImage2D:
+        case Message_glCopyImageSubData:
+        case Message_glDeleteTextures:
+        case Message_glDrawElements:
+        case Message_FrameEnd:
+        case Message_TextureWritten:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// returns 0 if the backlog couldn't grow, in which case the message should just be handled straight away
+static uint8_t _bolt_backlog_push(struct BoltBacklog* backlog, const struct BoltMessage* message) {
+    if (backlog->count == backlog->capacity) {
+        const size_t capacity = backlog->capacity ? backlog->capacity * 2 : 256;
+        struct BoltMessage* messages = realloc(backlog->messages, capacity * sizeof(*messages));
+        if (!messages) return 0;
+        // unwrap the ring into the new space, so that it's contiguous from head again
+        const size_t wrapped = (backlog->head + backlog->count > backlog->capacity) ? backlog->head + backlog->count - backlog->capacity : 0;
+        memcpy(messages + backlog->capacity, messages, wrapped * sizeof(*messages));
+        backlog->messages = messages;
+        backlog->capacity = capacity;
+    }
+    backlog->messages[(backlog->head + backlog->count) % backlog->capacity] = *message;
+    backlog->count += 1;
+    return 1;
+}
+
+static void _bolt_backlog_pop(struct BoltBacklog* backlog, struct BoltMessage* message) {
+    *message = backlog->messages[backlog->head];
+    backlog->head = (backlog->head + 1) % backlog->capacity;
+    backlog->count -= 1;
+}
+
+// finds a texture shadow that's still current, i.e. made while the textures set was on, which it still is. one that
+// isn't might not match the real texture any more, so it's dropped.
+static struct GLTexture2D* _bolt_current_texture(struct GLShareGroup* group, unsigned int id) {
+    struct GLTexture2D* tex = _bolt_find_texture(&group->textures, id);
+    const uint32_t generation = atomic_load(&hook_set_generation[HOOK_SET_TEXTURES]);
+    if (!tex || ((generation & 1) && tex->generation == generation)) return tex;
+    _bolt_share_group_destroy_textures(group, 1, &id);
+    return NULL;
+}
+
+static void _bolt_handle_message(struct BoltWorker* worker, struct BoltMessage message) {
+    // the sending context may have been destroyed since, but the worker's own reference keeps the group alive
+    struct GLShareGroup* group = worker->group;
+    switch (message.instruction) {
+        case Message_Quit:
+            // handled by the worker loop
+            break;
+        case Message_glTexStorage2D: {
+            struct GLTexture2D* tex = _bolt_get_texture(&group->textures, message.asset);
+            if (tex) {
+                _bolt_sprite_index_clear(&worker->sprites, message.asset);
+                _bolt_texture_storage(tex, message.format, message.w, message.h);
+                tex->generation = message.index;
             }
-            case Message_glUseProgram: {
-                if (message.asset != c->bound_program_id) {
-                    c->bound_program_id = message.asset;
-                    const struct GLProgram* p = _bolt_find_program(c->shared_programs, message.asset);
-                    c->current_program_is_important = (p && p->is_important);
-                }
-                break;
+            break;
+        }
+        case Message_glBufferData:
+        case Message_glBufferStorage: {
+            // the shadow has already been replaced on the game thread, this is the old one coming back. nothing
+            // queued after this refers to it, so it can be given back to the buffer for reuse, or to the pool.
+            pthread_mutex_lock(&group->buffers_lock);
+            struct GLArrayBuffer* buffer = _bolt_find_buffer(&group->buffers, message.asset);
+            if (buffer && !buffer->spare) {
+                buffer->spare = message.data;
+                buffer->spare_capacity = message.w;
+                message.data = NULL;
             }
-            case Message_glTexStorage2D: {
-                struct GLTexture2D* tex = _bolt_get_texture(c->shared_textures, c->bound_texture_id);
+            pthread_mutex_unlock(&group->buffers_lock);
+            _bolt_pool_free(message.data, message.w);
+            break;
+        }
+        case Message_glDeleteBuffers: {
+            const struct GLBufferBlock* blocks = message.data;
+            for (size_t i = 0; i < message.w; i += 1) _bolt_pool_free(blocks[i].data, blocks[i].capacity);
+            if (message.do_free_data) _bolt_staging_free(message.data);
+            break;
+        }
+        case Message_glCompressedTexSubImage2D: {
+            // only journalled here, decoding happens when something actually reads the texture
+            if (_bolt_dxt_block_size(message.format)) {
+                struct GLTexture2D* tex = _bolt_current_texture(group, message.asset);
                 if (tex) {
-                    free(tex->data);
-                    tex->data = malloc(message.w * message.h * 4);
-                    tex->width = message.w;
-                    tex->height = message.h;
+                    _bolt_texture_upload(tex, message.format, message.x, message.y, message.w, message.h, message.data, 0);
+                    _bolt_sprite_index_upload(&worker->sprites, tex, message.format, message.x, message.y, message.w, message.h, message.data, 0);
                 }
-                break;
             }
-            case Message_glVertexAttribPointer: {
-                _bolt_set_attr_binding(&c->attributes[message.index], message.asset, message.w, message.data, message.stride, message.type, message.bool_value);
-                break;
-            }
-            case Message_glBufferData:
-            case Message_glBufferStorage: {
-                struct GLArrayBuffer* buffer = _bolt_get_buffer(c->shared_buffers, message.asset);
-                if (buffer) {
-                    free(buffer->data);
-                    buffer->data = message.data;
-                } else if (message.do_free_data) {
-                    free(message.data);
-                }
-                break;
-            }
-            case Message_glDeleteBuffers: {
-                _bolt_context_destroy_buffers(c, message.w, message.data);
-                if (message.do_free_data) free(message.data);
-                break;
-            }
-            case Message_glBindFramebuffer: {
-                switch (message.target) {
-                    case 36008:
-                        c->current_read_framebuffer = message.asset;
-                        break;
-                    case 36009:
-                        c->current_draw_framebuffer = message.asset;
-                        break;
-                    case 36160:
-                        c->current_read_framebuffer = message.asset;
-                        c->current_draw_framebuffer = message.asset;
-                        break;
-                }
-                break;
-            }
-            case Message_glCompressedTexSubImage2D: {
-                // weird lossy-compression formats with RGB-565 and way too much space dedicated to alpha channels
-                // https://www.khronos.org/opengl/wiki/S3_Texture_Compression
-                if (message.format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT || message.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT || message.format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT) {
-                    struct GLTexture2D* tex = _bolt_find_texture(c->shared_textures, c->bound_texture_id);
-                    if (tex) {
-                        int out_xoffset = message.x;
-                        int out_yoffset = message.y;
-                        for (size_t ii = 0; ii < (message.w * message.h); ii += 16) {
-                            const uint8_t* ptr = message.data + ii;
-                            uint8_t* out_ptr = tex->data + (out_yoffset * tex->width * 4) + (out_xoffset * 4);
-                            uint16_t c0 = *(ptr + 8) + (*(ptr + 9) << 8);
-                            uint16_t c1 = *(ptr + 10) + (*(ptr + 11) << 8);
-                            uint8_t c0_rgb[3];
-                            uint8_t c1_rgb[3];
-                            _bolt_unpack_rgb565(c0, c0_rgb);
-                            _bolt_unpack_rgb565(c1, c1_rgb);
-                            const uint8_t c0_greater = c0 > c1;
-                            const uint32_t ctable = *(ptr + 12) + (*(ptr + 13) << 8) + (*(ptr + 14) << 16) + (*(ptr + 15) << 24);
-                            
-                            for (size_t j = 0; j < 4; j += 1) {
-                                for (size_t i = 0; i < 4; i += 1) {
-                                    if (out_xoffset + i >= 0 && out_yoffset + j >= 0 && out_xoffset + i < tex->width && out_yoffset + j < tex->height) {
-                                        uint8_t* pixel_ptr = out_ptr + (tex->width * i * 4) + (j * 4);
-                                        const uint32_t code = (ctable >> (2 * (4 * i + j))) & 3;
-                                        switch(code) {
-                                            case 0:
-                                                memcpy(pixel_ptr, c0_rgb, 3);
-                                                break;
-                                            case 1:
-                                                memcpy(pixel_ptr, c1_rgb, 3);
-                                                break;
-                                            case 2:
-                                                if (c0_greater) {
-                                                    pixel_ptr[0] = (2*c0_rgb[0]+c1_rgb[0])/3;
-                                                    pixel_ptr[1] = (2*c0_rgb[1]+c1_rgb[1])/3;
-                                                    pixel_ptr[2] = (2*c0_rgb[2]+c1_rgb[2])/3;
-                                                } else {
-                                                    pixel_ptr[0] = (c0_rgb[0]+c1_rgb[0])/2;
-                                                    pixel_ptr[1] = (c0_rgb[1]+c1_rgb[1])/2;
-                                                    pixel_ptr[2] = (c0_rgb[2]+c1_rgb[2])/2;
-                                                }
-                                                break;
-                                            case 3:
-                                                if (c0_greater) {
-                                                    pixel_ptr[0] = (2*c1_rgb[0]+c0_rgb[0])/3;
-                                                    pixel_ptr[1] = (2*c1_rgb[1]+c0_rgb[1])/3;
-                                                    pixel_ptr[2] = (2*c1_rgb[2]+c0_rgb[2])/3;
-                                                } else {
-                                                    memset(pixel_ptr, 0, 3);
-                                                }
-                                                break;
-                                        }
-                                    }
-                                }
-                            }
-                    
-                            out_xoffset += 4;
-                            if (out_xoffset >= message.x + message.w) {
-                                out_xoffset = message.x;
-                                out_yoffset += 4;
-                            }
-                        }
-                    }
-                }
-                if (message.do_free_data) free(message.data);
-                break;
+            if (message.do_free_data) _bolt_staging_free(message.data);
+            break;
+        }
+        case Message_glCopyImageSubData: {
+            struct GLTexture2D* src = _bolt_current_texture(group, message.index);
+            struct GLTexture2D* dst = _bolt_current_texture(group, message.asset);
+            if (src && dst && _bolt_texture_copy(dst, message.x, message.y, src, message.src_x, message.src_y, message.w, message.h)) {
+                _bolt_sprite_index_copy(&worker->sprites, dst, message.x, message.y, src, message.src_x, message.src_y, message.w, message.h);
             }
-            case Message_glCopyImageSubData: {
-                // {srcName, srcX, srcY, dstName, dstX, dstY, srcWidth, srcHeight}
-                int tail[8];
-                read(read_socket, tail, 8 * sizeof(int));
-                struct GLTexture2D* src = _bolt_find_texture(c->shared_textures, tail[0]);
-                struct GLTexture2D* dst = _bolt_find_texture(c->shared_textures, tail[3]);
-                if (!src || !dst) break;
-                for (size_t i = 0; i < tail[7]; i += 1) {
-                    memcpy(dst->data + (tail[5] * dst->width * 4) + (tail[4] * 4), src->data + (tail[2] * src->width * 4) + (tail[1] * 4), tail[6] * 4);
+            break;
+        }
+        case Message_BufferUploads: {
+            // the data pointers are into the shadows as they were at the sync point, which are still valid even if
+            // a buffer has been respecified or deleted since then - the old shadow doesn't get freed until after
+            // this. GL_ARRAY_BUFFER is used for every buffer since element buffer bindings belong to the VAO.
+            const struct GLBufferUpload* uploads = message.data;
+            unsigned int bound = 0;
+            for (size_t i = 0; i < message.w; i += 1) {
+                if (uploads[i].buffer != bound) {
+                    bound = uploads[i].buffer;
+                    real_glBindBuffer(GL_ARRAY_BUFFER, bound);
                 }
-                break;
-            }
-            case Message_glEnableVertexAttribArray: {
-                c->attributes[message.index].enabled = 1;
-                break;
-            }
-            case Message_glDisableVertexAttribArray: {
-                c->attributes[message.index].enabled = 0;
-                break;
-            }
-            case Message_glMapBufferRange: {
-                struct GLArrayBuffer* buffer = _bolt_find_buffer(c->shared_buffers, message.asset);
-                buffer->mapped = 1;
-                buffer->mapping_offset = message.x;
-                buffer->mapping_len = message.w;
-                buffer->mapping_access_type = message.format;
-                struct BoltSyncData* data = message.data;
-                pthread_mutex_lock(&data->mutex);
-                data->ptr = buffer->data + message.x;
-                data->done = 1;
-                pthread_cond_signal(&data->cond);
-                pthread_mutex_unlock(&data->mutex);
-                break;
+                real_glBufferSubData(GL_ARRAY_BUFFER, uploads[i].offset, uploads[i].length, uploads[i].data);
             }
-            case Message_glUnmapBuffer: {
-                struct GLArrayBuffer* buffer = _bolt_find_buffer(c->shared_buffers, message.asset);
-                if (!(buffer->mapping_access_type & GL_MAP_FLUSH_EXPLICIT_BIT)) {
-                    real_glBindBuffer(message.target, message.asset);
-                    real_glBufferSubData(message.target, buffer->mapping_offset, buffer->mapping_len, buffer->data + buffer->mapping_offset);
+            if (message.do_free_data) _bolt_staging_free(message.data);
+            break;
+        }
+        case Message_glDrawElements: {
+            _bolt_capture_draw(&worker->capture, message.data, capture_budget_ns);
+            if (message.do_free_data) _bolt_staging_free(message.data);
+            break;
+        }
+        case Message_glTexSubImage2D: {
+            if (message.target == GL_TEXTURE_2D) {
+                struct GLTexture2D* tex = _bolt_current_texture(group, message.asset);
+                if (tex) {
+                    _bolt_texture_upload(tex, message.format, message.x, message.y, message.w, message.h, message.data, message.stride);
+                    _bolt_sprite_index_upload(&worker->sprites, tex, message.format, message.x, message.y, message.w, message.h, message.data, message.stride);
                 }
-                buffer->mapped = 0;
-                break;
-            }
-            case Message_glFlushMappedBufferRange: {
-                struct GLArrayBuffer* buffer = _bolt_find_buffer(c->shared_buffers, message.asset);
-                real_glBindBuffer(message.target, message.asset);
-                real_glBufferSubData(message.target, buffer->mapping_offset + message.x, message.w, buffer->data + buffer->mapping_offset + message.x);
-                break;
             }
-            case Message_glDrawElements: {
-                //if (c->current_program_is_important && c->current_draw_framebuffer == 0 && message.w > 0) {
-                //    struct GLArrayBuffer* element_buffer = _bolt_find_buffer(c->shared_buffers, message.asset);
-                //    if (!element_buffer || !element_buffer->data) break;
-                //    const unsigned short* indices = element_buffer->data + (uintptr_t)message.data;
-                //    struct GLProgram* current_program = _bolt_find_program(c->shared_programs, c->bound_program_id);
-                //    const struct GLAttrBinding* atlas_min = &c->attributes[current_program->loc_aTextureUVAtlasMin];
-                //    const struct GLAttrBinding* atlas_max = &c->attributes[current_program->loc_aTextureUVAtlasExtents];
-                //    const struct GLAttrBinding* tex_uv = &c->attributes[current_program->loc_aTextureUV];
-                //    int diffuse_map;
-                //    real_glGetUniformiv(c->bound_program_id, current_program->loc_uDiffuseMap, &diffuse_map);
-                //    if (atlas_min->enabled && atlas_max->enabled && tex_uv->enabled) {
-                //        //printf("(worker thread) glDrawElements ebo=%u diffuse_map=%i (%u) atlas_min normalised=%u\n", message.asset, diffuse_map, current_program->loc_uDiffuseMap, (unsigned int)atlas_min->normalise);
-                //        for (size_t i = 0; i + 2 < message.w; i += 3) {
-                //            unsigned short index1 = indices[i];
-                //            unsigned short index2 = indices[i + 1];
-                //            unsigned short index3 = indices[i + 2];
-                //            float min1[2];
-                //            float min2[2];
-                //            float min3[2];
-                //            float max1[2];
-                //            float max2[2];
-                //            float max3[2];
-                //            float uv1[2];
-                //            float uv2[2];
-                //            float uv3[2];
-                //            _bolt_get_attr_binding(c, atlas_min, index1, 2, min1);
-                //            _bolt_get_attr_binding(c, atlas_min, index2, 2, min2);
-                //            _bolt_get_attr_binding(c, atlas_min, index3, 2, min3);
-                //            _bolt_get_attr_binding(c, atlas_max, index1, 2, max1);
-                //            _bolt_get_attr_binding(c, atlas_max, index2, 2, max2);
-                //            _bolt_get_attr_binding(c, atlas_max, index3, 2, max3);
-                //            _bolt_get_attr_binding(c, tex_uv, index1, 2, uv1);
-                //            _bolt_get_attr_binding(c, tex_uv, index2, 2, uv2);
-                //            _bolt_get_attr_binding(c, tex_uv, index3, 2, uv3);
-                //            //printf("drawing triangle, uDiffuseMap=%i, atlas extents %f,%f,%f,%f | %f,%f,%f,%f | %f,%f,%f,%f UV %f,%f %f,%f %f,%f\n",
-                //            //    diffuse_map, min1[0], min1[1], max1[0], max1[1], min2[0], min2[1], max2[0], max2[1], min3[0], min3[1], max3[0], max3[1],
-                //            //    uv1[0], uv1[1], uv2[0], uv2[1], uv3[0], uv3[1]);
-                //        }
-                //    }
-                //}
-                break;
+            if (message.do_free_data) _bolt_staging_free(message.data);
+            break;
+        }
+        case Message_TextureWritten:
+            _bolt_sprite_index_invalidate(&worker->sprites, message.asset, message.x, message.y, message.w, message.h);
+            break;
+        case Message_glDeleteTextures: {
+            _bolt_share_group_destroy_textures(group, message.w, message.data);
+            if (message.do_free_data) _bolt_staging_free(message.data);
+            break;
+        }
+        case Message_eglSwapBuffers: {
+            atomic_store(&worker->frames_completed, message.index);
+            if (atomic_load(&worker->frame_waiters)) _bolt_futex_wake(&worker->frames_completed);
+            break;
+        }
+        case Message_FrameEnd: {
+            const struct BoltRenderList frame = worker->captured;
+            worker->captured = worker->capture;
+            worker->capture = frame;
+            // `capture` is now the previous frame, which stays as it is until it's cleared below. text extraction
+            // uses the delta too, to skip frames where nothing changed, but it can manage without one.
+            const uint8_t render = _bolt_render_has_subscribers();
+            const uint8_t text = _bolt_text_has_subscribers();
+            const uint8_t diffed = (render || text) && _bolt_render_list_diff(&worker->capture, &worker->captured, &worker->delta);
+            if (render && diffed) _bolt_render_publish(group, &worker->captured, &worker->capture, &worker->delta);
+            if (text) {
+                const struct BoltRenderDelta* delta = (diffed && worker->text_followed) ? &worker->delta : NULL;
+                _bolt_text_publish(group, _bolt_text_update(&worker->text, group, &worker->captured, delta, atomic_load(&hook_set_generation[HOOK_SET_TEXTURES])));
             }
-            case Message_glBindTexture: {
-                if (message.target == GL_TEXTURE_2D) {
-                    c->bound_texture_id = message.asset;
-                }
-                break;
+            worker->text_followed = text;
+            _bolt_render_list_clear(&worker->capture);
+            break;
+        }
+        case Message_glFlush: {
+            struct BoltSyncData* data = message.data;
+            real_glFlush();
+            pthread_mutex_lock(&data->mutex);
+            data->done = 1;
+            pthread_cond_signal(&data->cond);
+            pthread_mutex_unlock(&data->mutex);
+            break;
+        }
+    }
+}
+
+// dedicated thread for handling most tasks, invoked by eglInitialize. see above backlog_limit for the order they're handled in
+void* _bolt_worker_thread(void* arg) {
+    struct BoltWorker* worker = arg;
+    struct BoltBacklog backlog = {0};
+    struct BoltMessage message;
+    if (worker->context) real_eglMakeCurrent(worker->display, NULL, NULL, worker->context);
+    while (1) {
+        if (!_bolt_queue_try_pop(&worker->queue, &message)) {
+            if (backlog.count) {
+                _bolt_backlog_pop(&backlog, &message);
+                _bolt_handle_message(worker, message);
+                continue;
             }
-            case Message_glTexSubImage2D: {
-                if (message.target == GL_TEXTURE_2D && message.format == GL_RGBA) {
-                    struct GLTexture2D* tex = _bolt_find_texture(c->shared_textures, c->bound_texture_id);
-                    if (tex && !(message.x < 0 || message.y < 0 || message.x + message.w > tex->width || message.y + message.h > tex->height)) {
-                        for (unsigned int y = 0; y < message.h; y += 1) {
-                            unsigned char* dest_ptr = tex->data + ((tex->width * (y + message.y)) + message.x) * 4;
-                            const void* src_ptr = message.data + (message.w * y * 4);
-                            memcpy(dest_ptr, src_ptr, message.w * 4);
-                        }
-                    }
-                }
-                if (message.do_free_data) free(message.data);
-                break;
+            _bolt_queue_pop(&worker->queue, &message);
+        }
+        if (message.instruction == Message_Quit) {
+            while (backlog.count) {
+                _bolt_backlog_pop(&backlog, &message);
+                if (message.do_free_data) _bolt_staging_free(message.data);
             }
-            case Message_glDeleteTextures: {
-                _bolt_context_destroy_textures(c, message.w, message.data);
-                if (message.do_free_data) free(message.data);
-                break;
+            free(backlog.messages);
+            if (worker->context) {
+                real_eglMakeCurrent(worker->display, NULL, NULL, NULL);
+                real_eglDestroyContext(worker->display, worker->context);
             }
-            case Message_eglSwapBuffers: {
-                struct BoltSyncData* data = message.data;
-                pthread_mutex_lock(&data->mutex);
-                data->done = 1;
-                pthread_cond_signal(&data->cond);
-                pthread_mutex_unlock(&data->mutex);
-                break;
+            return NULL;
+        }
+        if (!backlog_limit || !_bolt_message_is_bulk(message.instruction)) {
+            _bolt_handle_message(worker, message);
+            continue;
+        }
+        if (backlog.count >= backlog_limit) {
+            if (message.instruction == Message_glDrawElements) {
+                if (message.do_free_data) _bolt_staging_free(message.data);
+                atomic_fetch_add_explicit(&backlog_dropped, 1, memory_order_relaxed);
+                continue;
             }
-            case Message_glFlush: {
-                struct BoltSyncData* data = message.data;
-                real_glFlush();
-                pthread_mutex_lock(&data->mutex);
-                data->done = 1;
-                pthread_cond_signal(&data->cond);
-                pthread_mutex_unlock(&data->mutex);
-                break;
+            struct BoltMessage oldest;
+            _bolt_backlog_pop(&backlog, &oldest);
+            _bolt_handle_message(worker, oldest);
+        }
+        if (!_bolt_backlog_push(&backlog, &message)) {
+            // out of memory, so catch up on the whole backlog to keep the bulk lane in order
+            struct BoltMessage oldest;
+            while (backlog.count) {
+                _bolt_backlog_pop(&backlog, &oldest);
+                _bolt_handle_message(worker, oldest);
             }
+            _bolt_handle_message(worker, message);
         }
     }
 }
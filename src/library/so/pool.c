@@ -0,0 +1,154 @@
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <unistd.h>
+#undef _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+// size classes go from 64 bytes (1 << MIN_CLASS_SHIFT) up to 2GiB. anything bigger isn't pooled at all.
+#define MIN_CLASS_SHIFT 6
+#define CLASS_COUNT 26
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// each free list is a stack linked through the first word of each block. blocks are pushed one at a time, or as a
+// whole chain when a thread exits, and only ever popped by taking the whole stack, so the usual ABA problem with
+// lock-free stacks can't happen.
+static _Atomic(void*) free_lists[CLASS_COUNT];
+static _Thread_local void* local_lists[CLASS_COUNT];
+// every thread that takes a stack into local_lists sets this key, so that what's left gets pushed back when it exits
+static pthread_key_t local_lists_key;
+static uint8_t local_lists_key_created = 0;
+static _Thread_local uint8_t local_lists_registered = 0;
+
+static size_t page_size = 4096;
+static uint8_t use_huge_pages = 0;
+static size_t max_cached_bytes = 0;
+
+static _Atomic uint64_t stat_allocations;
+static _Atomic uint64_t stat_cache_hits;
+static _Atomic uint64_t stat_frees;
+static _Atomic uint64_t stat_system_allocations;
+static _Atomic uint64_t stat_system_frees;
+static _Atomic uint64_t stat_huge_page_blocks;
+static _Atomic uint64_t stat_bytes_in_use;
+static _Atomic uint64_t stat_bytes_cached;
+
+#define STAT_ADD(NAME, N) atomic_fetch_add_explicit(&stat_##NAME, (N), memory_order_relaxed)
+#define STAT_SUB(NAME, N) atomic_fetch_sub_explicit(&stat_##NAME, (N), memory_order_relaxed)
+
+static void _bolt_pool_push_chain(int class, void* first, void* last) {
+    void* head = atomic_load_explicit(&free_lists[class], memory_order_relaxed);
+    do {
+        *(void**)last = head;
+    } while (!atomic_compare_exchange_weak_explicit(&free_lists[class], &head, first, memory_order_release, memory_order_relaxed));
+}
+
+// runs when a thread that has a local cache exits. the blocks are still counted in bytes_cached, so they go back on the
+// shared lists where another thread can use them, rather than leaking.
+static void _bolt_pool_thread_exit(void* unused) {
+    (void)unused;
+    for (int class = 0; class < CLASS_COUNT; class += 1) {
+        void* first = local_lists[class];
+        if (!first) continue;
+        void* last = first;
+        while (*(void**)last) last = *(void**)last;
+        local_lists[class] = NULL;
+        _bolt_pool_push_chain(class, first, last);
+    }
+}
+
+void _bolt_pool_init(uint8_t huge_pages, size_t max_cached) {
+    const long page = sysconf(_SC_PAGESIZE);
+    if (page > 0) page_size = (size_t)page;
+    if (!local_lists_key_created) local_lists_key_created = pthread_key_create(&local_lists_key, _bolt_pool_thread_exit) == 0;
+    use_huge_pages = huge_pages;
+    max_cached_bytes = max_cached;
+}
+
+size_t _bolt_pool_capacity(size_t size) {
+    if (size <= (1 << MIN_CLASS_SHIFT)) return 1 << MIN_CLASS_SHIFT;
+    if (size > ((size_t)1 << (MIN_CLASS_SHIFT + CLASS_COUNT - 1))) return size;
+    return (size_t)1 << (64 - __builtin_clzll(size - 1));
+}
+
+// returns the index into free_lists for a block of this capacity, or -1 if it's too big to be pooled
+static int _bolt_pool_class(size_t capacity) {
+    if (capacity > ((size_t)1 << (MIN_CLASS_SHIFT + CLASS_COUNT - 1))) return -1;
+    return (63 - __builtin_clzll(capacity)) - MIN_CLASS_SHIFT;
+}
+
+static void* _bolt_pool_system_alloc(size_t capacity) {
+    STAT_ADD(system_allocations, 1);
+    if (capacity < page_size) return malloc(capacity);
+    if (!use_huge_pages || capacity < HUGE_PAGE_SIZE) {
+        void* ptr = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return ptr == MAP_FAILED ? NULL : ptr;
+    }
+    // transparent huge pages can only back memory that's aligned to the huge page size, so over-allocate and trim
+    uint8_t* ptr = mmap(NULL, capacity + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) return NULL;
+    uint8_t* aligned = (uint8_t*)(((uintptr_t)ptr + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+    if (aligned != ptr) munmap(ptr, aligned - ptr);
+    munmap(aligned + capacity, (ptr + HUGE_PAGE_SIZE) - aligned);
+    if (madvise(aligned, capacity, MADV_HUGEPAGE) == 0) STAT_ADD(huge_page_blocks, 1);
+    return aligned;
+}
+
+static void _bolt_pool_system_free(void* ptr, size_t capacity) {
+    STAT_ADD(system_frees, 1);
+    if (capacity < page_size) free(ptr);
+    else munmap(ptr, capacity);
+}
+
+void* _bolt_pool_alloc(size_t size) {
+    const size_t capacity = _bolt_pool_capacity(size);
+    const int class = _bolt_pool_class(capacity);
+    STAT_ADD(allocations, 1);
+    void* ptr = NULL;
+    if (class >= 0) {
+        if (!local_lists[class]) {
+            local_lists[class] = atomic_exchange(&free_lists[class], NULL);
+            // the value only has to be non-NULL for the destructor to run
+            if (local_lists[class] && !local_lists_registered && local_lists_key_created) {
+                local_lists_registered = pthread_setspecific(local_lists_key, &local_lists_registered) == 0;
+            }
+        }
+        ptr = local_lists[class];
+        if (ptr) {
+            local_lists[class] = *(void**)ptr;
+            STAT_ADD(cache_hits, 1);
+            STAT_SUB(bytes_cached, capacity);
+        }
+    }
+    if (!ptr) ptr = _bolt_pool_system_alloc(capacity);
+    if (ptr) STAT_ADD(bytes_in_use, capacity);
+    return ptr;
+}
+
+void _bolt_pool_free(void* ptr, size_t capacity) {
+    if (!ptr) return;
+    const int class = _bolt_pool_class(capacity);
+    STAT_ADD(frees, 1);
+    STAT_SUB(bytes_in_use, capacity);
+    if (class < 0 || atomic_load_explicit(&stat_bytes_cached, memory_order_relaxed) + capacity > max_cached_bytes) {
+        _bolt_pool_system_free(ptr, capacity);
+        return;
+    }
+    STAT_ADD(bytes_cached, capacity);
+    _bolt_pool_push_chain(class, ptr, ptr);
+}
+
+void _bolt_pool_stats(struct BoltPoolStats* stats) {
+    stats->allocations = atomic_load_explicit(&stat_allocations, memory_order_relaxed);
+    stats->cache_hits = atomic_load_explicit(&stat_cache_hits, memory_order_relaxed);
+    stats->frees = atomic_load_explicit(&stat_frees, memory_order_relaxed);
+    stats->system_allocations = atomic_load_explicit(&stat_system_allocations, memory_order_relaxed);
+    stats->system_frees = atomic_load_explicit(&stat_system_frees, memory_order_relaxed);
+    stats->huge_page_blocks = atomic_load_explicit(&stat_huge_page_blocks, memory_order_relaxed);
+    stats->bytes_in_use = atomic_load_explicit(&stat_bytes_in_use, memory_order_relaxed);
+    stats->bytes_cached = atomic_load_explicit(&stat_bytes_cached, memory_order_relaxed);
+}
@@ -0,0 +1,41 @@
+#ifndef _BOLT_LIBRARY_SO_POOL_H_
+#define _BOLT_LIBRARY_SO_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// size-class allocator for buffer shadows. every block is a power of two in size, so a buffer that gets re-specified
+// with roughly the same size every frame keeps getting the same few blocks back instead of going through malloc.
+// blocks are normally allocated on a game thread and freed on the worker, so frees push onto a lock-free stack per
+// size class, and each allocating thread takes the whole stack at once into a thread-local cache when it runs dry.
+// whatever's left in a thread's cache when it exits goes back on the shared stacks.
+// blocks of a page or more come straight from mmap, and blocks of 2MiB or more can optionally use huge pages.
+// blocks don't have headers, so the caller has to remember the capacity that each block was allocated with.
+
+struct BoltPoolStats {
+    uint64_t allocations; // calls to _bolt_pool_alloc
+    uint64_t cache_hits; // allocations that reused a block instead of getting a new one
+    uint64_t frees; // calls to _bolt_pool_free
+    uint64_t system_allocations; // blocks obtained from malloc or mmap
+    uint64_t system_frees; // blocks given back to free or munmap
+    uint64_t huge_page_blocks; // system allocations that were advised to use huge pages
+    uint64_t bytes_in_use; // capacity of all blocks currently allocated
+    uint64_t bytes_cached; // capacity of all blocks waiting to be reused
+};
+
+// sets up the pool. huge pages are only requested if use_huge_pages is set. freed blocks are returned to the system
+// instead of being cached if more than max_cached_bytes are already cached.
+void _bolt_pool_init(uint8_t use_huge_pages, size_t max_cached_bytes);
+
+// returns the block size that an allocation of `size` bytes will get, which is always at least `size`
+size_t _bolt_pool_capacity(size_t size);
+
+// allocates a block with a capacity of _bolt_pool_capacity(size). returns NULL on failure. contents are undefined.
+void* _bolt_pool_alloc(size_t size);
+
+// frees a block. `capacity` must be the capacity it was allocated with. may be called from any thread.
+void _bolt_pool_free(void* ptr, size_t capacity);
+
+void _bolt_pool_stats(struct BoltPoolStats*);
+
+#endif
@@ -0,0 +1,136 @@
+#define _GNU_SOURCE
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#undef _GNU_SOURCE
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "queue.h"
+
+// how many times to re-check the queue before going to sleep on a futex
+#define SPIN_COUNT 128
+
+// each slot is its sequence number followed by the item, padded so that the next slot's sequence number is aligned
+#define SLOT_HEADER 8
+
+void _bolt_futex_wait(_Atomic uint32_t* addr, uint32_t expected) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+void _bolt_futex_wake(_Atomic uint32_t* addr) {
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+static inline void _bolt_cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static inline _Atomic uint32_t* _bolt_queue_sequence(struct BoltQueue* queue, uint32_t position) {
+    return (_Atomic uint32_t*)(queue->slots + ((position & (queue->capacity - 1)) * queue->slot_size));
+}
+
+static inline uint8_t* _bolt_queue_item(struct BoltQueue* queue, uint32_t position) {
+    return queue->slots + ((position & (queue->capacity - 1)) * queue->slot_size) + SLOT_HEADER;
+}
+
+int _bolt_queue_init(struct BoltQueue* queue, size_t item_size, uint32_t capacity) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 || capacity > (1u << 30)) return -1;
+    const size_t slot_size = (SLOT_HEADER + item_size + 7) & ~(size_t)7;
+    if (slot_size > SIZE_MAX / capacity) return -1;
+    // rounded up to a whole number of cache lines, as aligned_alloc requires
+    const size_t size = ((slot_size * capacity) + 63) & ~(size_t)63;
+    uint8_t* slots = aligned_alloc(64, size);
+    if (!slots) return -1;
+    queue->slots = slots;
+    queue->slot_size = slot_size;
+    queue->item_size = item_size;
+    queue->capacity = capacity;
+    // slot i is free for whoever claims position i
+    for (uint32_t i = 0; i < capacity; i += 1) atomic_init(_bolt_queue_sequence(queue, i), i);
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->published, 0);
+    atomic_init(&queue->consumer_sleeping, 0);
+    atomic_init(&queue->producers_sleeping, 0);
+    return 0;
+}
+
+void _bolt_queue_destroy(struct BoltQueue* queue) {
+    free(queue->slots);
+    queue->slots = NULL;
+}
+
+// the sleeping flag is set before re-checking the slot, and the other side checks it after updating the slot, so one
+// of the two always notices the other and a wakeup can't be lost. `watch` is a counter the other side bumps after
+// updating any slot, and `seen` is its value from before the slot was last checked.
+static void _bolt_queue_sleep(_Atomic uint32_t* watch, _Atomic uint32_t* sleeping, uint32_t seen, _Atomic uint32_t* sequence, uint32_t wanted) {
+    atomic_store(sleeping, 1);
+    if (atomic_load(sequence) != wanted) _bolt_futex_wait(watch, seen);
+}
+
+static void _bolt_queue_notify(_Atomic uint32_t* watch, _Atomic uint32_t* sleeping) {
+    if (atomic_load(sleeping) && atomic_exchange(sleeping, 0)) _bolt_futex_wake(watch);
+}
+
+void _bolt_queue_push(struct BoltQueue* queue, const void* item) {
+    if (!queue->slots) return;
+    uint32_t position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t spins = 0;
+    while (1) {
+        _Atomic uint32_t* sequence = _bolt_queue_sequence(queue, position);
+        const uint32_t seen = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        const int32_t diff = (int32_t)(atomic_load_explicit(sequence, memory_order_acquire) - position);
+        if (diff == 0) {
+            // on failure this reloads `position`, and goes round again with the new one
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // the slot still has an item from the last time round, i.e. the queue is full
+            if (spins < SPIN_COUNT) {
+                spins += 1;
+                _bolt_cpu_relax();
+            } else {
+                _bolt_queue_sleep(&queue->tail, &queue->producers_sleeping, seen, sequence, position);
+            }
+            position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        } else {
+            // someone else claimed it first
+            position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+    memcpy(_bolt_queue_item(queue, position), item, queue->item_size);
+    atomic_store(_bolt_queue_sequence(queue, position), position + 1);
+    atomic_fetch_add(&queue->published, 1);
+    _bolt_queue_notify(&queue->published, &queue->consumer_sleeping);
+}
+
+uint8_t _bolt_queue_try_pop(struct BoltQueue* queue, void* item) {
+    const uint32_t position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    _Atomic uint32_t* sequence = _bolt_queue_sequence(queue, position);
+    if (atomic_load_explicit(sequence, memory_order_acquire) != position + 1) return 0;
+    memcpy(item, _bolt_queue_item(queue, position), queue->item_size);
+    // free for whoever claims this slot next time round
+    atomic_store(sequence, position + queue->capacity);
+    atomic_store(&queue->tail, position + 1);
+    _bolt_queue_notify(&queue->tail, &queue->producers_sleeping);
+    return 1;
+}
+
+void _bolt_queue_pop(struct BoltQueue* queue, void* item) {
+    size_t spins = 0;
+    while (1) {
+        const uint32_t seen = atomic_load(&queue->published);
+        if (_bolt_queue_try_pop(queue, item)) return;
+        if (spins < SPIN_COUNT) {
+            spins += 1;
+            _bolt_cpu_relax();
+            continue;
+        }
+        const uint32_t position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        _bolt_queue_sleep(&queue->published, &queue->consumer_sleeping, seen, _bolt_queue_sequence(queue, position), position + 1);
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef _BOLT_LIBRARY_SO_QUEUE_H_
+#define _BOLT_LIBRARY_SO_QUEUE_H_
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// bounded multi-producer single-consumer queue of fixed-size items, used in place of a socketpair for sending messages
+// to the worker thread. any number of threads can push at once, since GL calls for different contexts in the same
+// share group can come from different threads, and items from any one thread always come out in the order they went
+// in. nobody makes a syscall unless the other side is asleep.
+// each slot has a sequence number saying whose turn it is: a producer claims a slot by advancing `head`, fills it in
+// and then publishes it by bumping its sequence number, so producers never wait for each other, only for the consumer
+// to free up space. a producer that's preempted between claiming and publishing holds up the consumer, but no other
+// producer. head, tail and sequence numbers are free-running, so capacity must be a power of two no greater than 2^30.
+struct BoltQueue {
+    _Alignas(64) _Atomic uint32_t head; // next slot to claim, shared by the producers
+    _Atomic uint32_t consumer_sleeping;
+    _Atomic uint32_t published; // goes up every time a slot's published, for the consumer to sleep on
+    _Alignas(64) _Atomic uint32_t tail; // next slot to read, owned by the consumer
+    _Atomic uint32_t producers_sleeping;
+    _Alignas(64) uint8_t* slots;
+    size_t slot_size;
+    size_t item_size;
+    uint32_t capacity;
+};
+
+// allocates room for `capacity` items of `item_size` bytes each, returns 0 on success
+int _bolt_queue_init(struct BoltQueue*, size_t item_size, uint32_t capacity);
+void _bolt_queue_destroy(struct BoltQueue*);
+
+// copies one item into the queue, blocking while it's full. can be called from any thread.
+void _bolt_queue_push(struct BoltQueue*, const void* item);
+
+// copies the next item out of the queue, blocking while it's empty. must only ever be called from one thread.
+void _bolt_queue_pop(struct BoltQueue*, void* item);
+
+// same as _bolt_queue_pop, but returns 0 without blocking if the next item isn't there yet, or 1 if it was read. must
+// only be called from the thread that calls _bolt_queue_pop.
+uint8_t _bolt_queue_try_pop(struct BoltQueue*, void* item);
+
+// futex helpers, also used for other cross-thread waits in the library
+void _bolt_futex_wait(_Atomic uint32_t*, uint32_t expected);
+void _bolt_futex_wake(_Atomic uint32_t*);
+
+#endif
@@ -0,0 +1,98 @@
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#undef _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "staging.h"
+
+#define STAGING_ALIGNMENT 16
+
+struct StagingArena {
+    _Alignas(64) _Atomic size_t used;
+    _Atomic uint32_t outstanding; // payloads allocated from this arena and not released yet
+};
+
+// all the arenas are in one mapping, so it's easy to tell which one a pointer came from
+static uint8_t* memory = NULL;
+static struct StagingArena* arenas = NULL;
+static unsigned int arena_count = 0;
+static size_t arena_size = 0;
+static _Atomic unsigned int current = 0;
+// every context's swap moves the ring on, from whichever thread it's on, so only one of them can do it at a time
+static pthread_mutex_t next_frame_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int _bolt_staging_init(unsigned int count, size_t size) {
+    if (count < 2) return -1;
+    size = (size + STAGING_ALIGNMENT - 1) & ~(size_t)(STAGING_ALIGNMENT - 1);
+    void* mapping = mmap(NULL, count * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) return -1;
+    arenas = calloc(count, sizeof(*arenas));
+    if (!arenas) {
+        munmap(mapping, count * size);
+        return -1;
+    }
+    memory = mapping;
+    arena_count = count;
+    arena_size = size;
+    atomic_store(&current, 0);
+    return 0;
+}
+
+void _bolt_staging_destroy() {
+    if (memory) munmap(memory, arena_count * arena_size);
+    free(arenas);
+    memory = NULL;
+    arenas = NULL;
+    arena_count = 0;
+    arena_size = 0;
+}
+
+void* _bolt_staging_alloc(size_t size) {
+    size = (size + STAGING_ALIGNMENT - 1) & ~(size_t)(STAGING_ALIGNMENT - 1);
+    if (arenas && size <= arena_size) {
+        const unsigned int index = atomic_load(&current);
+        struct StagingArena* arena = &arenas[index];
+        // registering as outstanding before checking that the arena is still current means that the arena can't be
+        // recycled underneath us: either _bolt_staging_next_frame sees the count and leaves it alone, or it had
+        // already reset the arena and made it current before we looked
+        atomic_fetch_add(&arena->outstanding, 1);
+        if (atomic_load(&current) == index) {
+            const size_t offset = atomic_fetch_add(&arena->used, size);
+            if (offset + size <= arena_size) return memory + (index * arena_size) + offset;
+        }
+        atomic_fetch_sub(&arena->outstanding, 1);
+    }
+    return malloc(size);
+}
+
+void* _bolt_staging_copy(const void* data, size_t size) {
+    void* ptr = _bolt_staging_alloc(size);
+    if (ptr) memcpy(ptr, data, size);
+    return ptr;
+}
+
+void _bolt_staging_free(void* ptr) {
+    if (!ptr) return;
+    if (memory && (uint8_t*)ptr >= memory && (uint8_t*)ptr < memory + (arena_count * arena_size)) {
+        atomic_fetch_sub(&arenas[((uint8_t*)ptr - memory) / arena_size].outstanding, 1);
+    } else {
+        free(ptr);
+    }
+}
+
+void _bolt_staging_next_frame() {
+    if (!arenas) return;
+    pthread_mutex_lock(&next_frame_lock);
+    const unsigned int next = (atomic_load(&current) + 1) % arena_count;
+    struct StagingArena* arena = &arenas[next];
+    // if the worker is more than a whole ring of frames behind, just keep filling up the current arena
+    if (!atomic_load(&arena->outstanding)) {
+        atomic_store(&arena->used, 0);
+        atomic_store(&current, next);
+    }
+    pthread_mutex_unlock(&next_frame_lock);
+}
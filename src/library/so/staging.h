@@ -0,0 +1,30 @@
+#ifndef _BOLT_LIBRARY_SO_STAGING_H_
+#define _BOLT_LIBRARY_SO_STAGING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// per-frame staging memory for message payloads, i.e. anything a hook needs to copy for the worker to look at later.
+// hooks bump-allocate from the current arena without taking any locks, and the worker releases each payload after
+// handling its message. at the end of each frame the next arena in the ring becomes current, but only once the worker
+// has released everything in it, so a payload is always valid until the worker is done with it. if the next arena
+// isn't free yet, or a payload doesn't fit, it falls back to malloc. _bolt_staging_free tells the two apart.
+
+// allocates `count` arenas of `size` bytes each. count must be at least 2. returns 0 on success.
+int _bolt_staging_init(unsigned int count, size_t size);
+// frees the arenas. must only be called once nothing will be released any more, i.e. after the worker has stopped.
+void _bolt_staging_destroy();
+
+// allocates space for a payload, which may come from an arena or from malloc. may be called from any thread.
+void* _bolt_staging_alloc(size_t size);
+// allocates space for a payload and copies `size` bytes into it
+void* _bolt_staging_copy(const void* data, size_t size);
+// releases a payload allocated with one of the above functions. NULL is ignored.
+void _bolt_staging_free(void*);
+
+// moves on to the next arena if every worker has finished with it. called at the end of each frame, so with more than
+// one context swapping it moves on more than once per frame, which only means arenas are recycled sooner. may be
+// called from any thread.
+void _bolt_staging_next_frame();
+
+#endif
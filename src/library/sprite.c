@@ -0,0 +1,472 @@
+#include "sprite.h"
+#include "dxt.h"
+#include "gl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SPRITE_PRIME_1 0x9E3779B185EBCA87ULL
+#define SPRITE_PRIME_2 0xC2B2AE3D27D4EB4FULL
+#define SPRITE_PRIME_3 0x165667B19E3779F9ULL
+#define SPRITE_PRIME_4 0x85EBCA77C2B2AE63ULL
+#define SPRITE_PRIME_5 0x27D4EB2F165667C5ULL
+
+static uint64_t _bolt_rotl(uint64_t x, unsigned int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t _bolt_sprite_round(uint64_t acc, uint64_t word) {
+    return _bolt_rotl(acc + (word * SPRITE_PRIME_2), 31) * SPRITE_PRIME_1;
+}
+
+static uint64_t _bolt_sprite_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= SPRITE_PRIME_2;
+    h ^= h >> 29;
+    h *= SPRITE_PRIME_3;
+    return h ^ (h >> 32);
+}
+
+// xxHash64's structure: four independent lanes over 32-byte stripes, so that the multiplies can overlap, then the
+// leftovers a word and then a byte at a time. each row's hash is the seed for the next one.
+static uint64_t _bolt_sprite_hash_row(const uint8_t* p, size_t n, uint64_t seed) {
+    const uint8_t* const end = p + n;
+    uint64_t h;
+    if (n >= 32) {
+        uint64_t a = seed + SPRITE_PRIME_1 + SPRITE_PRIME_2;
+        uint64_t b = seed + SPRITE_PRIME_2;
+        uint64_t c = seed;
+        uint64_t d = seed - SPRITE_PRIME_1;
+        for (; p + 32 <= end; p += 32) {
+            uint64_t w[4];
+            memcpy(w, p, sizeof(w));
+            a = _bolt_sprite_round(a, w[0]);
+            b = _bolt_sprite_round(b, w[1]);
+            c = _bolt_sprite_round(c, w[2]);
+            d = _bolt_sprite_round(d, w[3]);
+        }
+        h = _bolt_rotl(a, 1) + _bolt_rotl(b, 7) + _bolt_rotl(c, 12) + _bolt_rotl(d, 18);
+    } else {
+        h = seed + SPRITE_PRIME_5;
+    }
+    h += n;
+    for (; p + 8 <= end; p += 8) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        h = (_bolt_rotl(h ^ _bolt_sprite_round(0, w), 27) * SPRITE_PRIME_1) + SPRITE_PRIME_4;
+    }
+    for (; p < end; p += 1) h = _bolt_rotl(h ^ (*p * SPRITE_PRIME_5), 11) * SPRITE_PRIME_1;
+    return _bolt_sprite_mix(h);
+}
+
+uint64_t _bolt_sprite_hash(const void* data, size_t row_size, size_t rows, size_t pitch, uint64_t seed) {
+    uint64_t h = seed;
+    for (size_t row = 0; row < rows; row += 1) h = _bolt_sprite_hash_row((const uint8_t*)data + (row * pitch), row_size, h);
+    return h ? h : 1;
+}
+
+uint64_t _bolt_sprite_hash_pixels(const void* pixels, unsigned int w, unsigned int h, size_t pitch) {
+    return _bolt_sprite_hash(pixels, (size_t)w * 4, h, pitch, _bolt_sprite_mix(((uint64_t)w << 32) ^ h));
+}
+
+// the hash tables are the same kind as GLList's index: linear probing, with backward-shift deletion so that they never
+// fill up with tombstones. key 0 marks an empty slot.
+#define SPRITE_MAP_MIN_CAPACITY 64
+static size_t _bolt_sprite_map_home(const struct BoltSpriteMap* map, uint64_t key) {
+    return (size_t)_bolt_sprite_mix(key) & (map->capacity - 1);
+}
+
+uint32_t _bolt_sprite_map_get(const struct BoltSpriteMap* map, uint64_t key) {
+    if (!map->capacity || !key) return SPRITE_NONE;
+    const size_t mask = map->capacity - 1;
+    for (size_t i = _bolt_sprite_map_home(map, key);; i = (i + 1) & mask) {
+        if (map->slots[i].key == key) return map->slots[i].value;
+        if (map->slots[i].key == 0) return SPRITE_NONE;
+    }
+}
+
+uint8_t _bolt_sprite_map_put(struct BoltSpriteMap* map, uint64_t key, uint32_t value) {
+    if (!key) return 0;
+    if ((map->count + 1) * 2 > map->capacity) {
+        const size_t capacity = map->capacity ? map->capacity * 2 : SPRITE_MAP_MIN_CAPACITY;
+        struct BoltSpriteMapSlot* slots = calloc(capacity, sizeof(*slots));
+        if (!slots) return 0;
+        struct BoltSpriteMap old = *map;
+        map->slots = slots;
+        map->capacity = capacity;
+        map->count = 0;
+        for (size_t i = 0; i < old.capacity; i += 1) {
+            if (old.slots[i].key) _bolt_sprite_map_put(map, old.slots[i].key, old.slots[i].value);
+        }
+        free(old.slots);
+    }
+    const size_t mask = map->capacity - 1;
+    size_t i = _bolt_sprite_map_home(map, key);
+    while (map->slots[i].key != 0 && map->slots[i].key != key) i = (i + 1) & mask;
+    if (map->slots[i].key == 0) map->count += 1;
+    map->slots[i] = (struct BoltSpriteMapSlot){.key = key, .value = value};
+    return 1;
+}
+
+static void _bolt_sprite_map_remove(struct BoltSpriteMap* map, uint64_t key) {
+    if (!map->capacity || !key) return;
+    const size_t mask = map->capacity - 1;
+    size_t i = _bolt_sprite_map_home(map, key);
+    while (map->slots[i].key != key) {
+        if (map->slots[i].key == 0) return;
+        i = (i + 1) & mask;
+    }
+    size_t hole = i;
+    for (size_t j = (i + 1) & mask; map->slots[j].key != 0; j = (j + 1) & mask) {
+        const size_t home = _bolt_sprite_map_home(map, map->slots[j].key);
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            map->slots[hole] = map->slots[j];
+            hole = j;
+        }
+    }
+    map->slots[hole].key = 0;
+    map->count -= 1;
+}
+
+void _bolt_sprite_map_clear(struct BoltSpriteMap* map) {
+    if (map->capacity) memset(map->slots, 0, map->capacity * sizeof(*map->slots));
+    map->count = 0;
+}
+
+static uint64_t _bolt_sprite_rect_key(unsigned int texture, unsigned int x, unsigned int y, unsigned int w, unsigned int h) {
+    uint64_t key = _bolt_sprite_mix(((uint64_t)texture << 32) | x);
+    key = _bolt_sprite_mix(key ^ (((uint64_t)y << 32) | w));
+    key = _bolt_sprite_mix(key ^ h);
+    return key ? key : 1;
+}
+
+static struct BoltSpriteGrid* _bolt_sprite_grid(struct BoltSpriteIndex* index, unsigned int texture) {
+    const uint32_t i = _bolt_sprite_map_get(&index->by_texture, texture);
+    return i == SPRITE_NONE ? NULL : &index->grids[i];
+}
+
+// the cells that (x, y, w, h) overlaps, clamped to the grid. returns 0 if there aren't any.
+static uint8_t _bolt_sprite_cells(const struct BoltSpriteGrid* grid, unsigned int x, unsigned int y, unsigned int w, unsigned int h,
+                                  unsigned int* cx0, unsigned int* cy0, unsigned int* cx1, unsigned int* cy1) {
+    if (!w || !h) return 0;
+    *cx0 = x / TEXTURE_TILE_SIZE;
+    *cy0 = y / TEXTURE_TILE_SIZE;
+    if (*cx0 >= grid->cells_wide || *cy0 >= grid->cells_high) return 0;
+    *cx1 = (unsigned int)(((size_t)x + w - 1) / TEXTURE_TILE_SIZE);
+    *cy1 = (unsigned int)(((size_t)y + h - 1) / TEXTURE_TILE_SIZE);
+    if (*cx1 >= grid->cells_wide) *cx1 = grid->cells_wide - 1;
+    if (*cy1 >= grid->cells_high) *cy1 = grid->cells_high - 1;
+    return 1;
+}
+
+static void _bolt_sprite_cell_remove(struct BoltSpriteCell* cell, uint32_t sprite) {
+    for (uint32_t i = 0; i < cell->count; i += 1) {
+        if (cell->sprites[i] == sprite) {
+            cell->sprites[i] = cell->sprites[--cell->count];
+            return;
+        }
+    }
+}
+
+// frees a content that nothing holds any more, so that its hash can be forgotten and its id reused
+static void _bolt_sprite_content_release(struct BoltSpriteIndex* index, uint32_t c) {
+    struct BoltSpriteContent* content = &index->contents[c];
+    _bolt_sprite_map_remove(&index->by_hash, content->hash);
+    content->hash = 0;
+    content->first = index->free_content;
+    index->free_content = c;
+}
+
+static void _bolt_sprite_remove(struct BoltSpriteIndex* index, uint32_t e) {
+    struct BoltSprite* sprite = &index->sprites[e];
+    struct BoltSpriteContent* content = &index->contents[sprite->id - 1];
+    if (sprite->prev_same != SPRITE_NONE) index->sprites[sprite->prev_same].next_same = sprite->next_same;
+    else content->first = sprite->next_same;
+    if (sprite->next_same != SPRITE_NONE) index->sprites[sprite->next_same].prev_same = sprite->prev_same;
+    if (content->first == SPRITE_NONE) _bolt_sprite_content_release(index, sprite->id - 1);
+
+    const uint64_t key = _bolt_sprite_rect_key(sprite->texture, sprite->x, sprite->y, sprite->w, sprite->h);
+    if (_bolt_sprite_map_get(&index->by_rect, key) == e) _bolt_sprite_map_remove(&index->by_rect, key);
+
+    struct BoltSpriteGrid* grid = _bolt_sprite_grid(index, sprite->texture);
+    unsigned int cx0, cy0, cx1, cy1;
+    if (grid && _bolt_sprite_cells(grid, sprite->x, sprite->y, sprite->w, sprite->h, &cx0, &cy0, &cx1, &cy1)) {
+        for (unsigned int cy = cy0; cy <= cy1; cy += 1) {
+            for (unsigned int cx = cx0; cx <= cx1; cx += 1) _bolt_sprite_cell_remove(&grid->cells[(cy * grid->cells_wide) + cx], e);
+        }
+    }
+
+    sprite->id = 0;
+    sprite->next_same = index->free_sprite;
+    index->free_sprite = e;
+}
+
+// drops every indexed rectangle that overlaps (x, y, w, h). cells are walked backwards, so that the sprite that each
+// removal swaps into the current position has already been looked at.
+static void _bolt_sprite_invalidate(struct BoltSpriteIndex* index, struct BoltSpriteGrid* grid, unsigned int x, unsigned int y, unsigned int w, unsigned int h) {
+    unsigned int cx0, cy0, cx1, cy1;
+    if (!_bolt_sprite_cells(grid, x, y, w, h, &cx0, &cy0, &cx1, &cy1)) return;
+    for (unsigned int cy = cy0; cy <= cy1; cy += 1) {
+        for (unsigned int cx = cx0; cx <= cx1; cx += 1) {
+            struct BoltSpriteCell* cell = &grid->cells[(cy * grid->cells_wide) + cx];
+            for (uint32_t i = cell->count; i > 0; i -= 1) {
+                const struct BoltSprite* sprite = &index->sprites[cell->sprites[i - 1]];
+                if (sprite->x < x + w && x < sprite->x + sprite->w && sprite->y < y + h && y < sprite->y + sprite->h) {
+                    _bolt_sprite_remove(index, cell->sprites[i - 1]);
+                }
+            }
+        }
+    }
+}
+
+static struct BoltSpriteGrid* _bolt_sprite_get_grid(struct BoltSpriteIndex* index, const struct GLTexture2D* tex) {
+    struct BoltSpriteGrid* grid = _bolt_sprite_grid(index, tex->id);
+    if (grid) return grid;
+    if (index->grid_count == index->grid_capacity) {
+        const size_t capacity = index->grid_capacity ? index->grid_capacity * 2 : 16;
+        struct BoltSpriteGrid* grids = realloc(index->grids, capacity * sizeof(*grids));
+        if (!grids) return NULL;
+        index->grids = grids;
+        index->grid_capacity = capacity;
+    }
+    const unsigned int cells_wide = (tex->width + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+    const unsigned int cells_high = (tex->height + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+    struct BoltSpriteCell* cells = calloc((size_t)cells_wide * cells_high, sizeof(*cells));
+    if (!cells || !_bolt_sprite_map_put(&index->by_texture, tex->id, (uint32_t)index->grid_count)) {
+        free(cells);
+        return NULL;
+    }
+    grid = &index->grids[index->grid_count++];
+    *grid = (struct BoltSpriteGrid){.texture = tex->id, .cells_wide = cells_wide, .cells_high = cells_high, .cells = cells};
+    return grid;
+}
+
+static uint32_t _bolt_sprite_alloc(struct BoltSpriteIndex* index) {
+    // a zeroed index is empty, and nothing can have been freed if nothing's ever been allocated
+    if (!index->sprite_count) index->free_sprite = SPRITE_NONE;
+    if (index->free_sprite != SPRITE_NONE) {
+        const uint32_t e = index->free_sprite;
+        index->free_sprite = index->sprites[e].next_same;
+        return e;
+    }
+    if (index->sprite_count == index->sprite_capacity) {
+        const size_t capacity = index->sprite_capacity ? index->sprite_capacity * 2 : 256;
+        struct BoltSprite* sprites = realloc(index->sprites, capacity * sizeof(*sprites));
+        if (!sprites) return SPRITE_NONE;
+        index->sprites = sprites;
+        index->sprite_capacity = capacity;
+    }
+    return (uint32_t)index->sprite_count++;
+}
+
+// finds or adds the content with this hash. a new one has no rectangles, so the caller must either give it one or
+// release it.
+static uint32_t _bolt_sprite_content(struct BoltSpriteIndex* index, uint64_t hash) {
+    const uint32_t c = _bolt_sprite_map_get(&index->by_hash, hash);
+    if (c != SPRITE_NONE) return c;
+    // same as sprites, a zeroed index has nothing to reuse
+    if (!index->content_count) index->free_content = SPRITE_NONE;
+    if (index->free_content != SPRITE_NONE) {
+        const uint32_t reused = index->free_content;
+        if (!_bolt_sprite_map_put(&index->by_hash, hash, reused)) return SPRITE_NONE;
+        index->free_content = index->contents[reused].first;
+        index->contents[reused] = (struct BoltSpriteContent){.hash = hash, .first = SPRITE_NONE};
+        return reused;
+    }
+    if (index->content_count == index->content_capacity) {
+        const size_t capacity = index->content_capacity ? index->content_capacity * 2 : 256;
+        struct BoltSpriteContent* contents = realloc(index->contents, capacity * sizeof(*contents));
+        if (!contents) return SPRITE_NONE;
+        index->contents = contents;
+        index->content_capacity = capacity;
+    }
+    if (!_bolt_sprite_map_put(&index->by_hash, hash, (uint32_t)index->content_count)) return SPRITE_NONE;
+    index->contents[index->content_count] = (struct BoltSpriteContent){.hash = hash, .first = SPRITE_NONE};
+    return (uint32_t)index->content_count++;
+}
+
+static uint8_t _bolt_sprite_cell_add(struct BoltSpriteCell* cell, uint32_t sprite) {
+    if (cell->count == cell->capacity) {
+        const uint32_t capacity = cell->capacity ? cell->capacity * 2 : 4;
+        uint32_t* sprites = realloc(cell->sprites, capacity * sizeof(*sprites));
+        if (!sprites) return 0;
+        cell->sprites = sprites;
+        cell->capacity = capacity;
+    }
+    cell->sprites[cell->count++] = sprite;
+    return 1;
+}
+
+// adds a rectangle, which must be inside the grid's texture and not already indexed
+static void _bolt_sprite_insert(struct BoltSpriteIndex* index, struct BoltSpriteGrid* grid, unsigned int x, unsigned int y, unsigned int w, unsigned int h, uint64_t hash) {
+    unsigned int cx0, cy0, cx1, cy1;
+    if (!_bolt_sprite_cells(grid, x, y, w, h, &cx0, &cy0, &cx1, &cy1)) return;
+    const uint32_t c = _bolt_sprite_content(index, hash);
+    if (c == SPRITE_NONE) return;
+    const uint32_t e = _bolt_sprite_alloc(index);
+    if (e == SPRITE_NONE) {
+        if (index->contents[c].first == SPRITE_NONE) _bolt_sprite_content_release(index, c);
+        return;
+    }
+    struct BoltSpriteContent* content = &index->contents[c];
+    index->sprites[e] = (struct BoltSprite){
+        .hash = hash, .id = c + 1, .texture = grid->texture, .x = x, .y = y, .w = w, .h = h, .prev_same = SPRITE_NONE, .next_same = content->first,
+    };
+    if (content->first != SPRITE_NONE) index->sprites[content->first].prev_same = e;
+    content->first = e;
+
+    // if anything can't be allocated, the sprite is taken back out again, which copes with it only being half-added
+    uint8_t ok = _bolt_sprite_map_put(&index->by_rect, _bolt_sprite_rect_key(grid->texture, x, y, w, h), e);
+    for (unsigned int cy = cy0; ok && cy <= cy1; cy += 1) {
+        for (unsigned int cx = cx0; ok && cx <= cx1; cx += 1) ok = _bolt_sprite_cell_add(&grid->cells[(cy * grid->cells_wide) + cx], e);
+    }
+    if (!ok) _bolt_sprite_remove(index, e);
+}
+
+void _bolt_sprite_index_upload(struct BoltSpriteIndex* index, const struct GLTexture2D* tex, uint32_t format, unsigned int x, unsigned int y, unsigned int w, unsigned int h, const void* data, size_t data_pitch) {
+    if (!tex->tiles || !data || !w || !h || x >= tex->width || y >= tex->height) return;
+    struct BoltSpriteGrid* grid = _bolt_sprite_get_grid(index, tex);
+    if (!grid) return;
+    const unsigned int clipped_w = (x + w > tex->width) ? tex->width - x : w;
+    const unsigned int clipped_h = (y + h > tex->height) ? tex->height - y : h;
+    grid->version = ++index->writes;
+    _bolt_sprite_invalidate(index, grid, x, y, clipped_w, clipped_h);
+    // an upload that was clipped doesn't hold the image it was hashed from, so it isn't indexed
+    if (clipped_w != w || clipped_h != h) return;
+
+    // RGBA going into an RGBA texture is already what reading it back would give, so it's hashed as it is. anything
+    // else is converted first, so that the same image always has the same hash however it got there.
+    if (format == GL_RGBA && tex->bytes_per_pixel == 4) {
+        _bolt_sprite_insert(index, grid, x, y, w, h, _bolt_sprite_hash_pixels(data, w, h, data_pitch ? data_pitch : (size_t)w * 4));
+        return;
+    }
+    const size_t size = (size_t)w * h * 4;
+    if (size > index->pixels_capacity) {
+        uint8_t* pixels = realloc(index->pixels, size);
+        if (!pixels) return;
+        index->pixels = pixels;
+        index->pixels_capacity = size;
+    }
+    _bolt_texture_upload_pixels(tex, format, w, h, data, data_pitch, index->pixels, (size_t)w * 4);
+    _bolt_sprite_insert(index, grid, x, y, w, h, _bolt_sprite_hash_pixels(index->pixels, w, h, (size_t)w * 4));
+}
+
+void _bolt_sprite_index_copy(struct BoltSpriteIndex* index, const struct GLTexture2D* dst, unsigned int dst_x, unsigned int dst_y, const struct GLTexture2D* src, unsigned int src_x, unsigned int src_y, unsigned int w, unsigned int h) {
+    // every source rectangle that's entirely inside the copied region is collected first, since the source and
+    // destination can be the same texture. each one is only collected from the cell its top-left corner is in.
+    size_t count = 0;
+    struct BoltSpriteGrid* src_grid = _bolt_sprite_grid(index, src->id);
+    unsigned int cx0, cy0, cx1, cy1;
+    if (src_grid && _bolt_sprite_cells(src_grid, src_x, src_y, w, h, &cx0, &cy0, &cx1, &cy1)) {
+        for (unsigned int cy = cy0; cy <= cy1; cy += 1) {
+            for (unsigned int cx = cx0; cx <= cx1; cx += 1) {
+                const struct BoltSpriteCell* cell = &src_grid->cells[(cy * src_grid->cells_wide) + cx];
+                for (uint32_t i = 0; i < cell->count; i += 1) {
+                    const struct BoltSprite* sprite = &index->sprites[cell->sprites[i]];
+                    if (sprite->x / TEXTURE_TILE_SIZE != cx || sprite->y / TEXTURE_TILE_SIZE != cy) continue;
+                    if (sprite->x < src_x || sprite->y < src_y || sprite->x + sprite->w > src_x + w || sprite->y + sprite->h > src_y + h) continue;
+                    if (count == index->scratch_capacity) {
+                        const size_t capacity = index->scratch_capacity ? index->scratch_capacity * 2 : 64;
+                        struct BoltSprite* scratch = realloc(index->scratch, capacity * sizeof(*scratch));
+                        if (!scratch) break;
+                        index->scratch = scratch;
+                        index->scratch_capacity = capacity;
+                    }
+                    index->scratch[count++] = *sprite;
+                }
+            }
+        }
+    }
+
+    struct BoltSpriteGrid* grid = _bolt_sprite_get_grid(index, dst);
+    if (!grid) return;
+    grid->version = ++index->writes;
+    _bolt_sprite_invalidate(index, grid, dst_x, dst_y, w, h);
+    for (size_t i = 0; i < count; i += 1) {
+        const struct BoltSprite* sprite = &index->scratch[i];
+        _bolt_sprite_insert(index, grid, sprite->x - src_x + dst_x, sprite->y - src_y + dst_y, sprite->w, sprite->h, sprite->hash);
+    }
+}
+
+void _bolt_sprite_index_add(struct BoltSpriteIndex* index, const struct GLTexture2D* tex, unsigned int x, unsigned int y, unsigned int w, unsigned int h, uint64_t hash) {
+    if (!tex->tiles || !w || !h || (size_t)x + w > tex->width || (size_t)y + h > tex->height) return;
+    if (_bolt_sprite_at(index, tex->id, x, y, w, h)) return;
+    struct BoltSpriteGrid* grid = _bolt_sprite_get_grid(index, tex);
+    // a texture that's never been written to isn't indexed at all, but it still needs a version once it is
+    if (grid && !grid->version) grid->version = ++index->writes;
+    if (grid) _bolt_sprite_insert(index, grid, x, y, w, h, hash);
+}
+
+void _bolt_sprite_index_invalidate(struct BoltSpriteIndex* index, unsigned int texture, unsigned int x, unsigned int y, unsigned int w, unsigned int h) {
+    struct BoltSpriteGrid* grid = _bolt_sprite_grid(index, texture);
+    if (!grid) return;
+    grid->version = ++index->writes;
+    if (w > UINT32_MAX - x) w = UINT32_MAX - x;
+    if (h > UINT32_MAX - y) h = UINT32_MAX - y;
+    _bolt_sprite_invalidate(index, grid, x, y, w, h);
+}
+
+void _bolt_sprite_index_clear(struct BoltSpriteIndex* index, unsigned int texture) {
+    const uint32_t g = _bolt_sprite_map_get(&index->by_texture, texture);
+    if (g == SPRITE_NONE) return;
+    struct BoltSpriteGrid* grid = &index->grids[g];
+    const size_t cell_count = (size_t)grid->cells_wide * grid->cells_high;
+    for (size_t i = 0; i < cell_count; i += 1) {
+        struct BoltSpriteCell* cell = &grid->cells[i];
+        while (cell->count) _bolt_sprite_remove(index, cell->sprites[cell->count - 1]);
+        free(cell->sprites);
+    }
+    free(grid->cells);
+    _bolt_sprite_map_remove(&index->by_texture, texture);
+    const size_t last = --index->grid_count;
+    if (g != last) {
+        index->grids[g] = index->grids[last];
+        _bolt_sprite_map_put(&index->by_texture, index->grids[g].texture, g);
+    }
+}
+
+void _bolt_sprite_index_free(struct BoltSpriteIndex* index) {
+    for (size_t g = 0; g < index->grid_count; g += 1) {
+        const size_t cell_count = (size_t)index->grids[g].cells_wide * index->grids[g].cells_high;
+        for (size_t i = 0; i < cell_count; i += 1) free(index->grids[g].cells[i].sprites);
+        free(index->grids[g].cells);
+    }
+    free(index->grids);
+    free(index->sprites);
+    free(index->contents);
+    free(index->by_rect.slots);
+    free(index->by_hash.slots);
+    free(index->by_texture.slots);
+    free(index->scratch);
+    free(index->pixels);
+    memset(index, 0, sizeof(*index));
+}
+
+const struct BoltSprite* _bolt_sprite_at(const struct BoltSpriteIndex* index, unsigned int texture, unsigned int x, unsigned int y, unsigned int w, unsigned int h) {
+    const uint32_t e = _bolt_sprite_map_get(&index->by_rect, _bolt_sprite_rect_key(texture, x, y, w, h));
+    if (e == SPRITE_NONE) return NULL;
+    const struct BoltSprite* sprite = &index->sprites[e];
+    // two rectangles with the same key are so unlikely that a mismatch is just treated as nothing being there
+    if (sprite->texture != texture || sprite->x != x || sprite->y != y || sprite->w != w || sprite->h != h) return NULL;
+    return sprite;
+}
+
+uint32_t _bolt_sprite_id(const struct BoltSpriteIndex* index, uint64_t hash) {
+    const uint32_t c = _bolt_sprite_map_get(&index->by_hash, hash);
+    return c == SPRITE_NONE ? 0 : c + 1;
+}
+
+const struct BoltSprite* _bolt_sprite_first(const struct BoltSpriteIndex* index, uint32_t id) {
+    if (!id || id > index->content_count || !index->contents[id - 1].hash) return NULL;
+    const uint32_t e = index->contents[id - 1].first;
+    return e == SPRITE_NONE ? NULL : &index->sprites[e];
+}
+
+const struct BoltSprite* _bolt_sprite_next(const struct BoltSpriteIndex* index, const struct BoltSprite* sprite) {
+    return sprite->next_same == SPRITE_NONE ? NULL : &index->sprites[sprite->next_same];
+}
+
+uint64_t _bolt_sprite_texture_version(const struct BoltSpriteIndex* index, unsigned int texture) {
+    const uint32_t g = _bolt_sprite_map_get(&index->by_texture, texture);
+    return g == SPRITE_NONE ? 0 : index->grids[g].version;
+}
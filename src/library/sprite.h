@@ -0,0 +1,130 @@
+#ifndef _BOLT_LIBRARY_SPRITE_H_
+#define _BOLT_LIBRARY_SPRITE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct GLTexture2D;
+
+// an index of what's been uploaded where in each texture, so that the sprite or icon at an atlas rectangle can be
+// identified without reading back any pixels. every glTexSubImage2D and glCompressedTexSubImage2D call is hashed over
+// the bytes the game uploaded, and the rectangle it covered gets that hash. rectangles that glCopyImageSubData copies
+// take the hashes of the indexed rectangles they cover in the source texture, so copies never have to hash anything.
+// each distinct hash that's in at least one rectangle gets a sprite id, so the same image has the same id wherever it's
+// uploaded, in any texture. writing to part of a texture drops every indexed rectangle that it overlaps, so the index
+// only ever describes what's actually in the texture, and once the last rectangle holding an image is dropped its id is
+// freed for reuse, so the index never holds more than the textures do. hashes are of the RGBA that reading the
+// rectangle back would give, so the same image has the same hash whatever format it was uploaded in, and whether it
+// was hashed on upload or read back later.
+// every lookup is O(1), and updates only touch the rectangles near the one being written. the index belongs to a
+// share group's worker, and must only be used on that thread.
+
+#define SPRITE_NONE UINT32_MAX
+
+struct BoltSprite {
+    uint64_t hash;
+    uint32_t id; // 0 if this entry is unused
+    unsigned int texture;
+    unsigned int x;
+    unsigned int y;
+    unsigned int w;
+    unsigned int h;
+    // other rectangles with the same id, as indices into the index's sprite array, or SPRITE_NONE
+    uint32_t prev_same;
+    uint32_t next_same;
+};
+
+// open-addressed hash table from a non-zero 64-bit key to a 32-bit value
+struct BoltSpriteMapSlot {
+    uint64_t key;
+    uint32_t value;
+};
+struct BoltSpriteMap {
+    struct BoltSpriteMapSlot* slots;
+    size_t count;
+    size_t capacity;
+};
+
+// one distinct hash, whose id is its position in the array plus 1. it's freed as soon as no rectangle holds it, at
+// which point hash is 0 and `first` chains it into the free list instead.
+struct BoltSpriteContent {
+    uint64_t hash;
+    uint32_t first; // first rectangle with this content
+};
+
+// each indexed texture is split into cells of TEXTURE_TILE_SIZE, each of which lists the rectangles that overlap it
+struct BoltSpriteCell {
+    uint32_t* sprites;
+    uint32_t count;
+    uint32_t capacity;
+};
+struct BoltSpriteGrid {
+    unsigned int texture;
+    unsigned int cells_wide;
+    unsigned int cells_high;
+    struct BoltSpriteCell* cells;
+    uint64_t version; // see _bolt_sprite_texture_version
+};
+
+struct BoltSpriteIndex {
+    struct BoltSprite* sprites;
+    size_t sprite_count;
+    size_t sprite_capacity;
+    uint32_t free_sprite; // unused entries are chained through next_same
+    struct BoltSpriteContent* contents;
+    size_t content_count;
+    size_t content_capacity;
+    uint32_t free_content;
+    struct BoltSpriteGrid* grids;
+    size_t grid_count;
+    size_t grid_capacity;
+    struct BoltSpriteMap by_rect; // hash of texture and rectangle -> sprite
+    struct BoltSpriteMap by_hash; // content hash -> content
+    struct BoltSpriteMap by_texture; // texture id -> grid
+    struct BoltSprite* scratch; // rectangles being copied
+    size_t scratch_capacity;
+    uint8_t* pixels; // uploads being converted to RGBA for hashing
+    size_t pixels_capacity;
+    uint64_t writes; // every write to any indexed texture, for versions
+};
+
+// a fast non-cryptographic hash of `rows` rows of `row_size` bytes each, `pitch` bytes apart. never returns 0.
+uint64_t _bolt_sprite_hash(const void* data, size_t row_size, size_t rows, size_t pitch, uint64_t seed);
+// the hash that the index gives a w*h rectangle of RGBA pixels, as _bolt_texture_read returns them
+uint64_t _bolt_sprite_hash_pixels(const void* pixels, unsigned int w, unsigned int h, size_t pitch);
+
+// indexes an upload of `data` to (x, y, w, h) in the texture, with the same arguments as _bolt_texture_upload
+void _bolt_sprite_index_upload(struct BoltSpriteIndex*, const struct GLTexture2D*, uint32_t format, unsigned int x, unsigned int y, unsigned int w, unsigned int h, const void* data, size_t data_pitch);
+// indexes a copy that _bolt_texture_copy has just done successfully, with the same arguments
+void _bolt_sprite_index_copy(struct BoltSpriteIndex*, const struct GLTexture2D* dst, unsigned int dst_x, unsigned int dst_y, const struct GLTexture2D* src, unsigned int src_x, unsigned int src_y, unsigned int w, unsigned int h);
+// indexes a rectangle whose hash the caller has worked out from the texture's current contents, i.e. by reading it
+// back and passing it to _bolt_sprite_hash_pixels, so that it can be looked up next time. it's dropped like any other when something's written over it, but
+// nothing it overlaps is dropped, since adding it doesn't change anything. does nothing if it's already indexed.
+void _bolt_sprite_index_add(struct BoltSpriteIndex*, const struct GLTexture2D*, unsigned int x, unsigned int y, unsigned int w, unsigned int h, uint64_t hash);
+// drops every indexed rectangle that overlaps (x, y, w, h) in a texture, because it's been written to in a way that
+// can't be indexed, e.g. by rendering to it. w and h may go past the edge of the texture.
+void _bolt_sprite_index_invalidate(struct BoltSpriteIndex*, unsigned int texture, unsigned int x, unsigned int y, unsigned int w, unsigned int h);
+// drops everything indexed in a texture, e.g. because it's been deleted or reallocated
+void _bolt_sprite_index_clear(struct BoltSpriteIndex*, unsigned int texture);
+void _bolt_sprite_index_free(struct BoltSpriteIndex*);
+
+// the sprite uploaded to exactly this rectangle, or NULL if there isn't one
+const struct BoltSprite* _bolt_sprite_at(const struct BoltSpriteIndex*, unsigned int texture, unsigned int x, unsigned int y, unsigned int w, unsigned int h);
+// the id of the sprite with this hash, or 0 if no indexed rectangle holds it. an id is only valid until the last
+// rectangle holding its sprite is written over, after which it can be given to a different sprite.
+uint32_t _bolt_sprite_id(const struct BoltSpriteIndex*, uint64_t hash);
+// every rectangle that currently holds the sprite with this id, one at a time. both return NULL after the last one.
+const struct BoltSprite* _bolt_sprite_first(const struct BoltSpriteIndex*, uint32_t id);
+const struct BoltSprite* _bolt_sprite_next(const struct BoltSpriteIndex*, const struct BoltSprite*);
+// a number that changes every time anything is written to the texture, and is 0 if nothing's indexed in it. a
+// texture never goes back to a version it's had before, so anything worked out from its contents can be cached
+// alongside its version and trusted for as long as the version's the same.
+uint64_t _bolt_sprite_texture_version(const struct BoltSpriteIndex*, unsigned int texture);
+
+// the index's hash tables, which are also used for other lookups keyed by hashes or ids. 0 marks an empty slot, so
+// it's never a key: nothing can be put with it, and looking it up always gives SPRITE_NONE.
+uint32_t _bolt_sprite_map_get(const struct BoltSpriteMap*, uint64_t key); // SPRITE_NONE if it's not there
+uint8_t _bolt_sprite_map_put(struct BoltSpriteMap*, uint64_t key, uint32_t value); // returns 0 if it couldn't allocate, or key is 0
+void _bolt_sprite_map_clear(struct BoltSpriteMap*); // empties it, without freeing anything
+
+#endif
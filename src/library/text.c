@@ -0,0 +1,338 @@
+#include "text.h"
+#include "capture.h"
+#include "gl.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// a gap between two glyphs that's wider than this fraction of the line's height is a space
+#define TEXT_SPACE_RATIO 0.25f
+#define TEXT_REPLACEMENT_CHARACTER 0xFFFD
+
+static struct BoltSpriteMap text_glyphs = {0};
+static pthread_mutex_t text_glyphs_lock = PTHREAD_MUTEX_INITIALIZER;
+// changes whenever the table does, so that engines know their cached lines might spell something different now
+static _Atomic uint64_t text_glyphs_version = 1;
+
+uint8_t _bolt_text_set_glyph(uint64_t hash, uint32_t codepoint) {
+    if (!hash || !codepoint) return 0;
+    pthread_mutex_lock(&text_glyphs_lock);
+    uint8_t ok = 1;
+    if (_bolt_sprite_map_get(&text_glyphs, hash) != codepoint) {
+        ok = _bolt_sprite_map_put(&text_glyphs, hash, codepoint);
+        atomic_fetch_add(&text_glyphs_version, 1);
+    }
+    pthread_mutex_unlock(&text_glyphs_lock);
+    return ok;
+}
+
+uint32_t _bolt_text_get_glyph(uint64_t hash) {
+    pthread_mutex_lock(&text_glyphs_lock);
+    const uint32_t codepoint = _bolt_sprite_map_get(&text_glyphs, hash);
+    pthread_mutex_unlock(&text_glyphs_lock);
+    return codepoint == SPRITE_NONE ? 0 : codepoint;
+}
+
+static uint64_t _bolt_text_hash_word(uint64_t hash, uint32_t word) {
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 29);
+}
+
+static uint32_t _bolt_text_float_bits(float f) {
+    uint32_t word;
+    memcpy(&word, &f, sizeof(word));
+    return word;
+}
+
+// everything about quad i that matters to a line starting at quad q, folded into one word. none of this depends on
+// the line's hash so far, so the quads' words can all be worked out in parallel, leaving only one step per quad that
+// has to wait for the one before.
+static uint32_t _bolt_text_quad_word(const struct BoltRenderList* frame, uint32_t q, uint32_t i) {
+    const uint64_t position = ((uint64_t)_bolt_text_float_bits(frame->screen_x[i] - frame->screen_x[q]) << 32) |
+        _bolt_text_float_bits(frame->screen_y[i] - frame->screen_y[q]);
+    const uint64_t size = ((uint64_t)_bolt_text_float_bits(frame->screen_w[i]) << 32) | _bolt_text_float_bits(frame->screen_h[i]);
+    const uint64_t word = (frame->key[i] ^ (position * 0xC2B2AE3D27D4EB4FULL)) + (size * 0x165667B19E3779F9ULL);
+    return (uint32_t)(word ^ (word >> 32));
+}
+
+static uint8_t _bolt_text_reserve(void** array, size_t* capacity, size_t count, size_t size) {
+    if (count <= *capacity) return 1;
+    size_t new_capacity = *capacity ? *capacity : 64;
+    while (new_capacity < count) new_capacity *= 2;
+    void* new_array = realloc(*array, new_capacity * size);
+    if (!new_array) return 0;
+    *array = new_array;
+    *capacity = new_capacity;
+    return 1;
+}
+
+static uint8_t _bolt_text_append(struct BoltTextFrame* text, const char* s, size_t length) {
+    if (!_bolt_text_reserve((void**)&text->text, &text->text_capacity, text->text_size + length, 1)) return 0;
+    memcpy(text->text + text->text_size, s, length);
+    text->text_size += length;
+    return 1;
+}
+
+static uint8_t _bolt_text_append_codepoint(struct BoltTextFrame* text, uint32_t c) {
+    char utf8[4];
+    if (c < 0x80) {
+        utf8[0] = (char)c;
+        return _bolt_text_append(text, utf8, 1);
+    }
+    if (c < 0x800) {
+        utf8[0] = (char)(0xC0 | (c >> 6));
+        utf8[1] = (char)(0x80 | (c & 0x3F));
+        return _bolt_text_append(text, utf8, 2);
+    }
+    if (c < 0x10000) {
+        utf8[0] = (char)(0xE0 | (c >> 12));
+        utf8[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+        utf8[2] = (char)(0x80 | (c & 0x3F));
+        return _bolt_text_append(text, utf8, 3);
+    }
+    if (c < 0x110000) {
+        utf8[0] = (char)(0xF0 | (c >> 18));
+        utf8[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+        utf8[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+        utf8[3] = (char)(0x80 | (c & 0x3F));
+        return _bolt_text_append(text, utf8, 4);
+    }
+    return _bolt_text_append_codepoint(text, TEXT_REPLACEMENT_CHARACTER);
+}
+
+static uint8_t _bolt_text_fits(const struct BoltRenderList* frame, uint32_t q) {
+    return frame->screen_w[q] > 0.0f && frame->screen_h[q] > 0.0f &&
+        frame->screen_w[q] <= TEXT_MAX_GLYPH_SIZE && frame->screen_h[q] <= TEXT_MAX_GLYPH_SIZE;
+}
+
+// whether quad b carries on a line whose last quad is a, and whose glyphs cover [top, bottom] vertically: it has to be
+// drawn the same way, overlap the line vertically, and start to the right of a, no more than a line's height after it
+static uint8_t _bolt_text_continues(const struct BoltRenderList* frame, uint32_t a, uint32_t b, float top, float bottom) {
+    if (frame->texture[b] != frame->texture[a] || frame->colour[b] != frame->colour[a] || !_bolt_text_fits(frame, b)) return 0;
+    if (frame->screen_y[b] >= bottom || frame->screen_y[b] + frame->screen_h[b] <= top) return 0;
+    const float gap = frame->screen_x[b] - (frame->screen_x[a] + frame->screen_w[a]);
+    return frame->screen_x[b] > frame->screen_x[a] && gap <= bottom - top;
+}
+
+// icons and the pieces of a border are all the same size, and text almost never is
+static uint8_t _bolt_text_looks_like_text(const struct BoltRenderList* frame, uint32_t start, uint32_t end) {
+    if (end - start < TEXT_MIN_DETECT_GLYPHS) return 0;
+    for (uint32_t q = start + 1; q < end; q += 1) {
+        if (fabsf(frame->screen_w[q] - frame->screen_w[start]) >= 1.0f) return 1;
+    }
+    return 0;
+}
+
+// the content hash of the atlas rectangle that a quad samples, from the sprite index if it's there, or else by reading
+// it back, in which case it's added to the index so that it's there next time. 0 if it can't be worked out.
+static uint64_t _bolt_text_glyph_hash(struct BoltTextEngine* engine, struct GLShareGroup* group, struct GLTexture2D* tex, const struct BoltRenderList* frame, uint32_t q) {
+    if (!tex || !tex->tiles) return 0;
+    const float x = floorf((frame->atlas_x[q] * tex->width) + 0.5f);
+    const float y = floorf((frame->atlas_y[q] * tex->height) + 0.5f);
+    const float w = floorf((frame->atlas_w[q] * tex->width) + 0.5f);
+    const float h = floorf((frame->atlas_h[q] * tex->height) + 0.5f);
+    if (x < 0.0f || y < 0.0f || w < 1.0f || h < 1.0f || x + w > tex->width || y + h > tex->height) return 0;
+    const unsigned int px = (unsigned int)x, py = (unsigned int)y, pw = (unsigned int)w, ph = (unsigned int)h;
+
+    if (group->sprites) {
+        const struct BoltSprite* sprite = _bolt_sprite_at(group->sprites, tex->id, px, py, pw, ph);
+        if (sprite) return sprite->hash;
+    }
+    const size_t pitch = (size_t)pw * 4;
+    if (!_bolt_text_reserve((void**)&engine->pixels, &engine->pixels_capacity, pitch * ph, 1)) return 0;
+    if (!_bolt_texture_read(tex, px, py, pw, ph, engine->pixels, pitch)) return 0;
+    const uint64_t hash = _bolt_sprite_hash_pixels(engine->pixels, pw, ph, pitch);
+    if (group->sprites) _bolt_sprite_index_add(group->sprites, tex, px, py, pw, ph, hash);
+    return hash;
+}
+
+// copies a line that was drawn exactly the same way last frame, except maybe somewhere else
+static void _bolt_text_copy_line(struct BoltTextFrame* text, const struct BoltTextFrame* previous, const struct BoltTextLine* line, float x, float y) {
+    const struct BoltTextGlyph* glyphs = previous->glyphs + line->first_glyph;
+    const float dx = x - (line->x + glyphs[0].x);
+    const float dy = y - (line->y + glyphs[0].y);
+    const char* s = previous->text + line->text;
+    const size_t length = strlen(s) + 1;
+    if (!_bolt_text_reserve((void**)&text->lines, &text->line_capacity, (size_t)text->line_count + 1, sizeof(*text->lines))) return;
+    if (!_bolt_text_reserve((void**)&text->glyphs, &text->glyph_capacity, (size_t)text->glyph_count + line->glyph_count, sizeof(*text->glyphs))) return;
+    struct BoltTextLine* copy = &text->lines[text->line_count];
+    *copy = *line;
+    copy->x += dx;
+    copy->y += dy;
+    copy->first_glyph = text->glyph_count;
+    copy->text = text->text_size;
+    if (!_bolt_text_append(text, s, length)) return;
+    memcpy(text->glyphs + text->glyph_count, glyphs, line->glyph_count * sizeof(*glyphs));
+    text->glyph_count += line->glyph_count;
+    text->line_count += 1;
+    text->reused += 1;
+}
+
+// looks up every glyph in the line's quads, which are [start, end) in the frame
+static void _bolt_text_resolve_line(struct BoltTextEngine* engine, struct GLShareGroup* group, struct BoltTextFrame* text, const struct BoltRenderList* frame, uint32_t start, uint32_t end, uint64_t hash, uint32_t texture_generation) {
+    const uint32_t count = end - start;
+    if (!_bolt_text_reserve((void**)&text->lines, &text->line_capacity, (size_t)text->line_count + 1, sizeof(*text->lines))) return;
+    if (!_bolt_text_reserve((void**)&text->glyphs, &text->glyph_capacity, (size_t)text->glyph_count + count, sizeof(*text->glyphs))) return;
+    const unsigned int texture = frame->texture[start];
+    // a shadow that isn't current might not hold what the game drew with, so its glyphs aren't looked up at all
+    struct GLTexture2D* tex = _bolt_find_current_texture(&group->textures, texture, texture_generation);
+
+    float x0 = frame->screen_x[start], y0 = frame->screen_y[start];
+    float x1 = x0 + frame->screen_w[start], y1 = y0 + frame->screen_h[start];
+    for (uint32_t q = start + 1; q < end; q += 1) {
+        if (frame->screen_x[q] < x0) x0 = frame->screen_x[q];
+        if (frame->screen_y[q] < y0) y0 = frame->screen_y[q];
+        if (frame->screen_x[q] + frame->screen_w[q] > x1) x1 = frame->screen_x[q] + frame->screen_w[q];
+        if (frame->screen_y[q] + frame->screen_h[q] > y1) y1 = frame->screen_y[q] + frame->screen_h[q];
+    }
+
+    const size_t text_start = text->text_size;
+    for (uint32_t q = start; q < end; q += 1) {
+        const uint64_t glyph_hash = _bolt_text_glyph_hash(engine, group, tex, frame, q);
+        const uint32_t codepoint = glyph_hash ? _bolt_text_get_glyph(glyph_hash) : 0;
+        text->glyphs[text->glyph_count + (q - start)] = (struct BoltTextGlyph){
+            .hash = glyph_hash, .codepoint = codepoint, .x = frame->screen_x[q] - x0, .y = frame->screen_y[q] - y0, .w = frame->screen_w[q], .h = frame->screen_h[q],
+        };
+        uint8_t ok = 1;
+        if (q > start && frame->screen_x[q] - (frame->screen_x[q - 1] + frame->screen_w[q - 1]) > (y1 - y0) * TEXT_SPACE_RATIO) {
+            ok = _bolt_text_append(text, " ", 1);
+        }
+        if (!ok || !_bolt_text_append_codepoint(text, codepoint ? codepoint : TEXT_REPLACEMENT_CHARACTER)) {
+            text->text_size = text_start;
+            return;
+        }
+    }
+    if (!_bolt_text_append(text, "", 1)) {
+        text->text_size = text_start;
+        return;
+    }
+
+    // reading glyphs back can give the atlas its first version, so this has to come after looking them up
+    const uint64_t version = group->sprites ? _bolt_sprite_texture_version(group->sprites, texture) : 0;
+    text->lines[text->line_count++] = (struct BoltTextLine){
+        .x = x0, .y = y0, .w = x1 - x0, .h = y1 - y0, .colour = frame->colour[start], .texture = texture,
+        .first_glyph = text->glyph_count, .glyph_count = count, .text = text_start, .hash = hash, .version = version,
+    };
+    text->glyph_count += count;
+}
+
+// whether every line is still spelled with what's in its atlas now
+static uint8_t _bolt_text_atlases_unchanged(struct GLShareGroup* group, const struct BoltTextFrame* text) {
+    unsigned int texture = 0;
+    uint64_t version = 0;
+    for (uint32_t i = 0; i < text->line_count; i += 1) {
+        const struct BoltTextLine* line = &text->lines[i];
+        if (i == 0 || line->texture != texture) {
+            texture = line->texture;
+            version = group->sprites ? _bolt_sprite_texture_version(group->sprites, texture) : 0;
+        }
+        if (line->version != version) return 0;
+    }
+    return 1;
+}
+
+const struct BoltTextFrame* _bolt_text_update(struct BoltTextEngine* engine, struct GLShareGroup* group, const struct BoltRenderList* frame, const struct BoltRenderDelta* delta, uint32_t texture_generation) {
+    const uint64_t glyphs_version = atomic_load(&text_glyphs_version);
+    // atlas versions only change when the textures set sees a write, so nothing can be reused across it being toggled
+    const uint8_t can_reuse = engine->valid && engine->glyphs_version == glyphs_version && engine->texture_generation == texture_generation;
+    struct BoltTextFrame* previous = &engine->frames[engine->current];
+    if (can_reuse && delta && !delta->added_count && !delta->removed_count && !delta->moved_count && _bolt_text_atlases_unchanged(group, previous)) {
+        previous->changed = 0;
+        previous->reused = previous->line_count;
+        return previous;
+    }
+
+    struct BoltTextFrame* text = &engine->frames[!engine->current];
+    struct BoltSpriteMap* runs = &engine->runs[!engine->current];
+    const struct BoltSpriteMap* previous_runs = &engine->runs[engine->current];
+    text->line_count = 0;
+    text->glyph_count = 0;
+    text->text_size = 0;
+    text->reused = 0;
+    text->changed = 1;
+    _bolt_sprite_map_clear(runs);
+
+    unsigned int texture = 0;
+    uint8_t is_font = 0;
+    uint32_t q = 0;
+    while (q < frame->count) {
+        if (!_bolt_text_fits(frame, q)) {
+            q += 1;
+            continue;
+        }
+        uint32_t end = q + 1;
+        float top = frame->screen_y[q];
+        float bottom = top + frame->screen_h[q];
+        while (end < frame->count && _bolt_text_continues(frame, end - 1, end, top, bottom)) {
+            if (frame->screen_y[end] < top) top = frame->screen_y[end];
+            if (frame->screen_y[end] + frame->screen_h[end] > bottom) bottom = frame->screen_y[end] + frame->screen_h[end];
+            end += 1;
+        }
+
+        // runs are usually drawn from the same texture as the one before, so the last lookup is remembered
+        if (frame->texture[q] != texture || q == 0) {
+            texture = frame->texture[q];
+            is_font = _bolt_sprite_map_get(&engine->fonts, texture) != SPRITE_NONE;
+        }
+        if (!is_font && _bolt_text_looks_like_text(frame, q, end)) is_font = _bolt_sprite_map_put(&engine->fonts, texture, 1);
+        if (is_font) {
+            uint64_t hash = _bolt_text_hash_word(_bolt_text_hash_word(texture, frame->colour[q]), end - q);
+            for (uint32_t i = q; i < end; i += 1) hash = _bolt_text_hash_word(hash, _bolt_text_quad_word(frame, q, i));
+            if (!hash) hash = 1;
+            const uint32_t line = can_reuse ? _bolt_sprite_map_get(previous_runs, hash) : SPRITE_NONE;
+            const uint64_t version = group->sprites ? _bolt_sprite_texture_version(group->sprites, texture) : 0;
+            const uint32_t line_count = text->line_count;
+            if (line != SPRITE_NONE && previous->lines[line].version == version) {
+                _bolt_text_copy_line(text, previous, &previous->lines[line], frame->screen_x[q], frame->screen_y[q]);
+            } else {
+                _bolt_text_resolve_line(engine, group, text, frame, q, end, hash, texture_generation);
+            }
+            if (text->line_count != line_count) _bolt_sprite_map_put(runs, hash, line_count);
+        }
+        q = end;
+    }
+
+    engine->current = !engine->current;
+    engine->valid = 1;
+    engine->glyphs_version = glyphs_version;
+    engine->texture_generation = texture_generation;
+    return text;
+}
+
+void _bolt_text_engine_free(struct BoltTextEngine* engine) {
+    for (size_t i = 0; i < 2; i += 1) {
+        free(engine->frames[i].lines);
+        free(engine->frames[i].glyphs);
+        free(engine->frames[i].text);
+        free(engine->runs[i].slots);
+    }
+    free(engine->fonts.slots);
+    free(engine->pixels);
+    memset(engine, 0, sizeof(*engine));
+}
+
+static struct BoltSubscriberList text_subscribers = BOLT_SUBSCRIBER_LIST_INIT;
+
+uint32_t _bolt_text_subscribe(BoltTextCallback callback, void* userdata) {
+    return _bolt_subscriber_add(&text_subscribers, (void (*)(void))callback, userdata);
+}
+
+void _bolt_text_unsubscribe(uint32_t id) {
+    _bolt_subscriber_remove(&text_subscribers, id);
+}
+
+uint8_t _bolt_text_has_subscribers() {
+    return _bolt_subscriber_any(&text_subscribers);
+}
+
+void _bolt_text_publish(struct GLShareGroup* group, const struct BoltTextFrame* text) {
+    pthread_mutex_lock(&text_subscribers.lock);
+    for (size_t i = 0; i < text_subscribers.count; i += 1) {
+        const struct BoltSubscriber* subscriber = &text_subscribers.subscribers[i];
+        ((BoltTextCallback)subscriber->callback)(group, text, subscriber->userdata);
+    }
+    pthread_mutex_unlock(&text_subscribers.lock);
+}
@@ -0,0 +1,102 @@
+#ifndef _BOLT_LIBRARY_TEXT_H_
+#define _BOLT_LIBRARY_TEXT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sprite.h"
+
+struct GLShareGroup;
+struct BoltRenderList;
+struct BoltRenderDelta;
+
+// reads the text in the game's interface straight out of a frame's render list, without any OCR. text is drawn as
+// one quad per glyph, sampled from a font atlas, so a line of text is a run of quads drawn one after another from the
+// same texture in the same colour, each one a little to the right of the last.
+// a texture is taken to be a font atlas the first time a run of at least TEXT_MIN_DETECT_GLYPHS small quads with
+// different widths is drawn from it, which rows of icons (which are all the same size) never are. after that, every
+// run drawn from it is text, however short.
+// each glyph is identified by the content hash of its atlas rectangle, from the texture's sprite index. rectangles
+// that weren't uploaded on their own (e.g. because the whole atlas was uploaded at once) are read back from the
+// texture's shadow and hashed the first time they're seen, and then indexed, so that's only ever done once. what
+// character each hash is comes from the glyph table, which is shared by every share group and filled in with
+// _bolt_text_set_glyph; glyphs it doesn't know yet come out as U+FFFD.
+// each line is cached against the hash of its quads and the version of its atlas, and a line that's drawn again
+// unchanged (or just moved) is copied from the previous frame rather than looked up again, so only the lines whose
+// draws changed cost anything. a frame whose delta is empty costs next to nothing.
+
+#define TEXT_MIN_DETECT_GLYPHS 4
+#define TEXT_MAX_GLYPH_SIZE 64 // screen pixels, in either direction. anything bigger is never part of a line.
+
+struct BoltTextGlyph {
+    uint64_t hash; // content hash of the glyph's atlas rectangle, or 0 if it couldn't be read
+    uint32_t codepoint; // 0 if the glyph table doesn't know this hash
+    // relative to the line's position, so that a line can move without its glyphs changing
+    float x;
+    float y;
+    float w;
+    float h;
+};
+
+struct BoltTextLine {
+    // bounding box of the line's glyphs, in the same space as the render list's screen rectangles
+    float x;
+    float y;
+    float w;
+    float h;
+    uint32_t colour; // RGBA8, with red in the lowest byte, same as the render list
+    unsigned int texture; // the font atlas
+    uint32_t first_glyph; // index into the frame's glyphs
+    uint32_t glyph_count;
+    size_t text; // offset of the line's nul-terminated UTF-8 in the frame's text, with spaces between words
+    uint64_t hash; // of the line's quads, relative to the first one
+    uint64_t version; // the atlas's version when the line's glyphs were looked up
+};
+
+struct BoltTextFrame {
+    struct BoltTextLine* lines;
+    uint32_t line_count;
+    size_t line_capacity;
+    struct BoltTextGlyph* glyphs;
+    uint32_t glyph_count;
+    size_t glyph_capacity;
+    char* text;
+    size_t text_size;
+    size_t text_capacity;
+    uint8_t changed; // 0 if this is known to be exactly the same as the previous frame's text
+    uint32_t reused; // lines that were copied from the previous frame rather than looked up
+};
+
+struct BoltTextEngine {
+    // the last frame's text and the one being built, alternately
+    struct BoltTextFrame frames[2];
+    struct BoltSpriteMap runs[2]; // each frame's line hashes -> lines
+    uint8_t current;
+    uint8_t valid; // frames[current] is the text of the last frame passed to _bolt_text_update
+    uint64_t glyphs_version; // glyph table version that frames[current] was made with
+    uint32_t texture_generation; // and the textures set's generation
+    struct BoltSpriteMap fonts; // texture id -> 1, for every texture known to be a font atlas
+    uint8_t* pixels; // scratch space for reading glyphs back
+    size_t pixels_capacity;
+};
+
+// works out the text in a frame, given the delta from the previous frame that was passed to this, which may be NULL
+// if there isn't one. the result belongs to the engine and is valid until the next call. must be called on the
+// group's worker, since it looks up the group's textures and sprite index. texture_generation is the textures hook
+// set's generation, and glyphs are only read back from shadows made in it, see _bolt_find_current_texture.
+const struct BoltTextFrame* _bolt_text_update(struct BoltTextEngine*, struct GLShareGroup*, const struct BoltRenderList* frame, const struct BoltRenderDelta*, uint32_t texture_generation);
+void _bolt_text_engine_free(struct BoltTextEngine*);
+
+// the glyph table: which character a glyph with a given content hash is. can be called from any thread.
+uint8_t _bolt_text_set_glyph(uint64_t hash, uint32_t codepoint);
+uint32_t _bolt_text_get_glyph(uint64_t hash); // 0 if it's not known
+
+// consumers that want the interface's text subscribe to it, the same way as to render deltas, see capture.h. callbacks
+// are called on the share group's worker once per frame, and the frame they're given may not be kept after returning.
+typedef void (*BoltTextCallback)(struct GLShareGroup*, const struct BoltTextFrame*, void* userdata);
+uint32_t _bolt_text_subscribe(BoltTextCallback, void* userdata);
+void _bolt_text_unsubscribe(uint32_t id);
+uint8_t _bolt_text_has_subscribers();
+void _bolt_text_publish(struct GLShareGroup*, const struct BoltTextFrame*);
+
+#endif
@@ -0,0 +1,63 @@
+// _bolt_attr_decode on a batch of indexed vertices vs decoding the same vertices one call at a time, which is what the
+// per-vertex getters did before batching, for every type, component count and normalisation. the buffer is
+// interleaved with a 32-byte stride, like the game's vertex buffers. built twice, like attr_test, so that attr_bench
+// and attr_bench_scalar show what the SSE2 kernels are worth. usage: attr_bench [repeats per case]
+#include "attr.h"
+#include "gl.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+#define VERTICES 4096
+#define BATCH 4096
+#define STRIDE 32
+
+static volatile float sink;
+
+int main(int argc, char** argv) {
+    const size_t repeats = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+    const struct { const char* name; uint32_t gl; } types[] = {
+        {"float", GL_FLOAT}, {"ubyte", GL_UNSIGNED_BYTE}, {"byte", GL_BYTE}, {"ushort", GL_UNSIGNED_SHORT},
+        {"short", GL_SHORT}, {"uint", GL_UNSIGNED_INT}, {"int", GL_INT},
+    };
+    uint8_t* data = malloc((size_t)VERTICES * STRIDE);
+    // small byte values keep every float finite and normal
+    for (size_t i = 0; i < (size_t)VERTICES * STRIDE; i += 1) data[i] = (uint8_t)(test_rand() & 0x3F);
+    uint16_t* indices = malloc(BATCH * sizeof(*indices));
+    for (size_t i = 0; i < BATCH; i += 1) indices[i] = (uint16_t)(test_rand() % VERTICES);
+    float* out = malloc(BATCH * 4 * sizeof(*out));
+
+    printf("%i indexed vertices, %zu repeats, ns per vertex\n", BATCH, repeats);
+    for (size_t t = 0; t < sizeof(types) / sizeof(*types); t += 1) {
+        for (int size = 1; size <= 4; size += 1) {
+            for (uint8_t normalise = 0; normalise < 2; normalise += 1) {
+                if (types[t].gl == GL_FLOAT && normalise) continue;
+                struct GLAttrBinding binding = {0};
+                binding.size = size;
+                binding.type = types[t].gl;
+                binding.normalise = normalise;
+                binding.stride = STRIDE;
+                binding.offset = 4;
+                _bolt_attr_resolve(&binding);
+
+                uint64_t start = test_now_ns();
+                for (size_t r = 0; r < repeats; r += 1) {
+                    _bolt_attr_decode(&binding, data, (size_t)VERTICES * STRIDE, indices, 0, BATCH, (size_t)size, out);
+                    sink += out[r % BATCH];
+                }
+                const double batched = (double)(test_now_ns() - start) / ((double)repeats * BATCH);
+                start = test_now_ns();
+                for (size_t r = 0; r < repeats; r += 1) {
+                    for (size_t i = 0; i < BATCH; i += 1) _bolt_attr_decode(&binding, data, (size_t)VERTICES * STRIDE, NULL, indices[i], 1, (size_t)size, out + (i * size));
+                    sink += out[r % BATCH];
+                }
+                const double single = (double)(test_now_ns() - start) / ((double)repeats * BATCH);
+                printf("%-6s x%i %-5s batched %6.2f | per vertex %6.2f\n", types[t].name, size, normalise ? "norm" : "", batched, single);
+            }
+        }
+    }
+    free(data);
+    free(indices);
+    free(out);
+    return 0;
+}
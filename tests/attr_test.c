@@ -0,0 +1,147 @@
+#include "attr.h"
+#include "gl.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// this is built twice, once as attr_test with whatever SIMD the build has, and once as attr_test_scalar with attr.c's
+// SSE2 kernels turned off. both check every kernel bit-for-bit against the same reference, so they're equivalent.
+
+struct Type {
+    uint32_t gl;
+    size_t size;
+    uint8_t is_signed;
+    uint8_t is_float;
+};
+static const struct Type types[] = {
+    {GL_FLOAT, 4, 1, 1}, {GL_UNSIGNED_BYTE, 1, 0, 0}, {GL_BYTE, 1, 1, 0}, {GL_UNSIGNED_SHORT, 2, 0, 0},
+    {GL_SHORT, 2, 1, 0}, {GL_UNSIGNED_INT, 4, 0, 0}, {GL_INT, 4, 1, 0},
+};
+
+// one component, as GL would read it, in the pre-4.2 normalisation that attr.c documents
+static float reference_component(const struct Type* type, const uint8_t* src, uint8_t normalise) {
+    float v;
+    if (type->is_float) {
+        memcpy(&v, src, 4);
+        return v;
+    }
+    int64_t raw = 0;
+    if (type->size == 1) raw = type->is_signed ? (int64_t)(int8_t)src[0] : (int64_t)src[0];
+    if (type->size == 2) {
+        uint16_t u;
+        memcpy(&u, src, 2);
+        raw = type->is_signed ? (int64_t)(int16_t)u : (int64_t)u;
+    }
+    if (type->size == 4) {
+        uint32_t u;
+        memcpy(&u, src, 4);
+        raw = type->is_signed ? (int64_t)(int32_t)u : (int64_t)u;
+    }
+    v = (float)raw;
+    if (!normalise) return v;
+    const float max = (float)((UINT64_C(1) << (type->size * 8)) - 1);
+    if (!type->is_signed) return v * (1.0f / max);
+    return (v * (2.0f / max)) + (1.0f / max);
+}
+
+// random bytes, except that floats are kept finite, since NaN payloads aren't something either version tries to keep
+static void fill(uint8_t* data, size_t data_size, const struct GLAttrBinding* binding, size_t highest, size_t num_out) {
+    for (size_t i = 0; i < data_size; i += 1) data[i] = (uint8_t)test_rand();
+    if (binding->type != GL_FLOAT) return;
+    for (size_t vertex = 0; vertex <= highest; vertex += 1) {
+        for (size_t j = 0; j < num_out; j += 1) {
+            const float v = ((float)(int32_t)test_rand() / 65536.0f) * (float)(1 << (test_rand() % 16));
+            memcpy(data + binding->offset + (vertex * binding->fetch_stride) + (j * 4), &v, sizeof(v));
+        }
+    }
+}
+
+static void test_kernels() {
+    for (size_t t = 0; t < sizeof(types) / sizeof(*types); t += 1) {
+        const struct Type* type = &types[t];
+        for (int size = 1; size <= 4; size += 1) {
+            for (size_t num_out = 1; num_out <= (size_t)size; num_out += 1) {
+                for (int iteration = 0; iteration < 64; iteration += 1) {
+                    struct GLAttrBinding binding = {0};
+                    binding.size = size;
+                    binding.type = type->gl;
+                    binding.normalise = (uint8_t)(iteration & 1);
+                    // tightly packed, or interleaved with other attributes at any byte alignment
+                    binding.stride = (iteration & 2) ? 0 : (unsigned int)((size * type->size) + (test_rand() % 13));
+                    binding.offset = test_rand() % 7;
+                    _bolt_attr_resolve(&binding);
+                    CHECK(binding.kind);
+                    const size_t count = 1 + (test_rand() % 37);
+                    const size_t vertices = 1 + (test_rand() % 64);
+                    uint16_t indices[64];
+                    for (size_t i = 0; i < count; i += 1) indices[i] = (uint16_t)(test_rand() % vertices);
+                    const size_t first = (iteration & 4) ? test_rand() % 8 : 0;
+                    const uint8_t indexed = (iteration & 8) != 0;
+                    size_t highest = first + count - 1;
+                    if (indexed) {
+                        highest = 0;
+                        for (size_t i = 0; i < count; i += 1) if (indices[i] > highest) highest = indices[i];
+                    }
+                    const size_t data_size = binding.offset + (highest * binding.fetch_stride) + (num_out * type->size);
+                    uint8_t* data = malloc(data_size);
+                    fill(data, data_size, &binding, highest, num_out);
+
+                    float out[64 * 4 + 1];
+                    out[count * num_out] = 12345.0f;
+                    CHECK(_bolt_attr_decode(&binding, data, data_size, indexed ? indices : NULL, first, count, num_out, out));
+                    CHECK(out[count * num_out] == 12345.0f);
+                    size_t bad = 0;
+                    for (size_t i = 0; i < count; i += 1) {
+                        const size_t vertex = indexed ? indices[i] : first + i;
+                        for (size_t j = 0; j < num_out; j += 1) {
+                            const uint8_t* src = data + binding.offset + (vertex * binding.fetch_stride) + (j * type->size);
+                            const float expected = reference_component(type, src, binding.normalise);
+                            if (memcmp(&expected, &out[(i * num_out) + j], sizeof(float))) bad += 1;
+                        }
+                    }
+                    if (bad) printf("type 0x%X, size %i, %zu out, normalise %i: %zu bad components\n", (unsigned int)type->gl, size, num_out, binding.normalise, bad);
+                    CHECK(bad == 0);
+
+                    // one byte short of the highest vertex is rejected without writing anything
+                    out[0] = 12345.0f;
+                    CHECK(!_bolt_attr_decode(&binding, data, data_size - 1, indexed ? indices : NULL, first, count, num_out, out));
+                    CHECK(out[0] == 12345.0f);
+                    free(data);
+                }
+            }
+        }
+    }
+}
+
+static void test_index_range() {
+    for (int iteration = 0; iteration < 500; iteration += 1) {
+        uint16_t indices[100];
+        const size_t count = 1 + (test_rand() % 100);
+        for (size_t i = 0; i < count; i += 1) indices[i] = (uint16_t)((iteration & 1) ? test_rand() : test_rand() % 50);
+        uint16_t min = 0xFFFF, max = 0;
+        for (size_t i = 0; i < count; i += 1) {
+            if (indices[i] < min) min = indices[i];
+            if (indices[i] > max) max = indices[i];
+        }
+        uint16_t got_min, got_max;
+        _bolt_index_range(indices, count, &got_min, &got_max);
+        CHECK(got_min == min && got_max == max);
+    }
+}
+
+static void test_unsupported() {
+    struct GLAttrBinding binding = {.size = 2, .type = 0x140B}; // GL_HALF_FLOAT
+    _bolt_attr_resolve(&binding);
+    float out[2];
+    const uint8_t data[4] = {0};
+    CHECK(!binding.kind);
+    CHECK(!_bolt_attr_decode(&binding, data, sizeof(data), NULL, 0, 1, 2, out));
+}
+
+int main() {
+    test_kernels();
+    test_index_range();
+    test_unsupported();
+    return TEST_RESULT();
+}
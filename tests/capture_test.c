@@ -0,0 +1,275 @@
+#include "capture.h"
+#include "gl.h"
+#include "test.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Quad {
+    unsigned int texture;
+    uint32_t colour;
+    float atlas_x;
+    float x;
+    float y;
+};
+
+static void put(struct BoltRenderList* list, struct Quad q) {
+    const uint32_t i = list->count++;
+    list->texture[i] = q.texture;
+    list->colour[i] = q.colour;
+    list->atlas_x[i] = q.atlas_x;
+    list->atlas_y[i] = 0.0f;
+    list->atlas_w[i] = list->atlas_h[i] = 0.05f;
+    list->screen_x[i] = q.x;
+    list->screen_y[i] = q.y;
+    list->screen_w[i] = list->screen_h[i] = 8.0f;
+    list->key[i] = ((uint64_t)q.texture * 1000003u) ^ ((uint64_t)q.colour * 7919u) ^ ((uint64_t)(q.atlas_x * 1000.0f) * 13u);
+}
+
+static struct Quad get(const struct BoltRenderList* list, uint32_t i) {
+    return (struct Quad){.texture = list->texture[i], .colour = list->colour[i], .atlas_x = list->atlas_x[i], .x = list->screen_x[i], .y = list->screen_y[i]};
+}
+
+static int same_key(struct Quad a, struct Quad b) {
+    return a.texture == b.texture && a.colour == b.colour && a.atlas_x == b.atlas_x;
+}
+
+static int same_quad(struct Quad a, struct Quad b) {
+    return same_key(a, b) && a.x == b.x && a.y == b.y;
+}
+
+static struct Quad random_quad() {
+    return (struct Quad){.texture = test_rand() % 5, .colour = 0xFFFFFFFF, .atlas_x = (test_rand() % 20) / 20.0f, .x = test_rand() % 50, .y = test_rand() % 50};
+}
+
+// lists are filled in directly rather than captured, so they need all their arrays
+static void alloc_list(struct BoltRenderList* list, uint32_t capacity) {
+    memset(list, 0, sizeof(*list));
+    list->capacity = capacity;
+    list->key = calloc(capacity ? capacity : 1, sizeof(*list->key));
+    list->texture = calloc(capacity ? capacity : 1, sizeof(*list->texture));
+    list->colour = calloc(capacity ? capacity : 1, sizeof(*list->colour));
+    float** floats[] = {&list->screen_x, &list->screen_y, &list->screen_w, &list->screen_h, &list->atlas_x, &list->atlas_y, &list->atlas_w, &list->atlas_h};
+    for (size_t i = 0; i < sizeof(floats) / sizeof(*floats); i += 1) *floats[i] = calloc(capacity ? capacity : 1, sizeof(float));
+}
+
+static void free_list(struct BoltRenderList* list) {
+    float* floats[] = {list->screen_x, list->screen_y, list->screen_w, list->screen_h, list->atlas_x, list->atlas_y, list->atlas_w, list->atlas_h};
+    for (size_t i = 0; i < sizeof(floats) / sizeof(*floats); i += 1) free(floats[i]);
+    free(list->texture);
+    free(list->colour);
+    free(list->key);
+    memset(list, 0, sizeof(*list));
+}
+
+// the delta has to account for every quad in both frames exactly once
+static void check_delta(const struct BoltRenderList* previous, const struct BoltRenderList* frame, const struct BoltRenderDelta* delta) {
+    CHECK(delta->unchanged_count + delta->moved_count + delta->removed_count == previous->count);
+    CHECK(delta->unchanged_count + delta->moved_count + delta->added_count == frame->count);
+    uint8_t* used_previous = calloc(previous->count + 1, 1);
+    uint8_t* used_frame = calloc(frame->count + 1, 1);
+    for (uint32_t k = 0; k < delta->removed_count; k += 1) used_previous[delta->removed[k]] += 1;
+    for (uint32_t k = 0; k < delta->added_count; k += 1) used_frame[delta->added[k]] += 1;
+    for (uint32_t k = 0; k < delta->moved_count; k += 1) {
+        used_previous[delta->moved[k].from] += 1;
+        used_frame[delta->moved[k].to] += 1;
+        const struct Quad from = get(previous, delta->moved[k].from);
+        const struct Quad to = get(frame, delta->moved[k].to);
+        CHECK(same_key(from, to) && !same_quad(from, to));
+    }
+    for (uint32_t i = 0; i < previous->count; i += 1) CHECK(used_previous[i] <= 1);
+    for (uint32_t i = 0; i < frame->count; i += 1) CHECK(used_frame[i] <= 1);
+    free(used_previous);
+    free(used_frame);
+}
+
+static void test_empty_diffs() {
+    struct BoltRenderList empty, full;
+    alloc_list(&empty, 0);
+    alloc_list(&full, 100);
+    for (uint32_t i = 0; i < 100; i += 1) put(&full, random_quad());
+
+    // a fresh delta has no scratch space yet, which is what the worker has on its first frame
+    struct BoltRenderDelta delta = {0};
+    CHECK(_bolt_render_list_diff(&empty, &empty, &delta));
+    CHECK(!delta.added_count && !delta.removed_count && !delta.moved_count && !delta.unchanged_count);
+    _bolt_render_delta_free(&delta);
+
+    CHECK(_bolt_render_list_diff(&empty, &full, &delta));
+    CHECK(delta.added_count == 100 && !delta.removed_count && !delta.moved_count && !delta.unchanged_count);
+    check_delta(&empty, &full, &delta);
+    _bolt_render_delta_free(&delta);
+
+    CHECK(_bolt_render_list_diff(&full, &empty, &delta));
+    CHECK(!delta.added_count && delta.removed_count == 100 && !delta.moved_count && !delta.unchanged_count);
+    check_delta(&full, &empty, &delta);
+    CHECK(_bolt_render_list_diff(&empty, &empty, &delta));
+    CHECK(!delta.added_count && !delta.removed_count);
+    _bolt_render_delta_free(&delta);
+
+    free_list(&empty);
+    free_list(&full);
+}
+
+// random edits of a random frame, checked against a brute-force matching
+static void test_random_diffs() {
+    struct BoltRenderDelta delta = {0};
+    for (int round = 0; round < 100; round += 1) {
+        const uint32_t n = 1 + (test_rand() % 2000);
+        struct BoltRenderList previous, frame;
+        alloc_list(&previous, n);
+        alloc_list(&frame, (n * 2) + 1);
+        for (uint32_t i = 0; i < n; i += 1) put(&previous, random_quad());
+        for (uint32_t i = 0; i < n; i += 1) {
+            const uint32_t r = test_rand() % 20;
+            struct Quad q = get(&previous, i);
+            if (r == 0) continue;
+            if (r == 1) q.x += 1.0f;
+            if (r == 2) put(&frame, random_quad());
+            put(&frame, q);
+        }
+        CHECK(_bolt_render_list_diff(&previous, &frame, &delta));
+        check_delta(&previous, &frame, &delta);
+
+        // the largest possible set of unchanged quads is the multiset intersection of the two frames
+        uint8_t* matched = calloc(previous.count, 1);
+        uint32_t unchanged = 0;
+        for (uint32_t j = 0; j < frame.count; j += 1) {
+            for (uint32_t i = 0; i < previous.count; i += 1) {
+                if (matched[i] || !same_quad(get(&previous, i), get(&frame, j))) continue;
+                matched[i] = 1;
+                unchanged += 1;
+                break;
+            }
+        }
+        CHECK(unchanged == delta.unchanged_count);
+        // and nothing that was removed could have been matched up with something that was added
+        for (uint32_t x = 0; x < delta.removed_count && x < 50; x += 1) {
+            for (uint32_t y = 0; y < delta.added_count; y += 1) CHECK(!same_key(get(&previous, delta.removed[x]), get(&frame, delta.added[y])));
+        }
+        free(matched);
+        free_list(&previous);
+        free_list(&frame);
+        if (test_failures > 10) break;
+    }
+    _bolt_render_delta_free(&delta);
+}
+
+struct Vertex {
+    float x;
+    float y;
+    uint8_t rgba[4];
+    float atlas_min[2];
+    float atlas_extents[2];
+};
+
+// a draw of `quads` quads laid out on a grid, interleaved in one buffer, with the indices in another at an offset of 2
+static void make_draw(struct GLShareGroup* group, uint32_t quads, struct GLDrawSnapshot* draw) {
+    struct Vertex* vertices = calloc((size_t)quads * 4, sizeof(*vertices));
+    uint16_t* indices = calloc(((size_t)quads * 6) + 1, sizeof(*indices));
+    for (uint32_t q = 0; q < quads; q += 1) {
+        const float x = (q % 100) * 10.0f;
+        const float y = (q / 100) * 10.0f;
+        const float xs[4] = {x, x + 8, x + 8, x};
+        const float ys[4] = {y, y, y + 6, y + 6};
+        for (uint32_t v = 0; v < 4; v += 1) {
+            struct Vertex* p = &vertices[(q * 4) + v];
+            p->x = xs[v];
+            p->y = ys[v];
+            p->rgba[0] = 255;
+            p->rgba[1] = q & 255;
+            p->rgba[3] = 128;
+            p->atlas_min[0] = 0.25f;
+            p->atlas_min[1] = 0.5f;
+            p->atlas_extents[0] = 0.125f;
+            p->atlas_extents[1] = 0.0625f;
+        }
+        const uint16_t b = (uint16_t)(q * 4);
+        const uint16_t quad[6] = {b, b + 1, b + 2, b + 2, b + 3, b};
+        memcpy(indices + 1 + (q * 6), quad, sizeof(quad));
+    }
+    struct GLArrayBuffer* vb = _bolt_get_buffer(&group->buffers, 1);
+    vb->data = vertices;
+    vb->capacity = (size_t)quads * 4 * sizeof(*vertices);
+    vb->generation = 1;
+    struct GLArrayBuffer* eb = _bolt_get_buffer(&group->buffers, 2);
+    eb->data = indices;
+    eb->capacity = (((size_t)quads * 6) + 1) * sizeof(*indices);
+    eb->generation = 1;
+
+    memset(draw, 0, sizeof(*draw));
+    *draw = (struct GLDrawSnapshot){.program = 1, .texture = 42, .element_buffer = 2, .indices = 2, .count = quads * 6};
+    struct GLVertexFetcher* a = &draw->attributes;
+    _bolt_set_attr_binding(&a->aVertexPosition2D, 1, 2, (void*)offsetof(struct Vertex, x), sizeof(struct Vertex), GL_FLOAT, 0);
+    _bolt_set_attr_binding(&a->aVertexColour, 1, 4, (void*)offsetof(struct Vertex, rgba), sizeof(struct Vertex), GL_UNSIGNED_BYTE, 1);
+    _bolt_set_attr_binding(&a->aTextureUVAtlasMin, 1, 2, (void*)offsetof(struct Vertex, atlas_min), sizeof(struct Vertex), GL_FLOAT, 0);
+    _bolt_set_attr_binding(&a->aTextureUVAtlasExtents, 1, 2, (void*)offsetof(struct Vertex, atlas_extents), sizeof(struct Vertex), GL_FLOAT, 0);
+    a->aVertexPosition2D.enabled = a->aVertexColour.enabled = a->aTextureUVAtlasMin.enabled = a->aTextureUVAtlasExtents.enabled = 1;
+}
+
+static void free_draw(struct GLShareGroup* group) {
+    for (unsigned int id = 1; id <= 2; id += 1) {
+        struct GLArrayBuffer* buffer = _bolt_find_buffer(&group->buffers, id);
+        free(buffer->data);
+        buffer->data = NULL;
+    }
+}
+
+static void test_capture() {
+    struct GLContext* c = _bolt_create_context((void*)1, NULL);
+    struct GLShareGroup* group = c->share_group;
+    enum { QUADS = 5000 };
+    struct GLDrawSnapshot draw;
+    make_draw(group, QUADS, &draw);
+
+    struct GLDrawSnapshot* pinned = _bolt_capture_pin(group, &draw, 1, malloc);
+    CHECK(pinned != NULL);
+    // the game writing over the buffers after the draw mustn't change what gets captured, since that's the next frame
+    struct GLArrayBuffer* vb = _bolt_find_buffer(&group->buffers, 1);
+    memset(vb->data, 0, vb->capacity);
+    struct BoltRenderList list = {0};
+    CHECK(pinned && _bolt_capture_draw(&list, pinned, 0) == QUADS);
+    CHECK(list.count == QUADS);
+    CHECK(list.texture[7] == 42 && list.screen_x[7] == 70 && list.screen_y[7] == 0 && list.screen_w[7] == 8 && list.screen_h[7] == 6);
+    CHECK(list.screen_y[250] == 20 && list.atlas_x[250] == 0.25f && list.atlas_h[250] == 0.0625f);
+    CHECK(list.colour[7] == (0xFFu | (7u << 8) | (128u << 24)));
+    free(pinned);
+
+    // a draw that reads past the end of its element buffer can't be pinned
+    struct GLDrawSnapshot bad = draw;
+    bad.count += 6;
+    CHECK(!_bolt_capture_pin(group, &bad, 1, malloc));
+    // nor can one whose shadows are from a different generation of the buffers set, or from when it was off
+    CHECK(!_bolt_capture_pin(group, &draw, 3, malloc));
+    CHECK(!_bolt_capture_pin(group, &draw, 2, malloc));
+
+    // a draw that only uses some of the buffer only gets that part of it
+    free_draw(group);
+    make_draw(group, QUADS, &draw);
+    draw.indices += 6 * 100 * sizeof(uint16_t);
+    draw.count = 6 * 10;
+    pinned = _bolt_capture_pin(group, &draw, 1, malloc);
+    CHECK(pinned && pinned->vertices_size < 41 * sizeof(struct Vertex));
+    _bolt_render_list_clear(&list);
+    CHECK(pinned && _bolt_capture_draw(&list, pinned, 0) == 10);
+    CHECK(list.screen_x[3] == 30 && list.screen_y[3] == 10 && list.colour[3] == (0xFFu | (103u << 8) | (128u << 24)));
+    free(pinned);
+
+    // once the list is over budget, draws are dropped rather than captured
+    pinned = _bolt_capture_pin(group, &draw, 1, malloc);
+    _bolt_render_list_clear(&list);
+    list.elapsed_ns = 5000;
+    CHECK(pinned && _bolt_capture_draw(&list, pinned, 1000) == 0 && list.dropped == 10);
+    free(pinned);
+
+    free_draw(group);
+    _bolt_render_list_free(&list);
+}
+
+int main() {
+    test_capture();
+    test_empty_diffs();
+    test_random_diffs();
+    return TEST_RESULT();
+}
@@ -0,0 +1,82 @@
+// page write detection (BOLT_DIRTY_PAGES) vs marking the whole mapping dirty, on one 4MiB mapping written to in
+// different patterns. "game" is the time spent on the game thread per map/unmap, i.e. checksumming for page detection,
+// and "upload" is the time to copy out whatever was marked dirty, standing in for glBufferSubData.
+// usage: dirty_pages_bench [iterations]
+#include "gl.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFFER_SIZE (4 << 20)
+#define PAGE_SIZE 4096
+#define PAGES (BUFFER_SIZE / PAGE_SIZE)
+
+enum Pattern { ONE_WRITE, SCATTERED, HALF_PAGES, EVERYTHING, PATTERN_COUNT };
+static const char* pattern_names[PATTERN_COUNT] = {"one 64B write", "64B to 1% of pages", "every other page", "everything"};
+
+static void write_pattern(uint8_t* data, enum Pattern pattern, uint8_t value) {
+    switch (pattern) {
+        case ONE_WRITE:
+            memset(data + (test_rand() % (BUFFER_SIZE - 64)), value, 64);
+            break;
+        case SCATTERED:
+            for (size_t i = 0; i < PAGES / 100; i += 1) memset(data + ((test_rand() % PAGES) * PAGE_SIZE) + (test_rand() % (PAGE_SIZE - 64)), value, 64);
+            break;
+        case HALF_PAGES:
+            for (size_t i = 0; i < PAGES; i += 2) memset(data + (i * PAGE_SIZE), value, PAGE_SIZE);
+            break;
+        default:
+            memset(data, value, BUFFER_SIZE);
+            break;
+    }
+}
+
+// copies out everything that's dirty, and returns how many bytes that was
+static size_t upload(struct GLContext* c, uint8_t* dest) {
+    struct GLBufferUpload uploads[PAGES + 1];
+    const size_t count = _bolt_context_take_buffer_uploads(c, uploads);
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i += 1) {
+        memcpy(dest + uploads[i].offset, uploads[i].data, uploads[i].length);
+        bytes += uploads[i].length;
+    }
+    return bytes;
+}
+
+int main(int argc, char** argv) {
+    const size_t iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 200;
+    struct GLContext* c = _bolt_create_context((void*)1, NULL);
+    struct GLArrayBuffer* buffer = _bolt_get_buffer(c->shared_buffers, 1);
+    buffer->data = aligned_alloc(PAGE_SIZE, BUFFER_SIZE);
+    buffer->capacity = BUFFER_SIZE;
+    buffer->mapping_offset = 0;
+    buffer->mapping_len = BUFFER_SIZE;
+    uint8_t* dest = malloc(BUFFER_SIZE);
+    memset(buffer->data, 0, BUFFER_SIZE);
+
+    printf("%zu iterations of a %i-byte mapping, times per map/unmap\n", iterations, BUFFER_SIZE);
+    for (int pattern = 0; pattern < PATTERN_COUNT; pattern += 1) {
+        for (int pages = 0; pages < 2; pages += 1) {
+            uint64_t game_ns = 0, upload_ns = 0;
+            size_t bytes = 0;
+            for (size_t i = 0; i < iterations; i += 1) {
+                uint64_t start = test_now_ns();
+                if (pages) _bolt_buffer_snapshot_pages(buffer, PAGE_SIZE);
+                game_ns += test_now_ns() - start;
+                write_pattern(buffer->data, (enum Pattern)pattern, (uint8_t)(i + 1));
+                start = test_now_ns();
+                if (pages) _bolt_context_mark_written_pages(c, buffer, PAGE_SIZE);
+                else _bolt_context_mark_buffer_dirty(c, buffer, 0, BUFFER_SIZE);
+                const uint64_t marked = test_now_ns();
+                game_ns += marked - start;
+                bytes += upload(c, dest);
+                upload_ns += test_now_ns() - marked;
+            }
+            printf("%-19s %-11s game %8.1f us, upload %8.1f us, %9zu bytes uploaded\n", pattern_names[pattern], pages ? "page sums" : "whole range",
+                   (double)game_ns / 1000.0 / (double)iterations, (double)upload_ns / 1000.0 / (double)iterations, bytes / iterations);
+        }
+    }
+    free(dest);
+    return 0;
+}
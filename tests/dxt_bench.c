@@ -0,0 +1,52 @@
+// S3TC decode throughput of each row kernel, on atlas-sized DXT1, DXT3 and DXT5 images of random blocks. the whole
+// image is block-aligned, so it's all row kernel; the unaligned region also goes through the edge path along its
+// borders, which is what decoding one tile of an upload looks like. usage: dxt_bench [repeats per case]
+#include "dxt.h"
+#include "gl.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+#define ATLAS_SIZE 2048
+
+static volatile uint8_t sink;
+
+static double run(uint32_t format, const uint8_t* blocks, uint8_t* out, unsigned int x, unsigned int y, unsigned int w, unsigned int h, size_t repeats) {
+    const uint64_t start = test_now_ns();
+    for (size_t i = 0; i < repeats; i += 1) {
+        _bolt_dxt_decode_region(format, blocks, ATLAS_SIZE, ATLAS_SIZE, x, y, w, h, out, (size_t)w * 4);
+        sink += out[i % ((size_t)w * h * 4)];
+    }
+    const double seconds = (double)(test_now_ns() - start) / 1e9;
+    return ((double)w * h * repeats) / seconds / 1e6;
+}
+
+int main(int argc, char** argv) {
+    const size_t repeats = argc > 1 ? strtoul(argv[1], NULL, 10) : 20;
+    const struct { const char* name; uint32_t format; } formats[] = {
+        {"DXT1", GL_COMPRESSED_RGBA_S3TC_DXT1_EXT}, {"DXT3", GL_COMPRESSED_RGBA_S3TC_DXT3_EXT}, {"DXT5", GL_COMPRESSED_RGBA_S3TC_DXT5_EXT},
+    };
+    const struct { const char* name; enum BoltDXTKernel kernel; } kernels[] = {
+        {"scalar", BOLT_DXT_KERNEL_SCALAR}, {"SSE2", BOLT_DXT_KERNEL_SSE2}, {"AVX2", BOLT_DXT_KERNEL_AVX2},
+    };
+    const size_t size = (size_t)(ATLAS_SIZE / 4) * (ATLAS_SIZE / 4) * 16;
+    uint8_t* blocks = malloc(size);
+    uint8_t* out = malloc((size_t)ATLAS_SIZE * ATLAS_SIZE * 4);
+    for (size_t i = 0; i < size; i += 1) blocks[i] = (uint8_t)test_rand();
+
+    printf("%ix%i atlas, %zu repeats, Mpixels/s\n", ATLAS_SIZE, ATLAS_SIZE, repeats);
+    for (size_t f = 0; f < sizeof(formats) / sizeof(*formats); f += 1) {
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(*kernels); k += 1) {
+            if (!_bolt_dxt_use_kernel(kernels[k].kernel)) {
+                printf("%s %-6s not available\n", formats[f].name, kernels[k].name);
+                continue;
+            }
+            const double whole = run(formats[f].format, blocks, out, 0, 0, ATLAS_SIZE, ATLAS_SIZE, repeats);
+            const double region = run(formats[f].format, blocks, out, 3, 5, 1001, 997, repeats * 4);
+            printf("%s %-6s whole %8.1f | unaligned 1001x997 %8.1f\n", formats[f].name, kernels[k].name, whole, region);
+        }
+    }
+    free(blocks);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "dxt.h"
+#include "gl.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// straightforward per-pixel decoder written from the S3TC spec, independently of dxt.c. endpoints are expanded to
+// 8 bits by bit replication, and interpolated colours and alphas are rounded down, which is what dxt.c does too.
+static uint8_t expand(uint32_t v, uint32_t bits) {
+    return (uint8_t)((v << (8 - bits)) | (v >> (2 * bits - 8)));
+}
+
+static void reference_pixel(uint32_t format, const uint8_t* block, unsigned int px, unsigned int py, uint8_t* rgba) {
+    const uint8_t dxt1 = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT ||
+                         format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+    const uint8_t dxt1_alpha = format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+    const uint8_t dxt3 = format == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+    const unsigned int i = py * 4 + px;
+    const uint8_t* colour = dxt1 ? block : block + 8;
+    const uint32_t c0 = colour[0] | (colour[1] << 8);
+    const uint32_t c1 = colour[2] | (colour[3] << 8);
+    const uint32_t code = (colour[4 + py] >> (2 * px)) & 3;
+    const uint8_t e0[3] = {expand(c0 >> 11, 5), expand((c0 >> 5) & 63, 6), expand(c0 & 31, 5)};
+    const uint8_t e1[3] = {expand(c1 >> 11, 5), expand((c1 >> 5) & 63, 6), expand(c1 & 31, 5)};
+    rgba[3] = 255;
+    for (int ch = 0; ch < 3; ch += 1) {
+        if (code == 0) rgba[ch] = e0[ch];
+        else if (code == 1) rgba[ch] = e1[ch];
+        else if (!dxt1 || c0 > c1) rgba[ch] = code == 2 ? (2 * e0[ch] + e1[ch]) / 3 : (e0[ch] + 2 * e1[ch]) / 3;
+        else if (code == 2) rgba[ch] = (e0[ch] + e1[ch]) / 2;
+        else rgba[ch] = 0;
+    }
+    if (dxt1) {
+        if (dxt1_alpha && code == 3 && c0 <= c1) rgba[3] = 0;
+    } else if (dxt3) {
+        rgba[3] = ((block[i / 2] >> (4 * (i % 2))) & 15) * 17;
+    } else {
+        const uint32_t a0 = block[0];
+        const uint32_t a1 = block[1];
+        const uint32_t bit = 16 + 3 * i;
+        const uint32_t a = (uint32_t)((block[bit / 8] | (block[bit / 8 + 1] << 8)) >> (bit % 8)) & 7;
+        if (a == 0) rgba[3] = a0;
+        else if (a == 1) rgba[3] = a1;
+        else if (a0 > a1) rgba[3] = ((8 - a) * a0 + (a - 1) * a1) / 7;
+        else if (a < 6) rgba[3] = ((6 - a) * a0 + (a - 1) * a1) / 5;
+        else rgba[3] = a == 6 ? 0 : 255;
+    }
+}
+
+static const uint32_t formats[] = {
+    GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+    GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT,
+};
+
+// random images and random regions of them, through every kernel this build and CPU have. regions are chosen so that
+// some line up with blocks, which go through the row kernel, and some don't, which go through the edge path.
+static void test_against_reference(enum BoltDXTKernel kernel) {
+    if (!_bolt_dxt_use_kernel(kernel)) {
+        printf("kernel %i not available, skipping\n", (int)kernel);
+        return;
+    }
+    for (size_t f = 0; f < sizeof(formats) / sizeof(*formats); f += 1) {
+        const size_t block_size = _bolt_dxt_block_size(formats[f]);
+        CHECK(block_size == (f % 4 < 2 ? 8 : 16));
+        for (int iteration = 0; iteration < 200; iteration += 1) {
+            const unsigned int width = 1 + (test_rand() % 40);
+            const unsigned int height = 1 + (test_rand() % 40);
+            const size_t blocks_wide = (width + 3) / 4;
+            const size_t size = blocks_wide * ((height + 3) / 4) * block_size;
+            uint8_t* data = malloc(size);
+            for (size_t i = 0; i < size; i += 1) data[i] = (uint8_t)test_rand();
+            unsigned int x = 0, y = 0, w = width, h = height;
+            if (iteration % 2) {
+                x = test_rand() % width;
+                y = test_rand() % height;
+                w = 1 + (test_rand() % (width - x));
+                h = 1 + (test_rand() % (height - y));
+            }
+            // padding on every row, to catch anything written outside the region
+            const size_t pitch = (w * 4) + 12;
+            uint8_t* out = malloc(pitch * h);
+            memset(out, 0xCD, pitch * h);
+            _bolt_dxt_decode_region(formats[f], data, width, height, x, y, w, h, out, pitch);
+            size_t bad = 0;
+            for (unsigned int py = 0; py < h; py += 1) {
+                for (unsigned int px = 0; px < w; px += 1) {
+                    const unsigned int ix = x + px;
+                    const unsigned int iy = y + py;
+                    uint8_t expected[4];
+                    reference_pixel(formats[f], data + ((iy / 4) * blocks_wide + (ix / 4)) * block_size, ix % 4, iy % 4, expected);
+                    if (memcmp(out + (py * pitch) + (px * 4), expected, 4)) bad += 1;
+                }
+                for (size_t i = w * 4; i < pitch; i += 1) if (out[(py * pitch) + i] != 0xCD) bad += 1;
+            }
+            if (bad) printf("kernel %i, format 0x%X, %ux%u image, region (%u, %u, %u, %u): %zu bad pixels\n",
+                            (int)kernel, (unsigned int)formats[f], width, height, x, y, w, h, bad);
+            CHECK(bad == 0);
+            free(out);
+            free(data);
+        }
+    }
+}
+
+static void test_rejects() {
+    uint8_t data[8] = {0};
+    uint8_t out[4] = {1, 2, 3, 4};
+    CHECK(_bolt_dxt_block_size(GL_FLOAT) == 0);
+    _bolt_dxt_decode_region(GL_FLOAT, data, 4, 4, 0, 0, 1, 1, out, 4);
+    _bolt_dxt_decode_region(GL_COMPRESSED_RGB_S3TC_DXT1_EXT, data, 4, 4, 3, 0, 2, 1, out, 8);
+    CHECK(out[0] == 1 && out[3] == 4);
+}
+
+int main() {
+    test_against_reference(BOLT_DXT_KERNEL_SCALAR);
+    test_against_reference(BOLT_DXT_KERNEL_SSE2);
+    test_against_reference(BOLT_DXT_KERNEL_AVX2);
+    test_rejects();
+    return TEST_RESULT();
+}
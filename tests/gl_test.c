@@ -0,0 +1,309 @@
+#include "gl.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// the fetcher is cached per VAO, and has to be rebuilt whenever the program it was built for is relinked, or its id is
+// given to a new program, even though the id stays the same
+static void test_vertex_fetcher() {
+    struct GLContext* c = _bolt_create_context((void*)1, NULL);
+    _bolt_context_bind_buffer(c, GL_ARRAY_BUFFER, 7);
+    for (unsigned int i = 0; i < 5; i += 1) {
+        _bolt_context_set_attr(c, i, 2, (void*)(uintptr_t)(i * 8), 40, GL_FLOAT, 0);
+        _bolt_context_enable_attr(c, i, 1);
+    }
+    c->bound_program_id = 3;
+    c->current_program = (struct GLProgram){.id = 3, .loc_aVertexPosition2D = 0, .loc_aVertexColour = 1, .loc_aTextureUV = 2,
+                                            .loc_aTextureUVAtlasMin = 3, .loc_aTextureUVAtlasExtents = 4, .is_important = 1, .link = 1};
+    const struct GLVertexFetcher* fetcher = _bolt_context_vertex_fetcher(c);
+    CHECK(fetcher && fetcher->aVertexPosition2D.offset == 0 && fetcher->aTextureUVAtlasMin.offset == 24);
+    CHECK(_bolt_context_vertex_fetcher(c) == fetcher);
+
+    // same id and layout, different locations
+    c->current_program.loc_aVertexPosition2D = 4;
+    c->current_program.loc_aTextureUVAtlasExtents = 0;
+    c->current_program.link = 2;
+    fetcher = _bolt_context_vertex_fetcher(c);
+    CHECK(fetcher && fetcher->link == 2 && fetcher->aVertexPosition2D.offset == 32 && fetcher->aTextureUVAtlasExtents.offset == 0);
+
+    // changing the layout rebuilds it too
+    _bolt_context_set_attr(c, 4, 2, (void*)100, 40, GL_FLOAT, 0);
+    fetcher = _bolt_context_vertex_fetcher(c);
+    CHECK(fetcher && fetcher->aVertexPosition2D.offset == 100);
+
+    // out of range locations never get a fetcher
+    c->current_program.loc_aTextureUV = MAX_VERTEX_ATTRIBS;
+    c->current_program.link = 3;
+    CHECK(!_bolt_context_vertex_fetcher(c));
+}
+
+// rendering only invalidates a texture if it's attached to the bound draw framebuffer
+static void test_render_target() {
+    struct GLContext* c = _bolt_create_context((void*)1, NULL);
+    CHECK(!_bolt_context_render_target(c));
+    c->current_draw_framebuffer = 4;
+    c->current_read_framebuffer = 4;
+    CHECK(!_bolt_context_render_target(c));
+    _bolt_context_attach_texture(c, GL_FRAMEBUFFER, 9);
+    CHECK(_bolt_context_render_target(c) == 9);
+
+    // attaching through the read binding doesn't change what the draw framebuffer renders to, unless they're the same
+    c->current_read_framebuffer = 5;
+    _bolt_context_attach_texture(c, GL_READ_FRAMEBUFFER, 11);
+    CHECK(_bolt_context_render_target(c) == 9);
+    c->current_draw_framebuffer = 5;
+    CHECK(_bolt_context_render_target(c) == 11);
+    _bolt_context_attach_texture(c, GL_DRAW_FRAMEBUFFER, 0);
+    CHECK(!_bolt_context_render_target(c));
+
+    // deleting a bound framebuffer unbinds it, and a new one with the same id starts with nothing attached
+    c->current_draw_framebuffer = 4;
+    const unsigned int ids[] = {4, 0};
+    _bolt_context_delete_framebuffers(c, 2, ids);
+    CHECK(c->current_draw_framebuffer == 0 && c->current_read_framebuffer == 5);
+    c->current_draw_framebuffer = 4;
+    CHECK(!_bolt_context_render_target(c));
+}
+
+// attributes are only read from shadows made while the buffers set has been on since
+static void test_attr_generation() {
+    struct GLContext* c = _bolt_create_context((void*)1, NULL);
+    float data[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    struct GLArrayBuffer* buffer = _bolt_get_buffer(c->shared_buffers, 7);
+    CHECK(buffer);
+    if (!buffer) return;
+    buffer->data = (uint8_t*)data;
+    buffer->capacity = sizeof(data);
+    buffer->generation = 1;
+    struct GLAttrBinding binding;
+    _bolt_set_attr_binding(&binding, 7, 2, (void*)0, 8, GL_FLOAT, 0);
+    float out[2] = {0};
+    CHECK(_bolt_get_attr_binding(c, &binding, 1, 2, out, 1) && out[0] == 3.0f && out[1] == 4.0f);
+    CHECK(!_bolt_get_attr_binding(c, &binding, 1, 2, out, 2));
+    CHECK(!_bolt_get_attr_binding(c, &binding, 1, 2, out, 3));
+    buffer = _bolt_find_buffer(c->shared_buffers, 7);
+    if (buffer) buffer->data = NULL;
+}
+
+// uploads that only partly overlap never cover each other, so in a texture that's never read the journal has to be
+// kept down some other way, without changing what reading it gives in the end
+static void test_journal_bounded() {
+    enum { SIZE = 128, UPLOAD = 8 };
+    struct GLTexture2D tex = {.id = 1};
+    _bolt_texture_storage(&tex, GL_RGBA, SIZE, SIZE);
+    static uint8_t expected[SIZE * SIZE * 4];
+    static uint8_t actual[SIZE * SIZE * 4];
+    uint8_t data[UPLOAD * UPLOAD * 4];
+    memset(expected, 0, sizeof(expected));
+    size_t max_count = 0, max_bytes = 0;
+    for (int i = 0; i < 5000; i += 1) {
+        const unsigned int x = test_rand() % (SIZE - UPLOAD + 1);
+        const unsigned int y = test_rand() % (SIZE - UPLOAD + 1);
+        for (size_t j = 0; j < sizeof(data); j += 1) data[j] = (uint8_t)test_rand();
+        _bolt_texture_upload(&tex, GL_RGBA, x, y, UPLOAD, UPLOAD, data, 0);
+        for (unsigned int row = 0; row < UPLOAD; row += 1) memcpy(expected + ((((y + row) * SIZE) + x) * 4), data + (row * UPLOAD * 4), UPLOAD * 4);
+        if (tex.upload_count > max_count) max_count = tex.upload_count;
+        if (tex.journal_bytes > max_bytes) max_bytes = tex.journal_bytes;
+    }
+    CHECK(max_count <= TEXTURE_JOURNAL_MAX_UPLOADS);
+    CHECK(max_bytes <= (size_t)SIZE * SIZE * 4);
+    CHECK(_bolt_texture_read(&tex, 0, 0, SIZE, SIZE, actual, SIZE * 4));
+    CHECK(!memcmp(actual, expected, sizeof(actual)));
+    _bolt_texture_free(&tex);
+}
+
+// multi-bind doesn't say which target a texture goes to, so textures known to be for some other target leave the 2D
+// binding alone, and binding 0 clears it
+static void test_unit_texture() {
+    struct GLContext* c = _bolt_create_context((void*)1, NULL);
+    const uint32_t texture_2d_array = 0x8C1A; // GL_TEXTURE_2D_ARRAY
+    c->active_texture_unit = 2;
+    _bolt_context_bind_texture(c, GL_TEXTURE_2D, 5);
+    _bolt_context_bind_texture(c, texture_2d_array, 6);
+    CHECK(_bolt_context_unit_texture_binding(c, 2) == 5);
+    _bolt_context_bind_unit_texture(c, 2, 6);
+    CHECK(_bolt_context_unit_texture_binding(c, 2) == 5);
+    _bolt_context_bind_unit_texture(c, 2, 7);
+    CHECK(_bolt_context_unit_texture_binding(c, 2) == 7);
+    _bolt_context_bind_unit_texture(c, 2, 0);
+    CHECK(_bolt_context_unit_texture_binding(c, 2) == 0);
+    _bolt_context_bind_unit_texture(c, MAX_TEXTURE_UNITS, 7);
+
+    // once it's deleted, the id can come back as a 2D texture
+    const unsigned int ids[] = {6};
+    _bolt_context_unbind_textures(c, 1, ids);
+    _bolt_context_bind_unit_texture(c, 2, 6);
+    CHECK(_bolt_context_unit_texture_binding(c, 2) == 6);
+}
+
+// what a texture in test_texture_copy should read back as, kept the simple way, as one flat RGBA image
+struct CopyTexture {
+    struct GLTexture2D tex;
+    uint8_t* expected;
+};
+
+// writes RGBA to the reference, keeping only as many channels as the texture has, and filling the rest in the same
+// way that reading does
+static void copy_texture_write(struct CopyTexture* t, unsigned int x, unsigned int y, unsigned int w, unsigned int h, const uint8_t* rgba, uint8_t channels) {
+    const uint8_t kept = (channels < t->tex.bytes_per_pixel) ? channels : t->tex.bytes_per_pixel;
+    for (unsigned int row = 0; row < h; row += 1) {
+        for (unsigned int i = 0; i < w; i += 1) {
+            uint8_t* out = t->expected + ((((size_t)(y + row) * t->tex.width) + x + i) * 4);
+            const uint8_t* in = rgba + ((((size_t)row * w) + i) * channels);
+            for (uint8_t c = 0; c < 4; c += 1) out[c] = (c < kept) ? in[c] : ((c == 3) ? 255 : 0);
+        }
+    }
+}
+
+static uint8_t copy_texture_matches(struct CopyTexture* t) {
+    const size_t size = (size_t)t->tex.width * t->tex.height * 4;
+    uint8_t* actual = malloc(size);
+    const uint8_t ok = _bolt_texture_read(&t->tex, 0, 0, t->tex.width, t->tex.height, actual, (size_t)t->tex.width * 4) && !memcmp(actual, t->expected, size);
+    free(actual);
+    return ok;
+}
+
+static void copy_texture_upload(struct CopyTexture* t, unsigned int x, unsigned int y, unsigned int w, unsigned int h, uint8_t channels) {
+    const uint32_t format = (channels == 1) ? GL_RED : ((channels == 2) ? GL_RG : GL_RGBA);
+    uint8_t* data = malloc((size_t)w * h * channels);
+    for (size_t i = 0; i < (size_t)w * h * channels; i += 1) data[i] = (uint8_t)test_rand();
+    _bolt_texture_upload(&t->tex, format, x, y, w, h, data, 0);
+    copy_texture_write(t, x, y, w, h, data, channels);
+    free(data);
+}
+
+static void copy_texture_copy(struct CopyTexture* dst, unsigned int dst_x, unsigned int dst_y, struct CopyTexture* src, unsigned int src_x, unsigned int src_y, unsigned int w, unsigned int h) {
+    uint8_t* region = malloc((size_t)w * h * 4);
+    for (unsigned int row = 0; row < h; row += 1) {
+        memcpy(region + ((size_t)row * w * 4), src->expected + ((((size_t)(src_y + row) * src->tex.width) + src_x) * 4), (size_t)w * 4);
+    }
+    CHECK(_bolt_texture_copy(&dst->tex, dst_x, dst_y, &src->tex, src_x, src_y, w, h));
+    copy_texture_write(dst, dst_x, dst_y, w, h, region, 4);
+    free(region);
+}
+
+static struct GLTilePixels* copy_texture_tile(const struct CopyTexture* t, unsigned int tx, unsigned int ty) {
+    return t->tex.tiles[(ty * t->tex.tiles_wide) + tx].pixels;
+}
+
+// every tile's pixels have to be counted once for each tile pointing at them, and each texture's resident bytes have
+// to be the sum of its tiles' and its journal's
+static void check_copy_accounting(struct CopyTexture* textures, size_t count) {
+    for (size_t i = 0; i < count; i += 1) {
+        const struct GLTexture2D* tex = &textures[i].tex;
+        size_t resident = tex->journal_bytes;
+        for (size_t j = 0; j < (size_t)tex->tiles_wide * tex->tiles_high; j += 1) {
+            const struct GLTilePixels* pixels = tex->tiles[j].pixels;
+            if (!pixels) continue;
+            resident += pixels->size;
+            uint32_t references = 0;
+            for (size_t k = 0; k < count; k += 1) {
+                const struct GLTexture2D* other = &textures[k].tex;
+                for (size_t l = 0; l < (size_t)other->tiles_wide * other->tiles_high; l += 1) references += other->tiles[l].pixels == pixels;
+            }
+            CHECK(pixels->refcount == references);
+        }
+        CHECK(tex->resident_bytes == resident);
+    }
+}
+
+// tile-aligned copies share pixels between tiles rather than copying them, so whatever's written afterwards, to
+// either side of the copy, mustn't show through to the other
+static void test_texture_copy() {
+    enum { W = 200, H = 150 }; // so the tiles along the right and bottom edges are smaller
+    struct CopyTexture textures[4] = {
+        {.tex = {.id = 1}}, {.tex = {.id = 2}}, {.tex = {.id = 3}}, {.tex = {.id = 4}},
+    };
+    const uint32_t formats[4] = {GL_RGBA, GL_RGBA, GL_R8, GL_RGBA};
+    const unsigned int sizes[4][2] = {{W, H}, {W, H}, {W, H}, {130, 70}};
+    for (size_t i = 0; i < 4; i += 1) {
+        _bolt_texture_storage(&textures[i].tex, formats[i], sizes[i][0], sizes[i][1]);
+        textures[i].expected = calloc((size_t)sizes[i][0] * sizes[i][1], 4);
+        // tiles that have never been written read as zeroes, expanded like anything else
+        copy_texture_write(&textures[i], 0, 0, sizes[i][0], sizes[i][1], textures[i].expected, 4);
+    }
+    struct CopyTexture* a = &textures[0];
+    struct CopyTexture* b = &textures[1];
+
+    // a whole-texture copy shares every tile, edges included
+    copy_texture_upload(a, 0, 0, W, H, 4);
+    copy_texture_copy(b, 0, 0, a, 0, 0, W, H);
+    uint8_t all_shared = 1;
+    for (unsigned int ty = 0; ty < a->tex.tiles_high; ty += 1) {
+        for (unsigned int tx = 0; tx < a->tex.tiles_wide; tx += 1) {
+            all_shared &= copy_texture_tile(a, tx, ty) == copy_texture_tile(b, tx, ty) && copy_texture_tile(a, tx, ty)->refcount == 2;
+        }
+    }
+    CHECK(all_shared);
+    check_copy_accounting(textures, 4);
+
+    // writing to one side gives it its own copy of just that tile, and leaves the other side alone
+    copy_texture_upload(b, 70, 70, 4, 4, 4);
+    CHECK(copy_texture_matches(b));
+    CHECK(copy_texture_tile(a, 1, 1) != copy_texture_tile(b, 1, 1) && copy_texture_tile(a, 1, 1)->refcount == 1);
+    CHECK(copy_texture_tile(a, 0, 0) == copy_texture_tile(b, 0, 0));
+    CHECK(copy_texture_matches(a));
+
+    // within the same texture, and then written to in the source, which is also shared with b
+    copy_texture_copy(a, 128, 64, a, 0, 0, TEXTURE_TILE_SIZE, TEXTURE_TILE_SIZE);
+    CHECK(copy_texture_tile(a, 2, 1) == copy_texture_tile(a, 0, 0) && copy_texture_tile(a, 0, 0)->refcount == 3);
+    copy_texture_upload(a, 10, 10, 20, 20, 1);
+    CHECK(copy_texture_matches(a) && copy_texture_matches(b));
+    CHECK(copy_texture_tile(a, 2, 1) == copy_texture_tile(b, 0, 0) && copy_texture_tile(b, 0, 0)->refcount == 2);
+    check_copy_accounting(textures, 4);
+
+    // and then everything mixed together: uploads that are left in the journal for a while before being read, aligned
+    // copies that share tiles (or don't, when the edge tiles are different sizes or the formats differ), unaligned
+    // copies, and copies within one texture
+    for (int i = 0; i < 3000; i += 1) {
+        struct CopyTexture* t = &textures[test_rand() % 4];
+        const uint32_t op = test_rand() % 10;
+        if (op < 4) {
+            const unsigned int w = 1 + (test_rand() % 80), h = 1 + (test_rand() % 80);
+            if (w > t->tex.width || h > t->tex.height) continue;
+            copy_texture_upload(t, test_rand() % (t->tex.width - w + 1), test_rand() % (t->tex.height - h + 1), w, h, (uint8_t[]){1, 2, 4}[test_rand() % 3]);
+        } else if (op < 9) {
+            struct CopyTexture* src = (op == 8) ? t : &textures[test_rand() % 4];
+            const uint8_t aligned = op < 7;
+            const unsigned int max_w = (src->tex.width < t->tex.width) ? src->tex.width : t->tex.width;
+            const unsigned int max_h = (src->tex.height < t->tex.height) ? src->tex.height : t->tex.height;
+            unsigned int w = 1 + (test_rand() % max_w), h = 1 + (test_rand() % max_h);
+            unsigned int sx = test_rand() % (src->tex.width - w + 1), sy = test_rand() % (src->tex.height - h + 1);
+            unsigned int dx = test_rand() % (t->tex.width - w + 1), dy = test_rand() % (t->tex.height - h + 1);
+            if (aligned) {
+                sx -= sx % TEXTURE_TILE_SIZE;
+                sy -= sy % TEXTURE_TILE_SIZE;
+                dx -= dx % TEXTURE_TILE_SIZE;
+                dy -= dy % TEXTURE_TILE_SIZE;
+                // out to the edge of whichever texture's edge is nearer, where the tiles may be smaller
+                w = ((src->tex.width - sx) < (t->tex.width - dx)) ? src->tex.width - sx : t->tex.width - dx;
+                h = ((src->tex.height - sy) < (t->tex.height - dy)) ? src->tex.height - sy : t->tex.height - dy;
+                if (test_rand() % 2 && w > TEXTURE_TILE_SIZE) w -= w % TEXTURE_TILE_SIZE;
+                if (test_rand() % 2 && h > TEXTURE_TILE_SIZE) h -= h % TEXTURE_TILE_SIZE;
+            }
+            // GL doesn't say what copying a region over itself does
+            if (src == t && sx < dx + w && dx < sx + w && sy < dy + h && dy < sy + h) continue;
+            copy_texture_copy(t, dx, dy, src, sx, sy, w, h);
+        } else {
+            CHECK(copy_texture_matches(t));
+        }
+    }
+    for (size_t i = 0; i < 4; i += 1) CHECK(copy_texture_matches(&textures[i]));
+    check_copy_accounting(textures, 4);
+
+    for (size_t i = 0; i < 4; i += 1) {
+        _bolt_texture_free(&textures[i].tex);
+        free(textures[i].expected);
+    }
+}
+
+int main() {
+    test_vertex_fetcher();
+    test_render_target();
+    test_attr_generation();
+    test_journal_bounded();
+    test_unit_texture();
+    test_texture_copy();
+    return TEST_RESULT();
+}
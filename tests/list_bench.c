@@ -0,0 +1,114 @@
+// GLList lookups and inserts vs the getters it replaced, which kept a 64Ki-entry pointer cache per list in front of a
+// linear scan of a flat array that grew 256 elements at a time. ids under 65536 hit the old cache, and anything above
+// that was scanned for every time. usage: list_bench [lookups per case]
+#include "gl.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define OLD_GROWTH_STEP 256
+#define OLD_PTR_CAPACITY (256 * 256)
+
+struct OldList {
+    void* data;
+    void* pointers;
+    size_t capacity;
+    size_t first_empty;
+};
+
+// the old _bolt_find_buffer and _bolt_get_buffer, as they were
+static struct GLArrayBuffer* old_find(struct OldList* list, unsigned int id) {
+    struct GLArrayBuffer** pointer_cache = list->pointers;
+    if (id == 0) return NULL;
+    uint8_t cacheable = (id < OLD_PTR_CAPACITY);
+    if (cacheable && pointer_cache[id] != NULL) return pointer_cache[id];
+    for (size_t i = 0; i < list->capacity; i += 1) {
+        struct GLArrayBuffer* ptr = &((struct GLArrayBuffer*)(list->data))[i];
+        if (ptr->id == id) {
+            if (cacheable) pointer_cache[id] = ptr;
+            return ptr;
+        }
+    }
+    return NULL;
+}
+
+static struct GLArrayBuffer* old_get(struct OldList* list, unsigned int id) {
+    struct GLArrayBuffer** pointer_cache = list->pointers;
+    if (id == 0) return NULL;
+    uint8_t cacheable = (id < OLD_PTR_CAPACITY);
+    if (cacheable && pointer_cache[id] != NULL) return pointer_cache[id];
+    else if (!cacheable) {
+        for (size_t i = 0; i < list->capacity; i += 1) {
+            struct GLArrayBuffer* ptr = &((struct GLArrayBuffer*)(list->data))[i];
+            if (ptr->id == id) return ptr;
+        }
+    }
+    if (list->first_empty >= list->capacity) {
+        size_t old_capacity = list->capacity;
+        list->capacity += OLD_GROWTH_STEP;
+        struct GLArrayBuffer* new_ptr = calloc(list->capacity, sizeof(struct GLArrayBuffer));
+        memcpy(new_ptr, list->data, old_capacity * sizeof(struct GLArrayBuffer));
+        intptr_t ptr_offset = (intptr_t)new_ptr - (intptr_t)list->data;
+        free(list->data);
+        list->data = new_ptr;
+        for (size_t i = 0; i < OLD_PTR_CAPACITY; i += 1) {
+            if (pointer_cache[i]) pointer_cache[i] = (struct GLArrayBuffer*)((uintptr_t)(pointer_cache[i]) + ptr_offset);
+        }
+    }
+    struct GLArrayBuffer* ptr = &((struct GLArrayBuffer*)(list->data))[list->first_empty];
+    if (cacheable) pointer_cache[id] = ptr;
+    ptr->id = id;
+    struct GLArrayBuffer* inc_ptr = ptr;
+    while (list->first_empty < list->capacity && inc_ptr->id != 0) {
+        inc_ptr += 1;
+        list->first_empty += 1;
+    }
+    return ptr;
+}
+
+static size_t lookups = 2000000;
+static volatile uintptr_t sink;
+
+static void run(const char* name, size_t count, uint8_t sparse) {
+    unsigned int* ids = malloc(count * sizeof(*ids));
+    for (size_t i = 0; i < count; i += 1) ids[i] = sparse ? 65536 + (test_rand() & 0x7FFFFFF) * 16 + (unsigned int)i % 16 : (unsigned int)i + 1;
+    unsigned int* order = malloc(lookups * sizeof(*order));
+    for (size_t i = 0; i < lookups; i += 1) order[i] = ids[test_rand() % count];
+
+    struct OldList old = {.pointers = calloc(OLD_PTR_CAPACITY, sizeof(void*))};
+    uint64_t start = test_now_ns();
+    for (size_t i = 0; i < count; i += 1) old_get(&old, ids[i]);
+    const double old_insert = (double)(test_now_ns() - start) / (double)count;
+    start = test_now_ns();
+    // the old scan is so slow on sparse ids that only a fraction of the lookups are timed
+    const size_t old_lookups = sparse ? lookups / 100 : lookups;
+    for (size_t i = 0; i < old_lookups; i += 1) sink += (uintptr_t)old_find(&old, order[i]);
+    const double old_lookup = (double)(test_now_ns() - start) / (double)old_lookups;
+
+    struct GLList list = {0};
+    start = test_now_ns();
+    for (size_t i = 0; i < count; i += 1) _bolt_get_buffer(&list, ids[i]);
+    const double new_insert = (double)(test_now_ns() - start) / (double)count;
+    start = test_now_ns();
+    for (size_t i = 0; i < lookups; i += 1) sink += (uintptr_t)_bolt_find_buffer(&list, order[i]);
+    const double new_lookup = (double)(test_now_ns() - start) / (double)lookups;
+
+    printf("%-7s %6zu objects: lookup %8.1f ns old, %5.1f ns new | insert %8.1f ns old, %5.1f ns new\n",
+           name, count, old_lookup, new_lookup, old_insert, new_insert);
+    free(old.data);
+    free(old.pointers);
+    free(list.data);
+    free(list.ids);
+    free(list.index);
+    free(order);
+    free(ids);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) lookups = strtoul(argv[1], NULL, 10);
+    const size_t counts[] = {64, 1024, 8192};
+    for (size_t i = 0; i < sizeof(counts) / sizeof(*counts); i += 1) run("dense", counts[i], 0);
+    for (size_t i = 0; i < sizeof(counts) / sizeof(*counts); i += 1) run("sparse", counts[i], 1);
+    return 0;
+}
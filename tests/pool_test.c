@@ -0,0 +1,47 @@
+#include "so/pool.h"
+#include "test.h"
+
+#include <pthread.h>
+
+#define BLOCKS 8
+
+static void* blocks[BLOCKS];
+
+// takes the shared stack into its own cache by allocating one block, then exits with the rest still cached
+static void* allocating_thread(void* unused) {
+    (void)unused;
+    void* block = _bolt_pool_alloc(1000);
+    CHECK(block != NULL);
+    _bolt_pool_free(block, _bolt_pool_capacity(1000));
+    return NULL;
+}
+
+// blocks left in a thread's cache when it exits go back to the shared stacks, so other threads can still reuse them
+static void test_thread_exit() {
+    _bolt_pool_init(0, 1 << 20);
+    const size_t capacity = _bolt_pool_capacity(1000);
+    for (size_t i = 0; i < BLOCKS; i += 1) blocks[i] = _bolt_pool_alloc(1000);
+    for (size_t i = 0; i < BLOCKS; i += 1) _bolt_pool_free(blocks[i], capacity);
+    struct BoltPoolStats stats;
+    _bolt_pool_stats(&stats);
+    CHECK(stats.bytes_cached == BLOCKS * capacity);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, allocating_thread, NULL);
+    pthread_join(thread, NULL);
+    _bolt_pool_stats(&stats);
+    const uint64_t system_allocations = stats.system_allocations;
+    // the thread's free went to the shared stack, and the blocks it didn't use were pushed after it
+    CHECK(stats.bytes_cached == BLOCKS * capacity);
+
+    for (size_t i = 0; i < BLOCKS; i += 1) blocks[i] = _bolt_pool_alloc(1000);
+    _bolt_pool_stats(&stats);
+    CHECK(stats.system_allocations == system_allocations);
+    CHECK(stats.bytes_cached == 0);
+    for (size_t i = 0; i < BLOCKS; i += 1) _bolt_pool_free(blocks[i], capacity);
+}
+
+int main() {
+    test_thread_exit();
+    return TEST_RESULT();
+}
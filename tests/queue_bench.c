@@ -0,0 +1,77 @@
+// worker message throughput, through the queue vs through the socketpair it replaced, with one message per write and
+// read like the old SEND_MSG. usage: queue_bench [messages per producer]
+#include "so/queue.h"
+#include "test.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// same size as struct BoltMessage on 64-bit
+struct Message {
+    void* context;
+    void* data;
+    uint32_t fields[8];
+};
+
+static struct BoltQueue queue;
+static int sockets[2];
+static size_t messages_per_producer = 1000000;
+
+static void* queue_producer(void* arg) {
+    struct Message message = {0};
+    for (size_t i = 0; i < messages_per_producer; i += 1) {
+        message.fields[0] = (uint32_t)i;
+        _bolt_queue_push(&queue, &message);
+    }
+    return arg;
+}
+
+static void* socket_producer(void* arg) {
+    struct Message message = {0};
+    for (size_t i = 0; i < messages_per_producer; i += 1) {
+        message.fields[0] = (uint32_t)i;
+        if (write(sockets[0], &message, sizeof(message)) != sizeof(message)) abort();
+    }
+    return arg;
+}
+
+static void socket_read(struct Message* message) {
+    size_t done = 0;
+    while (done < sizeof(*message)) {
+        const ssize_t r = read(sockets[1], (uint8_t*)message + done, sizeof(*message) - done);
+        if (r <= 0) abort();
+        done += (size_t)r;
+    }
+}
+
+static double run(size_t producers, uint8_t use_queue) {
+    pthread_t threads[16];
+    struct Message message;
+    const uint64_t start = test_now_ns();
+    for (size_t i = 0; i < producers; i += 1) pthread_create(&threads[i], NULL, use_queue ? queue_producer : socket_producer, NULL);
+    for (size_t i = 0; i < producers * messages_per_producer; i += 1) {
+        if (use_queue) _bolt_queue_pop(&queue, &message);
+        else socket_read(&message);
+    }
+    for (size_t i = 0; i < producers; i += 1) pthread_join(threads[i], NULL);
+    const uint64_t elapsed = test_now_ns() - start;
+    return (double)(producers * messages_per_producer) * 1e9 / (double)elapsed;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) messages_per_producer = strtoul(argv[1], NULL, 10);
+    if (_bolt_queue_init(&queue, sizeof(struct Message), 1 << 14) || socketpair(AF_UNIX, SOCK_STREAM, 0, sockets)) return 1;
+    const size_t producer_counts[] = {1, 2, 4};
+    printf("%zu-byte messages, %zu per producer\n", sizeof(struct Message), messages_per_producer);
+    for (size_t i = 0; i < sizeof(producer_counts) / sizeof(*producer_counts); i += 1) {
+        const double q = run(producer_counts[i], 1);
+        const double s = run(producer_counts[i], 0);
+        printf("%zu producers: queue %.2f M/s, socketpair %.2f M/s (%.1fx)\n", producer_counts[i], q / 1e6, s / 1e6, q / s);
+    }
+    _bolt_queue_destroy(&queue);
+    close(sockets[0]);
+    close(sockets[1]);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "so/queue.h"
+#include "test.h"
+
+#include <pthread.h>
+
+#define PRODUCERS 4
+#define ITEMS_PER_PRODUCER 200000
+
+struct Item {
+    uint32_t producer;
+    uint32_t sequence;
+    uint64_t check;
+};
+
+static struct BoltQueue queue;
+
+static void* producer(void* arg) {
+    const uint32_t id = (uint32_t)(uintptr_t)arg;
+    for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; i += 1) {
+        const struct Item item = {.producer = id, .sequence = i, .check = ((uint64_t)id << 32) ^ (i * 2654435761u)};
+        _bolt_queue_push(&queue, &item);
+    }
+    return NULL;
+}
+
+// every item comes out exactly once, intact, and each producer's items come out in the order it pushed them. the
+// queue is kept small so that producers spend most of their time waiting for space, and the consumer for items.
+static void test_mpsc() {
+    CHECK(_bolt_queue_init(&queue, sizeof(struct Item), 3) != 0);
+    CHECK(_bolt_queue_init(&queue, sizeof(struct Item), 16) == 0);
+    struct Item item;
+    CHECK(!_bolt_queue_try_pop(&queue, &item));
+
+    pthread_t threads[PRODUCERS];
+    for (uintptr_t i = 0; i < PRODUCERS; i += 1) pthread_create(&threads[i], NULL, producer, (void*)i);
+    uint32_t next[PRODUCERS] = {0};
+    uint32_t bad = 0;
+    for (size_t i = 0; i < (size_t)PRODUCERS * ITEMS_PER_PRODUCER; i += 1) {
+        _bolt_queue_pop(&queue, &item);
+        if (item.producer >= PRODUCERS || item.sequence != next[item.producer] ||
+            item.check != (((uint64_t)item.producer << 32) ^ (item.sequence * 2654435761u))) {
+            bad += 1;
+            continue;
+        }
+        next[item.producer] += 1;
+    }
+    for (size_t i = 0; i < PRODUCERS; i += 1) pthread_join(threads[i], NULL);
+    CHECK(bad == 0);
+    for (size_t i = 0; i < PRODUCERS; i += 1) CHECK(next[i] == ITEMS_PER_PRODUCER);
+    CHECK(!_bolt_queue_try_pop(&queue, &item));
+    _bolt_queue_destroy(&queue);
+}
+
+int main() {
+    test_mpsc();
+    return TEST_RESULT();
+}
@@ -0,0 +1,136 @@
+#include "gl.h"
+#include "sprite.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t pixels[16 * 16 * 4];
+
+static void upload(struct BoltSpriteIndex* index, const struct GLTexture2D* tex, unsigned int x, unsigned int y, uint8_t fill) {
+    memset(pixels, fill, sizeof(pixels));
+    _bolt_sprite_index_upload(index, tex, GL_RGBA, x, y, 16, 16, pixels, 0);
+}
+
+// an image's id lasts for as long as some rectangle holds it, and is freed for reuse as soon as nothing does, so
+// overwriting the same rectangle with new images forever doesn't grow the index
+static void test_contents_released() {
+    struct BoltSpriteIndex index = {0};
+    struct GLTexture2D tex = {.id = 1};
+    _bolt_texture_storage(&tex, GL_RGBA, 256, 256);
+
+    upload(&index, &tex, 0, 0, 1);
+    upload(&index, &tex, 16, 0, 1);
+    const struct BoltSprite* sprite = _bolt_sprite_at(&index, 1, 0, 0, 16, 16);
+    CHECK(sprite && sprite->id);
+    const uint32_t id = sprite ? sprite->id : 0;
+    const uint64_t hash = sprite ? sprite->hash : 0;
+    CHECK(_bolt_sprite_id(&index, hash) == id);
+
+    // one of the two copies is overwritten, so the id stays
+    upload(&index, &tex, 0, 0, 2);
+    CHECK(_bolt_sprite_id(&index, hash) == id);
+    CHECK(_bolt_sprite_first(&index, id) == _bolt_sprite_at(&index, 1, 16, 0, 16, 16));
+    // and then the other, so it goes
+    upload(&index, &tex, 16, 0, 3);
+    CHECK(_bolt_sprite_id(&index, hash) == 0);
+    // the id may already have gone to the image that replaced it
+    const struct BoltSprite* reused = _bolt_sprite_first(&index, id);
+    CHECK(!reused || reused->hash != hash);
+
+    for (int i = 0; i < 10000; i += 1) upload(&index, &tex, 32, 32, (uint8_t)(i + 4));
+    CHECK(index.content_count <= 4);
+    CHECK(index.by_hash.count == 3);
+    CHECK(index.sprite_count <= 4);
+
+    _bolt_sprite_index_free(&index);
+    _bolt_texture_free(&tex);
+}
+
+// writes that can't be indexed, like rendering to the texture, still drop what they cover, and change the version
+static void test_invalidate() {
+    struct BoltSpriteIndex index = {0};
+    struct GLTexture2D tex = {.id = 1};
+    _bolt_texture_storage(&tex, GL_RGBA, 256, 256);
+    upload(&index, &tex, 0, 0, 1);
+    upload(&index, &tex, 128, 128, 2);
+    const uint64_t version = _bolt_sprite_texture_version(&index, 1);
+
+    _bolt_sprite_index_invalidate(&index, 1, 120, 120, 10, 10);
+    CHECK(_bolt_sprite_at(&index, 1, 0, 0, 16, 16));
+    CHECK(!_bolt_sprite_at(&index, 1, 128, 128, 16, 16));
+    CHECK(_bolt_sprite_texture_version(&index, 1) > version);
+
+    _bolt_sprite_index_invalidate(&index, 1, 0, 0, UINT32_MAX, UINT32_MAX);
+    CHECK(!_bolt_sprite_at(&index, 1, 0, 0, 16, 16));
+    CHECK(index.by_hash.count == 0);
+    // a texture that was never indexed has nothing to drop
+    _bolt_sprite_index_invalidate(&index, 2, 0, 0, 16, 16);
+    CHECK(_bolt_sprite_texture_version(&index, 2) == 0);
+
+    _bolt_sprite_index_free(&index);
+    _bolt_texture_free(&tex);
+}
+
+// uploads the same bytes to a fresh texture of the given internal format and checks that the rectangle's hash is the
+// one that reading it back gives, which is what the text engine does for glyphs that aren't indexed
+static uint64_t check_read_back(uint32_t internalformat, uint32_t format, const uint8_t* data, size_t data_pitch) {
+    struct BoltSpriteIndex index = {0};
+    struct GLTexture2D tex = {.id = 1};
+    _bolt_texture_storage(&tex, internalformat, 64, 64);
+    _bolt_texture_upload(&tex, format, 8, 8, 16, 16, data, data_pitch);
+    _bolt_sprite_index_upload(&index, &tex, format, 8, 8, 16, 16, data, data_pitch);
+    const struct BoltSprite* sprite = _bolt_sprite_at(&index, 1, 8, 8, 16, 16);
+    uint8_t rgba[16 * 16 * 4];
+    CHECK(_bolt_texture_read(&tex, 8, 8, 16, 16, rgba, 16 * 4));
+    const uint64_t hash = _bolt_sprite_hash_pixels(rgba, 16, 16, 16 * 4);
+    CHECK(sprite && sprite->hash == hash);
+    _bolt_sprite_index_free(&index);
+    _bolt_texture_free(&tex);
+    return hash;
+}
+
+static void test_hash_matches_read_back() {
+    uint8_t data[16 * 20 * 4];
+    for (size_t i = 0; i < sizeof(data); i += 1) data[i] = (uint8_t)((i * 37) ^ (i >> 3));
+    check_read_back(GL_RGBA, GL_RGBA, data, 0);
+    check_read_back(GL_RGBA, GL_RGBA, data, 20 * 4);
+    check_read_back(GL_RGBA, GL_RED, data, 0);
+    check_read_back(GL_RGBA, GL_RG, data, 19 * 2);
+    check_read_back(GL_R8, GL_RGBA, data, 0);
+    check_read_back(GL_RG8, GL_RED, data, 0);
+    check_read_back(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, data, 0);
+    check_read_back(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, data, 0);
+
+    // the same image uploaded in two different formats has the same hash
+    uint8_t red[16 * 16];
+    uint8_t rgba[16 * 16 * 4];
+    for (size_t i = 0; i < sizeof(red); i += 1) {
+        red[i] = data[i];
+        rgba[(i * 4) + 0] = data[i];
+        rgba[(i * 4) + 1] = 0;
+        rgba[(i * 4) + 2] = 0;
+        rgba[(i * 4) + 3] = 255;
+    }
+    CHECK(check_read_back(GL_RGBA, GL_RED, red, 0) == check_read_back(GL_RGBA, GL_RGBA, rgba, 0));
+}
+
+// 0 marks empty slots, so it can't be a key, even once the map has something in it
+static void test_map_zero_key() {
+    struct BoltSpriteMap map = {0};
+    CHECK(_bolt_sprite_map_get(&map, 0) == SPRITE_NONE);
+    CHECK(!_bolt_sprite_map_put(&map, 0, 5));
+    CHECK(_bolt_sprite_map_put(&map, 7, 3));
+    CHECK(_bolt_sprite_map_get(&map, 0) == SPRITE_NONE);
+    CHECK(!_bolt_sprite_map_put(&map, 0, 5));
+    CHECK(_bolt_sprite_map_get(&map, 7) == 3 && map.count == 1);
+    free(map.slots);
+}
+
+int main() {
+    test_contents_released();
+    test_invalidate();
+    test_hash_matches_read_back();
+    test_map_zero_key();
+    return TEST_RESULT();
+}
@@ -0,0 +1,26 @@
+#ifndef _BOLT_TESTS_TEST_H_
+#define _BOLT_TESTS_TEST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// every test is one executable that returns nonzero if any CHECK failed
+__attribute__((unused)) static int test_failures = 0;
+#define CHECK(X) do { if (!(X)) { printf("%s:%i: check failed: %s\n", __FILE__, __LINE__, #X); test_failures += 1; } } while (0)
+#define TEST_RESULT() (printf("%i failures\n", test_failures), test_failures != 0)
+
+static inline uint64_t test_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+// small deterministic PRNG, so that failures can be reproduced
+static uint64_t test_rng_state = 0x853C49E6748FEA9BULL;
+static inline uint32_t test_rand() {
+    test_rng_state = (test_rng_state * 6364136223846793005ULL) + 1442695040888963407ULL;
+    return (uint32_t)(test_rng_state >> 33);
+}
+
+#endif
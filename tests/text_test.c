@@ -0,0 +1,290 @@
+#include "capture.h"
+#include "gl.h"
+#include "sprite.h"
+#include "text.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// a font atlas with one glyph per 16x16 cell, each a different width, and a texture of same-size icons
+#define FONT 7
+#define ICONS 9
+#define ATLAS_W 256
+#define ATLAS_H 16
+#define GLYPH_H 12
+#define WORD_GAP 6.0f // more than TEXT_SPACE_RATIO of GLYPH_H
+#define FFFD "\xEF\xBF\xBD"
+
+static uint8_t atlas[ATLAS_W * ATLAS_H * 4];
+
+static unsigned int glyph_width(unsigned int g) {
+    return 5 + (g % 4);
+}
+
+static uint64_t glyph_hash(unsigned int g) {
+    return _bolt_sprite_hash_pixels(atlas + ((size_t)g * 16 * 4), glyph_width(g), GLYPH_H, ATLAS_W * 4);
+}
+
+// the whole atlas is uploaded at once, so the engine has to read glyphs back. glyphs 'a' to 'h' are in the glyph
+// table, and 'i' and 'j' aren't until test_glyph_table puts them there.
+static struct GLShareGroup* make_group() {
+    struct GLShareGroup* group = _bolt_create_context((void*)1, NULL)->share_group;
+    group->sprites = calloc(1, sizeof(*group->sprites));
+    for (size_t i = 0; i < sizeof(atlas); i += 1) atlas[i] = (uint8_t)((i * 2654435761u) >> 13);
+    struct GLTexture2D* font = _bolt_get_texture(&group->textures, FONT);
+    _bolt_texture_storage(font, GL_RGBA, ATLAS_W, ATLAS_H);
+    font->generation = 1;
+    _bolt_texture_upload(font, GL_RGBA, 0, 0, ATLAS_W, ATLAS_H, atlas, 0);
+    _bolt_sprite_index_upload(group->sprites, font, GL_RGBA, 0, 0, ATLAS_W, ATLAS_H, atlas, 0);
+    for (unsigned int g = 0; g < 8; g += 1) CHECK(_bolt_text_set_glyph(glyph_hash(g), 'a' + g));
+
+    struct GLTexture2D* icons = _bolt_get_texture(&group->textures, ICONS);
+    _bolt_texture_storage(icons, GL_RGBA, 64, 16);
+    icons->generation = 1;
+    _bolt_texture_upload(icons, GL_RGBA, 0, 0, 64, 16, atlas, ATLAS_W * 4);
+    return group;
+}
+
+static void alloc_list(struct BoltRenderList* list, uint32_t capacity) {
+    memset(list, 0, sizeof(*list));
+    list->capacity = capacity;
+    list->key = calloc(capacity, sizeof(*list->key));
+    list->texture = calloc(capacity, sizeof(*list->texture));
+    list->colour = calloc(capacity, sizeof(*list->colour));
+    float** floats[] = {&list->screen_x, &list->screen_y, &list->screen_w, &list->screen_h, &list->atlas_x, &list->atlas_y, &list->atlas_w, &list->atlas_h};
+    for (size_t i = 0; i < sizeof(floats) / sizeof(*floats); i += 1) *floats[i] = calloc(capacity, sizeof(float));
+}
+
+static void free_list(struct BoltRenderList* list) {
+    float* floats[] = {list->screen_x, list->screen_y, list->screen_w, list->screen_h, list->atlas_x, list->atlas_y, list->atlas_w, list->atlas_h};
+    for (size_t i = 0; i < sizeof(floats) / sizeof(*floats); i += 1) free(floats[i]);
+    free(list->texture);
+    free(list->colour);
+    free(list->key);
+    memset(list, 0, sizeof(*list));
+}
+
+static void put(struct BoltRenderList* list, unsigned int texture, float atlas_x, float atlas_w, float atlas_h, float x, float y, float w, float h) {
+    const uint32_t i = list->count++;
+    list->texture[i] = texture;
+    list->colour[i] = 0xFFFFFFFF;
+    list->atlas_x[i] = atlas_x;
+    list->atlas_y[i] = 0.0f;
+    list->atlas_w[i] = atlas_w;
+    list->atlas_h[i] = atlas_h;
+    list->screen_x[i] = x;
+    list->screen_y[i] = y;
+    list->screen_w[i] = w;
+    list->screen_h[i] = h;
+    list->key[i] = ((uint64_t)texture * 1000003u) ^ ((uint64_t)(atlas_x * 1000.0f) * 13u);
+}
+
+// draws a string of glyphs 'a', 'b', ... one pixel apart, with a wider gap for each space
+static void text(struct BoltRenderList* list, unsigned int texture, const char* s, float x, float y) {
+    for (; *s; s += 1) {
+        if (*s == ' ') {
+            x += WORD_GAP - 1.0f;
+            continue;
+        }
+        const unsigned int g = (unsigned int)(*s - 'a');
+        const float w = (float)glyph_width(g);
+        put(list, texture, (g * 16.0f) / ATLAS_W, w / ATLAS_W, (float)GLYPH_H / ATLAS_H, x, y, w, GLYPH_H);
+        x += w + 1.0f;
+    }
+}
+
+static void icons(struct BoltRenderList* list, unsigned int count, float x, float y) {
+    for (unsigned int i = 0; i < count; i += 1) put(list, ICONS, i * 0.25f, 0.25f, 1.0f, x + (i * 18.0f), y, 16.0f, 16.0f);
+}
+
+static const char* line_text(const struct BoltTextFrame* frame, uint32_t line) {
+    return line < frame->line_count ? frame->text + frame->lines[line].text : "";
+}
+
+// a row of same-size icons is never a font, however long, but a run of different-width glyphs is, and after that
+// every run from the same texture is text. nothing drawn without a texture (0) is ever text.
+static void test_font_detection() {
+    struct GLShareGroup* group = make_group();
+    struct BoltTextEngine engine = {0};
+    struct BoltRenderList list;
+    alloc_list(&list, 64);
+    text(&list, 0, "abcdefg", 0.0f, 80.0f);
+    icons(&list, 4, 0.0f, 0.0f);
+    text(&list, FONT, "abc", 0.0f, 40.0f);
+    const struct BoltTextFrame* frame = _bolt_text_update(&engine, group, &list, NULL, 1);
+    // three glyphs isn't enough to tell
+    CHECK(frame->line_count == 0);
+
+    text(&list, FONT, "abcd", 0.0f, 60.0f);
+    frame = _bolt_text_update(&engine, group, &list, NULL, 1);
+    CHECK(frame->line_count == 1);
+    CHECK(frame->lines[0].texture == FONT && frame->lines[0].glyph_count == 4 && frame->lines[0].y == 60.0f);
+    CHECK(strcmp(line_text(frame, 0), "abcd") == 0);
+    CHECK(frame->glyphs[frame->lines[0].first_glyph].hash == glyph_hash(0));
+
+    list.count = 0;
+    text(&list, 0, "abcdefg", 0.0f, 80.0f);
+    icons(&list, 8, 0.0f, 0.0f);
+    text(&list, FONT, "ab", 0.0f, 40.0f);
+    text(&list, 0, "hgfedcba", 0.0f, 100.0f);
+    frame = _bolt_text_update(&engine, group, &list, NULL, 1);
+    CHECK(frame->line_count == 1);
+    CHECK(frame->lines[0].texture == FONT && strcmp(line_text(frame, 0), "ab") == 0);
+    CHECK(_bolt_sprite_map_get(&engine.fonts, ICONS) == SPRITE_NONE);
+    CHECK(engine.fonts.count == 1);
+
+    free_list(&list);
+    _bolt_text_engine_free(&engine);
+}
+
+static void test_spaces() {
+    struct GLShareGroup* group = make_group();
+    struct BoltTextEngine engine = {0};
+    struct BoltRenderList list;
+    alloc_list(&list, 64);
+    text(&list, FONT, "abc de  fgh", 10.0f, 20.0f);
+    const struct BoltTextFrame* frame = _bolt_text_update(&engine, group, &list, NULL, 1);
+    CHECK(frame->line_count == 1);
+    // however wide the gap is, it's one space
+    CHECK(strcmp(line_text(frame, 0), "abc de fgh") == 0);
+    CHECK(frame->lines[0].glyph_count == 8 && frame->lines[0].x == 10.0f && frame->lines[0].h == GLYPH_H);
+    const struct BoltTextGlyph* d = &frame->glyphs[frame->lines[0].first_glyph + 3];
+    CHECK(d->codepoint == 'd' && d->x == 5.0f + 1.0f + 6.0f + 1.0f + 7.0f + WORD_GAP && d->y == 0.0f);
+    free_list(&list);
+    _bolt_text_engine_free(&engine);
+}
+
+// lines that were drawn last frame, even somewhere else, are copied rather than looked up again, and a frame with
+// nothing in its delta is the last frame's text
+static void test_moved_lines() {
+    struct GLShareGroup* group = make_group();
+    struct BoltTextEngine engine = {0};
+    struct BoltRenderList lists[2];
+    alloc_list(&lists[0], 64);
+    alloc_list(&lists[1], 64);
+    struct BoltRenderDelta delta = {0};
+
+    text(&lists[0], FONT, "abcd", 0.0f, 0.0f);
+    text(&lists[0], FONT, "efgh", 0.0f, 40.0f);
+    const struct BoltTextFrame* frame = _bolt_text_update(&engine, group, &lists[0], NULL, 1);
+    CHECK(frame->line_count == 2 && frame->reused == 0);
+
+    text(&lists[1], FONT, "abcd", 30.0f, 100.0f);
+    text(&lists[1], FONT, "efgh", 0.0f, 40.0f);
+    CHECK(_bolt_render_list_diff(&lists[0], &lists[1], &delta));
+    CHECK(delta.moved_count == 4 && delta.unchanged_count == 4);
+    frame = _bolt_text_update(&engine, group, &lists[1], &delta, 1);
+    CHECK(frame->changed && frame->line_count == 2 && frame->reused == 2);
+    CHECK(strcmp(line_text(frame, 0), "abcd") == 0 && strcmp(line_text(frame, 1), "efgh") == 0);
+    CHECK(frame->lines[0].x == 30.0f && frame->lines[0].y == 100.0f && frame->lines[1].y == 40.0f);
+    CHECK(frame->glyphs[frame->lines[0].first_glyph + 1].hash == glyph_hash(1));
+
+    CHECK(_bolt_render_list_diff(&lists[1], &lists[1], &delta));
+    const struct BoltTextFrame* same = _bolt_text_update(&engine, group, &lists[1], &delta, 1);
+    CHECK(same == frame && !same->changed && same->reused == 2);
+
+    // one line changes, so only that one is looked up
+    lists[0].count = 0;
+    text(&lists[0], FONT, "abcd", 30.0f, 100.0f);
+    text(&lists[0], FONT, "efhg", 0.0f, 40.0f);
+    CHECK(_bolt_render_list_diff(&lists[1], &lists[0], &delta));
+    frame = _bolt_text_update(&engine, group, &lists[0], &delta, 1);
+    CHECK(frame->line_count == 2 && frame->reused == 1);
+    CHECK(strcmp(line_text(frame, 0), "abcd") == 0 && strcmp(line_text(frame, 1), "efhg") == 0);
+
+    // nothing is reused across the textures set being toggled, since the atlas could have changed in between
+    CHECK(_bolt_render_list_diff(&lists[0], &lists[0], &delta));
+    frame = _bolt_text_update(&engine, group, &lists[0], &delta, 3);
+    CHECK(frame->changed && frame->reused == 0 && frame->line_count == 2);
+    CHECK(strcmp(line_text(frame, 0), FFFD FFFD FFFD FFFD) == 0);
+
+    _bolt_render_delta_free(&delta);
+    free_list(&lists[0]);
+    free_list(&lists[1]);
+    _bolt_text_engine_free(&engine);
+}
+
+// glyphs that aren't in the table come out as U+FFFD until they are, and putting them there changes lines that were
+// cached before it did
+static void test_glyph_table() {
+    struct GLShareGroup* group = make_group();
+    struct BoltTextEngine engine = {0};
+    struct BoltRenderList list;
+    alloc_list(&list, 64);
+    struct BoltRenderDelta delta = {0};
+    text(&list, FONT, "ijab", 0.0f, 0.0f);
+    const struct BoltTextFrame* frame = _bolt_text_update(&engine, group, &list, NULL, 1);
+    CHECK(strcmp(line_text(frame, 0), FFFD FFFD "ab") == 0);
+    CHECK(frame->line_count == 1 && frame->glyphs[0].hash == glyph_hash(8) && frame->glyphs[0].codepoint == 0);
+
+    CHECK(_bolt_text_get_glyph(glyph_hash(8)) == 0);
+    CHECK(_bolt_text_set_glyph(glyph_hash(8), 'i') && _bolt_text_set_glyph(glyph_hash(9), 'j'));
+    CHECK(_bolt_text_get_glyph(glyph_hash(8)) == 'i');
+    CHECK(!_bolt_text_set_glyph(0, 'x') && !_bolt_text_set_glyph(glyph_hash(8), 0));
+    CHECK(_bolt_render_list_diff(&list, &list, &delta));
+    frame = _bolt_text_update(&engine, group, &list, &delta, 1);
+    CHECK(frame->changed && frame->reused == 0);
+    CHECK(strcmp(line_text(frame, 0), "ijab") == 0);
+
+    // and anything outside ASCII is encoded as UTF-8
+    CHECK(_bolt_text_set_glyph(glyph_hash(9), 0x20AC));
+    frame = _bolt_text_update(&engine, group, &list, &delta, 1);
+    CHECK(strcmp(line_text(frame, 0), "i\xE2\x82\xAC" "ab") == 0);
+    CHECK(_bolt_text_set_glyph(glyph_hash(9), 'j'));
+
+    _bolt_render_delta_free(&delta);
+    free_list(&list);
+    _bolt_text_engine_free(&engine);
+}
+
+// a line whose atlas has been written to since it was cached is looked up again, even if it was drawn the same way
+static void test_atlas_invalidation() {
+    struct GLShareGroup* group = make_group();
+    struct BoltTextEngine engine = {0};
+    struct BoltRenderList list;
+    alloc_list(&list, 64);
+    struct BoltRenderDelta delta = {0};
+    text(&list, FONT, "abcd", 0.0f, 0.0f);
+    text(&list, FONT, "efgh", 0.0f, 40.0f);
+    const struct BoltTextFrame* frame = _bolt_text_update(&engine, group, &list, NULL, 1);
+    CHECK(frame->line_count == 2);
+    CHECK(_bolt_render_list_diff(&list, &list, &delta));
+
+    // e.g. rendered to, so the index can't say what's there now, and every glyph has to be read back again
+    _bolt_sprite_index_invalidate(group->sprites, FONT, 0, 0, 16, 16);
+    frame = _bolt_text_update(&engine, group, &list, &delta, 1);
+    CHECK(frame->changed && frame->reused == 0);
+    CHECK(strcmp(line_text(frame, 0), "abcd") == 0 && strcmp(line_text(frame, 1), "efgh") == 0);
+    frame = _bolt_text_update(&engine, group, &list, &delta, 1);
+    CHECK(!frame->changed);
+
+    // a new glyph uploaded over 'a', which is found in the index rather than read back
+    uint8_t z[5 * GLYPH_H * 4];
+    for (size_t i = 0; i < sizeof(z); i += 1) z[i] = (uint8_t)(i * 7);
+    const uint64_t z_hash = _bolt_sprite_hash_pixels(z, 5, GLYPH_H, 5 * 4);
+    CHECK(_bolt_text_set_glyph(z_hash, 'z'));
+    // so that it's only the upload that stops the next frame from being reused
+    _bolt_text_update(&engine, group, &list, &delta, 1);
+    struct GLTexture2D* font = _bolt_find_texture(&group->textures, FONT);
+    _bolt_texture_upload(font, GL_RGBA, 0, 0, 5, GLYPH_H, z, 0);
+    _bolt_sprite_index_upload(group->sprites, font, GL_RGBA, 0, 0, 5, GLYPH_H, z, 0);
+    CHECK(_bolt_sprite_at(group->sprites, FONT, 0, 0, 5, GLYPH_H) != NULL);
+    frame = _bolt_text_update(&engine, group, &list, &delta, 1);
+    CHECK(frame->changed && frame->reused == 0);
+    CHECK(strcmp(line_text(frame, 0), "zbcd") == 0 && strcmp(line_text(frame, 1), "efgh") == 0);
+    CHECK(frame->glyphs[frame->lines[0].first_glyph].hash == z_hash);
+
+    _bolt_render_delta_free(&delta);
+    free_list(&list);
+    _bolt_text_engine_free(&engine);
+}
+
+int main() {
+    test_font_detection();
+    test_spaces();
+    test_moved_lines();
+    test_glyph_table();
+    test_atlas_invalidation();
+    return TEST_RESULT();
+}